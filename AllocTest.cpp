@@ -0,0 +1,383 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <array>
+#include <string>
+#include "BaseCom.hpp"
+#include "Framing.hpp"
+#include "Dispatcher.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Checks that the steady state serialize and unserialize paths don't allocate memory.
+ *
+ * The global operator new, including the aligned overloads, and on glibc also malloc, calloc and realloc are replaced by counting versions. Every case runs a few warm up
+ * iterations and then counts the allocations of the measured iterations. The test fails if a case allocates that isn't documented as
+ * allocating, these are the std::string fields and the std::vector overloads of Serialize (USE_MEMALLOC).
+ */
+
+static std::atomic<bool> countingEnabled(false);
+static std::atomic<size_t> allocationCount(0);
+
+static void CountAllocation()
+{
+    if (countingEnabled.load(std::memory_order_relaxed))
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define COUNT_MALLOC
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *pointer, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void *pointer);
+
+    void *malloc(size_t size)
+    {
+        CountAllocation();
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        CountAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *pointer, size_t size)
+    {
+        CountAllocation();
+        return __libc_realloc(pointer, size);
+    }
+}
+#endif
+
+static void *Allocate(size_t size)
+{
+    CountAllocation();
+#ifdef COUNT_MALLOC
+    return __libc_malloc(size > 0 ? size : 1); // Bypass the counting malloc to count the allocation only once
+#else
+    return std::malloc(size > 0 ? size : 1);
+#endif
+}
+
+static void *AllocateAligned(size_t size, std::align_val_t alignment)
+{
+    CountAllocation();
+    const size_t align = static_cast<size_t>(alignment);
+#if defined(COUNT_MALLOC)
+    return __libc_memalign(align, size > 0 ? size : 1);
+#elif defined(_MSC_VER)
+    return _aligned_malloc(size > 0 ? size : 1, align);
+#else
+    // aligned_alloc needs a size that is a multiple of the alignment
+    return std::aligned_alloc(align, (size + align) & ~(align - 1));
+#endif
+}
+
+static void Release(void *pointer)
+{
+#ifdef COUNT_MALLOC
+    __libc_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+static void ReleaseAligned(void *pointer)
+{
+#ifdef _MSC_VER
+    _aligned_free(pointer);
+#else
+    Release(pointer);
+#endif
+}
+
+void *operator new(size_t size)
+{
+    void *pointer = Allocate(size);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    void *pointer = AllocateAligned(size, alignment);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return AllocateAligned(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return AllocateAligned(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    Release(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    Release(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    Release(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+    Release(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    ReleaseAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept
+{
+    ReleaseAligned(pointer);
+}
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept
+{
+    ReleaseAligned(pointer);
+}
+
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept
+{
+    ReleaseAligned(pointer);
+}
+
+static const size_t WARMUP_ITERATIONS = 16;
+static const size_t ITERATIONS = 1000;
+
+/**
+ * @brief Run the operation and count the allocations.
+ *
+ * @param name
+ * @param allocating - The path is documented as allocating, the allocations are only reported.
+ * @param operation
+ * @return true if the check passed.
+ */
+template <typename Operation>
+static bool Check(const char *name, bool allocating, Operation &&operation)
+{
+    for (size_t i = 0; i < WARMUP_ITERATIONS; i++)
+    {
+        operation();
+    }
+    allocationCount.store(0);
+    countingEnabled.store(true);
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        operation();
+    }
+    countingEnabled.store(false);
+    const size_t count = allocationCount.load();
+    const bool passed = allocating || count == 0;
+    printf("%-32s %8zu allocations in %zu iterations%s%s\n", name, count, ITERATIONS, allocating ? " (documented as allocating)" : "",
+           passed ? "" : " FAILED");
+    return passed;
+}
+
+/**
+ * @brief Serialize and unserialize the packet in a loop.
+ */
+template <typename Packet>
+static bool CheckPacket(const char *name, Packet &packet, bool allocating = false)
+{
+    std::array<uint8_t, 512> buffer;
+    bool passed = true;
+    size_t length = 0;
+    string serializeName = string(name) + "/serialize";
+    string unserializeName = string(name) + "/unserialize";
+    passed &= Check(serializeName.c_str(), allocating, [&]()
+    {
+        length = packet.Serialize(buffer);
+    });
+    passed &= Check(unserializeName.c_str(), allocating, [&]()
+    {
+        auto [match, data, remaining] = packet.CheckIDMatch(buffer.data(), length);
+        auto [readbytes, valid] = Packet::PacketBase::Unserialize(data, remaining, packet);
+        if (!match || !valid || readbytes != remaining)
+        {
+            printf("%s: unserialize failed\n", name);
+        }
+    });
+    return passed;
+}
+
+struct ArithmeticPacket : public TagedComPacket<2, uint8_t, int16_t, uint32_t, int64_t, float, double>
+{
+    ArithmeticPacket() : TagedComPacket({0x02, 0x00})
+    {
+    }
+
+    uint8_t &Byte = get<0>(elements);
+    double &Value = get<5>(elements);
+};
+
+struct ArrayPacket : public TagedComPacket<2, std::array<uint16_t, 32>, std::array<double, 4>>
+{
+    ArrayPacket() : TagedComPacket({0x02, 0x01})
+    {
+    }
+
+    std::array<uint16_t, 32> &Samples = get<0>(elements);
+};
+
+struct BitfieldPacket : public TagedComPacket<2, Bitfield<3>, Bitfield<37>, uint8_t>
+{
+    BitfieldPacket() : TagedComPacket({0x02, 0x02})
+    {
+    }
+
+    Bitfield<37> &Flags = get<1>(elements);
+};
+
+#ifdef USE_ETL
+struct EtlStringPacket : public TagedComPacket<2, uint16_t, etl::string<40>>
+{
+    EtlStringPacket() : TagedComPacket({0x02, 0x03})
+    {
+    }
+
+    etl::string<40> &Text = get<1>(elements);
+};
+#endif
+
+struct StdStringPacket : public TagedComPacket<2, uint16_t, std::string>
+{
+    StdStringPacket() : TagedComPacket({0x02, 0x04})
+    {
+    }
+
+    std::string &Text = get<1>(elements);
+};
+
+int main(void)
+{
+    bool passed = true;
+
+    // The replaced allocation functions must see the allocations, otherwise every check would pass
+    allocationCount.store(0);
+    countingEnabled.store(true);
+    operator delete(operator new(16));
+    operator delete(operator new(16, std::align_val_t(CACHE_LINE_SIZE)), std::align_val_t(CACHE_LINE_SIZE));
+    countingEnabled.store(false);
+    if (allocationCount.load() != 2)
+    {
+        printf("The allocation counter doesn't work\n");
+        return 1;
+    }
+
+    ArithmeticPacket arithmetic;
+    arithmetic.Value = 3.5;
+    passed &= CheckPacket("arithmetic", arithmetic);
+
+    ArrayPacket arrays;
+    arrays.Samples.fill(0x1234);
+    passed &= CheckPacket("array", arrays);
+
+    BitfieldPacket bitfields;
+    bitfields.Flags.WriteData(32, 5, static_cast<uint8_t>(0x15));
+    passed &= CheckPacket("bitfield", bitfields);
+
+#ifdef USE_ETL
+    EtlStringPacket etlString;
+    etlString.Text = "A string that is longer than 16 bytes";
+    passed &= CheckPacket("etl_string", etlString);
+#endif
+
+    // std::string is documented as allocating, short strings usually fit into the small string buffer
+    StdStringPacket stdString;
+    stdString.Text = "A string that is longer than 16 bytes";
+    passed &= CheckPacket("std_string", stdString, true);
+
+    // Receive path with framing and dispatching
+    std::array<uint8_t, 256> stream;
+    std::array<uint8_t, 256> serialized;
+    size_t streamLength = framing::WriteFrame(stream.data(), stream.size(), serialized.data(), arrays.Serialize(serialized));
+    streamLength += framing::WriteFrame(&stream[streamLength], stream.size() - streamLength, serialized.data(), bitfields.Serialize(serialized));
+    StreamDeframer<256> deframer;
+    PacketDispatcher<ArrayPacket, BitfieldPacket> dispatcher;
+    size_t dispatched = 0;
+    passed &= Check("deframe_dispatch", false, [&]()
+    {
+        deframer.Push(stream.data(), streamLength, [&](const uint8_t *payload, size_t length)
+        {
+            dispatcher.Dispatch(payload, length, [&](auto &) { dispatched++; });
+        });
+    });
+    if (dispatched != 2 * (WARMUP_ITERATIONS + ITERATIONS))
+    {
+        printf("deframe_dispatch: %zu packets dispatched\n", dispatched);
+        passed = false;
+    }
+
+    // CAN segmentation and reassembly
+    CanLoopback<64> bus;
+    CanPacketTransport<CanLoopback<64>, 128> transport(bus);
+    passed &= Check("can_transport", false, [&]()
+    {
+        transport.SendPacket(arrays);
+        transport.Poll([&](uint32_t canid, const uint8_t *data, size_t length)
+        {
+            transport.Decode(canid, data, length, arrays);
+        });
+    });
+
+    PacketDeduplicator<256> deduplicator(1000);
+    uint64_t now = 0;
+    passed &= Check("deduplicator", false, [&]()
+    {
+        deduplicator.IsFirst(serialized.data(), 16, now++);
+    });
+
+    printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -1,6 +1,15 @@
 #include <iostream>
 #include "BaseCom.hpp"
+#include "CaptureReplay.hpp"
 #include <array>
+#include <cstring>
+#include <type_traits>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <limits>
+#include <cmath>
 
 using namespace std;
 using namespace translib;
@@ -34,6 +43,7 @@ struct LargeBitField : public Bitfield<70> // Should always allocate at least tw
     static const size_t TestBit1_Length = 5;
     static const size_t TestBit2_Offset = 13;
     static const size_t TestBit2_Length = 3;
+    static constexpr std::array<BitfieldMember, 2> Members = {{{"TestBit1", TestBit1_Offset, TestBit1_Length}, {"TestBit2", TestBit2_Offset, TestBit2_Length}}};
 
     uint8_t ReadTestBit1()
     {
@@ -54,6 +64,7 @@ struct LargeBitField : public Bitfield<70> // Should always allocate at least tw
     }
 };
 
+#ifdef USE_ETL
 struct MixedDataMessage : public ComPacket<int32_t, etl::string<10>, TestBitfield, LargeBitField, std::array<uint8_t, 10>>
 {
     int &Testfield1 = get<0>(elements);
@@ -62,6 +73,1177 @@ struct MixedDataMessage : public ComPacket<int32_t, etl::string<10>, TestBitfiel
     LargeBitField &Testfield4 = get<3>(elements);
     std::array<uint8_t, 10> &TestArray = get<4>(elements);
 };
+#endif
+
+// The same fields with std::string, so the round trip is also tested without the ETL
+struct StdMixedDataMessage : public ComPacket<int32_t, std::string, TestBitfield, LargeBitField, std::array<uint8_t, 10>>
+{
+    int &Testfield1 = get<0>(elements);
+    std::string &Testfield2 = get<1>(elements);
+    TestBitfield &Testfield3 = get<2>(elements);
+    LargeBitField &Testfield4 = get<3>(elements);
+    std::array<uint8_t, 10> &TestArray = get<4>(elements);
+};
+
+static void TestStdStringRoundTrip()
+{
+    StdMixedDataMessage mixed;
+    mixed.Testfield1 = -10;
+    const std::string teststring("HELLO WORLD");
+    mixed.Testfield2 = teststring;
+    mixed.Testfield3.WriteTestBit(1);
+    mixed.TestArray.fill(5);
+
+    std::array<uint8_t, 2> id = {2, 3};
+    std::array<uint8_t, 64> dataarray;
+    const size_t packageLength = mixed.Serialize(dataarray, id);
+    assert(packageLength == (sizeof(int) + (teststring.size() + 1) + TestBitfield::BYTE_LENGTH + LargeBitField::BYTE_LENGTH + sizeof(id) + mixed.TestArray.size() * sizeof(uint8_t)));
+
+    StdMixedDataMessage deserializeTest;
+    size_t usedData;
+    auto [valid, packetStart, datalength] = StdMixedDataMessage::CheckIDMatch(dataarray, packageLength, id);
+    assert(valid);
+
+    std::array<uint8_t, 64>::const_iterator it;
+    std::tie(usedData, valid, it) = deserializeTest.Unserialize<dataarray.max_size()>(packetStart, dataarray.end(), datalength);
+    assert(valid && usedData == packageLength - sizeof(id));
+    assert(deserializeTest.Testfield1 == -10);
+    assert(deserializeTest.Testfield2 == teststring);
+    assert(deserializeTest.Testfield3.ReadTestBit() == 1);
+    for (const auto &d : deserializeTest.TestArray)
+    {
+        assert(d == 5);
+    }
+
+    std::array<uint8_t, 6> falseData = {10, 10, 20, 20, 30, 30};
+    decltype(falseData.cbegin()) falseIterator;
+    std::tie(usedData, valid, falseIterator) = StdMixedDataMessage::Unserialize<falseData.max_size()>(falseData, falseData.max_size(), deserializeTest);
+    assert(!valid && deserializeTest.Testfield2 == teststring);
+}
+
+struct PingResponse : public TagedComPacket<2, uint32_t>
+{
+    PingResponse() : TagedComPacket({0x10, 0x02})
+    {
+    }
+
+    uint32_t &Value = get<0>(elements);
+};
+
+struct PingCommand : public TagedComPacket<2, uint32_t>
+{
+    using ResponseType = PingResponse;
+
+    PingCommand() : TagedComPacket({0x10, 0x01})
+    {
+    }
+
+    uint32_t &Value = get<0>(elements);
+};
+
+using ResetCommandFields = TagedComPacket<2, uint8_t, uint16_t, LargeBitField, std::array<int16_t, 3>, uint32_t>;
+
+static constexpr LargeBitField MakeResetFlags()
+{
+    LargeBitField flags;
+    flags.WriteData(LargeBitField::TestBit2_Offset, LargeBitField::TestBit2_Length, static_cast<uint8_t>(5));
+    return flags;
+}
+
+static constexpr ResetCommandFields ResetCommandValues({0x20, 0x01}, 7, 0x1234, MakeResetFlags(), {-1, 2, -3}, 0);
+static constexpr PacketTemplate ResetCommand(ResetCommandValues);
+static_assert(ResetCommand.GetBytes()[0] == 0x20 && ResetCommand.GetBytes()[2] == 7, "The template must be serialized at compile time");
+static_assert(ResetCommand.GetFieldOffset<4>() == 2 + 1 + 2 + LargeBitField::BYTE_LENGTH + 3 * sizeof(int16_t));
+
+static void TestPacketTemplate()
+{
+    std::array<uint8_t, ResetCommand.Length> templateBuffer;
+    const size_t templateLength = ResetCommand.Emit(templateBuffer);
+    assert(templateLength == ResetCommand.Length);
+    ResetCommand.Patch<4>(templateBuffer, 0xdeadbeef);
+
+    ResetCommandFields runtimePacket({0x20, 0x01}, 7, 0x1234, MakeResetFlags(), {-1, 2, -3}, 0xdeadbeef);
+    std::array<uint8_t, ResetCommandFields::GetMaxSize()> runtimeBuffer;
+    const size_t runtimeLength = runtimePacket.Serialize(runtimeBuffer);
+    assert(runtimeLength == runtimeBuffer.size());
+    assert(templateBuffer == runtimeBuffer);
+}
+
+struct CanStatusPacket : public TagedComPacket<2, uint8_t, std::array<uint16_t, 20>>
+{
+    CanStatusPacket() : TagedComPacket({0x01, 0x23})
+    {
+    }
+
+    uint8_t &Mode = get<0>(elements);
+    std::array<uint16_t, 20> &Values = get<1>(elements);
+};
+
+static void TestCanTransport()
+{
+    CanLoopback<64> bus;
+    CanPacketTransport<CanLoopback<64>, 64> transport(bus);
+    CanStatusPacket status;
+    status.Mode = 3;
+    for (size_t i = 0; i < status.Values.size(); i++)
+    {
+        status.Values[i] = static_cast<uint16_t>(i * 1000);
+    }
+    const bool statusSent = transport.SendPacket(status);
+    const bool pingSent = transport.SendPacket(PingResponse());
+    assert(statusSent && pingSent);
+
+    CanStatusPacket received;
+    size_t packets = 0;
+    transport.Poll([&](uint32_t canid, const uint8_t *data, size_t length)
+    {
+        if (packets == 0)
+        {
+            assert(canid == 0x123 && length == CanStatusPacket::PacketBase::GetMaxSize());
+            const bool decoded = transport.Decode(canid, data, length, received);
+            assert(decoded);
+        }
+        else
+        {
+            assert(canid == 0x1002 + CanFrame::ExtendedFlag && length == sizeof(uint32_t));
+        }
+        packets++;
+    });
+    assert(packets == 2 && transport.GetErrorCount() == 0);
+    assert(received.Mode == 3 && received.Values == status.Values);
+
+    // A lost consecutive frame drops the packet
+    std::array<CanFrame, 8> frames;
+    std::array<uint8_t, 20> payload = {};
+    const size_t count = IsoTpSegmenter<8>::Segment(0x10, payload.data(), payload.size(), frames.data(), frames.size());
+    assert(count == 3);
+    IsoTpReassembler<64, 2> reassembler;
+    const uint8_t *data;
+    size_t length;
+    const bool firstComplete = reassembler.Push(frames[0], data, length);
+    const bool lastComplete = reassembler.Push(frames[2], data, length);
+    assert(!firstComplete && !lastComplete && reassembler.GetErrorCount() == 1);
+}
+
+static void TestFraming()
+{
+    PingCommand ping;
+    ping.Value = 0x1234;
+    std::array<uint8_t, 32> serialized;
+    const size_t length = ping.Serialize(serialized);
+
+    // A corrupted frame between two valid frames, pushed in small chunks
+    std::array<uint8_t, 128> stream;
+    size_t fill = framing::WriteFrame(stream.data(), stream.size(), serialized.data(), length);
+    const size_t corrupted = fill;
+    fill += framing::WriteFrame(&stream[fill], stream.size() - fill, serialized.data(), length);
+    stream[corrupted + framing::HEADER_LENGTH] ^= 0x01;
+    stream[fill++] = framing::SYNC0; // Garbage byte
+    fill += framing::WriteFrame(&stream[fill], stream.size() - fill, serialized.data(), length);
+
+    StreamDeframer<64> deframer;
+    size_t frames = 0;
+    for (size_t i = 0; i < fill; i += 3)
+    {
+        deframer.Push(&stream[i], std::min<size_t>(3, fill - i), [&](const uint8_t *payload, size_t payloadLength)
+        {
+            assert(payloadLength == length && memcmp(payload, serialized.data(), length) == 0);
+            frames++;
+        });
+    }
+    assert(frames == 2 && deframer.GetFrameCount() == 2 && deframer.GetErrorCount() == 1);
+}
+
+static void TestDispatcher()
+{
+    PacketDispatcher<PingCommand, PingResponse, CanStatusPacket> dispatcher;
+    std::array<uint8_t, 64> buffer;
+    CanStatusPacket status;
+    status.Mode = 7;
+    size_t length = status.Serialize(buffer);
+    size_t handled = 0;
+    assert(dispatcher.Lookup(buffer.data(), length) == 2);
+    const bool dispatched = dispatcher.Dispatch(buffer, length, [&](auto &packet)
+    {
+        using Packet = std::decay_t<decltype(packet)>;
+        assert((std::is_same<Packet, CanStatusPacket>::value));
+        handled++;
+    });
+    assert(dispatched && handled == 1 && dispatcher.Get<CanStatusPacket>().Mode == 7);
+
+    buffer[0] ^= 0xFF;
+    const bool unknownDispatched = dispatcher.Dispatch(buffer, length, [&](auto &) { handled++; });
+    const bool shortDispatched = dispatcher.Dispatch(buffer.data(), 1, [&](auto &) { handled++; });
+    assert(!unknownDispatched && !shortDispatched);
+    assert(handled == 1 && dispatcher.GetUnknownCount() == 2);
+}
+
+struct CountedTag
+{
+    static constexpr const char *Name = "counted";
+};
+
+struct CountedPacket : public BasicTagedComPacket<CountingInstrumentation<CountedTag>, 2, uint32_t, uint16_t>
+{
+    CountedPacket() : BasicTagedComPacket({0x05, 0x01})
+    {
+    }
+
+    uint32_t &Value = get<0>(elements);
+};
+
+static size_t PlainSerializedLength(const ComPacket<uint8_t, uint16_t> &packet)
+{
+    return packet.GetSerializedLength();
+}
+
+static void TestInstrumentation()
+{
+    static_assert(std::is_base_of_v<ComPacket<uint8_t, uint16_t>, TagedComPacket<2, uint8_t, uint16_t>>, "A tagged packet must be a ComPacket");
+    TagedComPacket<2, uint8_t, uint16_t> tagged({0x05, 0x02});
+    const size_t plainLength = PlainSerializedLength(tagged);
+    assert(plainLength == 3);
+    const uint8_t plainData[] = {0x07, 0x08, 0x09};
+    const auto plainResult = ComPacket<uint8_t, uint16_t>::Unserialize(plainData, sizeof(plainData), tagged);
+    assert(std::get<1>(plainResult) && get<0>(tagged.GetElements()) == 0x07);
+
+    static_assert(sizeof(TagedComPacket<2, uint32_t, uint16_t>) == sizeof(BasicTagedComPacket<CountingInstrumentation<CountedTag>, 2, uint32_t, uint16_t>), "The instrumentation must not add data to the packet");
+    CountedPacket packet;
+    packet.Value = 42;
+    std::array<uint8_t, 16> buffer;
+    const size_t length = packet.Serialize(buffer);
+
+    std::thread other([&]()
+    {
+        CountedPacket received;
+        auto [match, data, remaining] = received.CheckIDMatch(buffer.data(), length);
+        const auto result = CountedPacket::PacketBase::Unserialize(data, remaining, received);
+        assert(match && std::get<1>(result) && received.Value == 42);
+    });
+    other.join();
+    auto [match, data, remaining] = packet.CheckIDMatch(buffer.data(), length);
+    const auto truncated = CountedPacket::PacketBase::Unserialize(data, 3, packet);
+    assert(match && !std::get<1>(truncated));
+    const auto mismatch = packet.CheckIDMatch(buffer.data() + 1, length - 1);
+    assert(!std::get<0>(mismatch));
+
+    const auto counters = CountedPacket::GetCounters();
+    assert(counters.packetsSerialized == 1 && counters.bytesSerialized == length - 2);
+    assert(counters.packetsDeserialized == 1 && counters.bytesDeserialized == length - 2);
+    assert(counters.invalidDecodes == 1 && counters.idMismatches == 1);
+
+    size_t found = 0;
+    instrumentation::ForEachCounters([&](const char *name, const instrumentation::PacketCounters &snapshot)
+    {
+        if (name != nullptr && strcmp(name, "counted") == 0)
+        {
+            found++;
+            assert(snapshot.packetsSerialized == 1);
+        }
+    });
+    assert(found == 1);
+}
+
+static void TestHistogram()
+{
+    using Layout = HistogramLayout<5, 40>;
+    for (uint64_t value : {uint64_t(0), uint64_t(31), uint64_t(32), uint64_t(1000), uint64_t(123456789), (uint64_t(1) << 40) - 1})
+    {
+        const size_t index = Layout::BucketIndex(value);
+        assert(Layout::LowestValue(index) <= value && value <= Layout::HighestValue(index));
+        assert(Layout::HighestValue(index) - Layout::LowestValue(index) <= value / 32);
+    }
+    assert(Layout::BucketIndex(uint64_t(1) << 50) == Layout::BucketCount - 1);
+
+    Histogram<> histogram;
+    for (uint64_t value = 1; value <= 1000; value++)
+    {
+        histogram.Record(value);
+    }
+    auto snapshot = histogram.Snapshot();
+    assert(snapshot.GetCount() == 1000 && snapshot.Mean() > 495 && snapshot.Mean() < 506 && snapshot.Min() == 1 && snapshot.Max() >= 1000);
+    assert(snapshot.Percentile(50) >= 500 && snapshot.Percentile(50) <= 516);
+    assert(snapshot.Percentile(99) >= 990 && snapshot.Percentile(99) <= 1023);
+
+    const auto earlier = snapshot;
+    histogram.Record(5000);
+    snapshot = histogram.Snapshot();
+    auto interval = snapshot;
+    interval.Subtract(earlier);
+    assert(interval.GetCount() == 1 && interval.Min() <= 5000 && interval.Max() >= 5000);
+    interval.Merge(earlier);
+    assert(interval.GetCount() == snapshot.GetCount() && interval.Percentile(100) == snapshot.Percentile(100));
+}
+
+struct TimedPacket : public BasicTagedComPacket<LatencyInstrumentation<>, 2, uint64_t, uint8_t>
+{
+    TimedPacket() : BasicTagedComPacket({0x05, 0x02})
+    {
+    }
+
+    uint64_t GetSendTime() const
+    {
+        return SendTime;
+    }
+
+    uint64_t &SendTime = get<0>(elements);
+};
+
+static void TestLatencyInstrumentation()
+{
+    TimedPacket packet;
+    packet.SendTime = instrumentation::SteadyClock::Now();
+    std::array<uint8_t, 16> buffer;
+    const size_t length = packet.Serialize(buffer);
+    PacketDispatcher<TimedPacket, PingCommand> dispatcher;
+    const bool dispatched = dispatcher.Dispatch(buffer, length, [](auto &) {});
+    const bool truncatedDispatched = dispatcher.Dispatch(buffer, length - 1, [](auto &) {});
+    assert(dispatched && !truncatedDispatched);
+
+    const auto decode = TimedPacket::GetLatencies().decode.Snapshot();
+    const auto link = TimedPacket::GetLatencies().link.Snapshot();
+    assert(decode.GetCount() == 2 && link.GetCount() == 1);
+    assert(TimedPacket::GetCounters().packetsDeserialized == 1 && TimedPacket::GetCounters().invalidDecodes == 1);
+
+    size_t found = 0;
+    instrumentation::ForEachLatencies([&](const char *, const HistogramSnapshot<> &decoded, const HistogramSnapshot<> &)
+    {
+        found += decoded.GetCount();
+    });
+    assert(found == 2);
+}
+
+static void TestLinkStatistics()
+{
+    const uint64_t second = 1000000000;
+    LinkStatistics<2, PingCommand, CanStatusPacket> statistics(second, second / 10);
+    statistics.SetCapacity(LinkDirection::Transmit, 0, 100000);
+    uint64_t now = 0;
+    for (size_t i = 0; i < 10000; i++, now += second / 1000)
+    {
+        statistics.Record<PingCommand>(LinkDirection::Transmit, 0, 20, now);
+    }
+    statistics.Record<CanStatusPacket>(LinkDirection::Transmit, 0, 200, now);
+    statistics.Record(LinkDirection::Receive, 1, statistics.PacketCount, 3, now);
+
+    const auto ping = statistics.Snapshot(LinkDirection::Transmit, 0, statistics.TypeIndex<PingCommand>(), now);
+    assert(ping.packets == 10000 && ping.bytes == 200000 && ping.minSize == 20 && ping.maxSize == 20 && ping.sizes[4] == 10000);
+    assert(ping.packetsPerSecond > 950 && ping.packetsPerSecond < 1050 && ping.bytesPerSecond > 19000 && ping.bytesPerSecond < 21000);
+    const auto channel = statistics.ChannelSnapshot(LinkDirection::Transmit, 0, now);
+    assert(channel.packets == 10001 && channel.maxSize == 200);
+    const double utilization = statistics.ChannelUtilization(LinkDirection::Transmit, 0, now);
+    assert(utilization > 0.19 && utilization < 0.21);
+
+    // Without traffic the rates decay
+    assert(statistics.Snapshot(LinkDirection::Transmit, 0, 0, now + 10 * second).packetsPerSecond < 1);
+
+    size_t active = 0;
+    statistics.ForEachActive(now, [&](LinkDirection direction, size_t channelIndex, size_t type, const LinkCounters &counters)
+    {
+        active++;
+        assert(counters.packets > 0 && (direction == LinkDirection::Transmit || (channelIndex == 1 && type == statistics.PacketCount)));
+    });
+    assert(active == 3);
+}
+
+static void TestLinkBudget()
+{
+    // 10 bits per byte on a 8N1 serial link, 6 bytes of framing per packet
+    using Downlink = LinkSchedule<StreamFraming<10>, Scheduled<PingCommand, 10>, Scheduled<CanStatusPacket, 1, 2000>>;
+    static_assert(Downlink::BitsPerSecond == (6 + 6) * 10 * 10 + (43 + 6) * 10 / 2 && Downlink::BytesPerSecond == 181);
+    static_assert(AssertLinkBudget<Downlink, 9600, 50>());
+    static_assert(Downlink::Fits(1445) && !Downlink::Fits(1444) && !Downlink::Fits(2000, 50));
+
+    // The status packet takes 7 classic CAN frames of at most 135 bits, 160 bits with extended identifiers
+    using Bus = LinkSchedule<CanFraming<>, Scheduled<PingCommand, 1000>, Scheduled<CanStatusPacket, 100>>;
+    static_assert(CanFraming<>::BitsPerFrame == 135 && CanFraming<true>::BitsPerFrame == 160);
+    static_assert(Bus::BitsPerSecond == 135000 + 7 * 135 * 100);
+    static_assert(AssertLinkBudget<Bus, 250000>() && !Bus::Fits(250000, 10));
+
+    using Strings = LinkSchedule<NoFraming, ScheduledLength<100, 3, 1000>, ScheduledLength<1, 1, 3>>;
+    static_assert(Strings::BitsPerSecond == 2400 + 2667);
+    const double utilization = Bus::Utilization(250000);
+    assert(utilization > 0.91 && utilization < 0.92);
+}
+
+struct MonitoredPacket : public TagedComPacket<2, uint32_t, std::array<int16_t, 10>, float, double>
+{
+    MonitoredPacket() : TagedComPacket({0x05, 0x01})
+    {
+    }
+
+    std::array<int16_t, 10> &Currents = get<1>(elements);
+    float &Temperature = get<2>(elements);
+};
+
+static void TestAlarmEngine()
+{
+    using Layout = NumericLayout<MonitoredPacket>;
+    static_assert(Layout::ValueCount == 13 && Layout::FieldOffset(2) == 11 && Layout::FieldWidth(1) == 10);
+    static_assert(Layout::FieldOfValue(12) == 3 && Layout::ElementOfValue(5) == 4);
+
+    AlarmEngine<MonitoredPacket> alarms;
+    const bool temperatureSet = alarms.SetLimits(2, {0, 10, 80, 100});
+    const bool currentSet = alarms.SetLimits(1, 3, {-5, -1, 1, 5});
+    assert(temperatureSet && currentSet);
+    const bool invalidField = alarms.SetLimits(4, {});
+    const bool invalidElement = alarms.SetLimits(1, 10, {});
+    const bool unordered = alarms.SetLimits(0, {1, 0, 2, 3});
+    assert(!invalidField && !invalidElement && !unordered);
+
+    MonitoredPacket packet;
+    packet.Temperature = 50;
+    std::vector<AlarmChange> changes;
+    auto collect = [&changes](const AlarmChange &change) { changes.push_back(change); };
+    const size_t nominalChanges = alarms.Evaluate(packet, collect);
+    assert(nominalChanges == 0);
+    packet.Temperature = 90;
+    packet.Currents[3] = -10;
+    const size_t limitChanges = alarms.Evaluate(packet, collect);
+    const size_t repeatedChanges = alarms.Evaluate(packet, collect);
+    assert(limitChanges == 2 && repeatedChanges == 0);
+    assert(changes[0].field == 1 && changes[0].element == 3 && changes[0].state == AlarmState::LowAlarm && changes[0].value == -10);
+    assert(changes[1].field == 2 && changes[1].previous == AlarmState::Nominal && changes[1].state == AlarmState::HighWarning);
+    packet.Temperature = std::numeric_limits<float>::quiet_NaN();
+    const size_t nanChanges = alarms.Evaluate(packet, collect);
+    assert(nanChanges == 1 && alarms.GetState(2) == AlarmState::Invalid && alarms.GetState(1, 3) == AlarmState::LowAlarm);
+
+    // A batch in columnar form reports the changes in the order of the packets
+    static PacketColumns<MonitoredPacket, 100> columns;
+    for (size_t i = 0; i < 100; i++)
+    {
+        packet.Temperature = static_cast<float>(i);
+        packet.Currents[3] = static_cast<int16_t>(i % 7 - 3);
+        const bool appended = columns.Append(packet);
+        assert(appended);
+    }
+    const bool overflowAppended = columns.Append(packet);
+    assert(!overflowAppended && columns.Column(11)[42] == 42);
+    AlarmEngine<MonitoredPacket> batchAlarms;
+    AlarmEngine<MonitoredPacket, simd::Scalar> scalarAlarms;
+    batchAlarms.SetLimits(2, {0, 10, 80, 100});
+    batchAlarms.SetLimits(1, 3, {-5, -2, 2, 5});
+    scalarAlarms.SetLimits(2, {0, 10, 80, 100});
+    scalarAlarms.SetLimits(1, 3, {-5, -2, 2, 5});
+    changes.clear();
+    std::vector<AlarmChange> scalarChanges;
+    const size_t count = batchAlarms.Evaluate(columns, collect);
+    const size_t scalarCount = scalarAlarms.Evaluate(columns, [&scalarChanges](const AlarmChange &change) { scalarChanges.push_back(change); });
+    assert(scalarCount == count);
+    // The current changes three times every 7 packets, the temperature at 0, 10 and 81
+    assert(changes.size() == count && count == 44 + 3);
+    for (size_t i = 0; i < count; i++)
+    {
+        assert(changes[i].sample == scalarChanges[i].sample && changes[i].state == scalarChanges[i].state);
+    }
+    assert(changes[count - 2].sample == 10 && changes[count - 2].state == AlarmState::Nominal);
+    assert(changes[count - 1].sample == 81 && changes[count - 1].state == AlarmState::HighWarning);
+}
+
+static void TestCalibration()
+{
+    CalibrationCurve<4> polynomial;
+    const bool polynomialSet = polynomial.SetPolynomial({2, 0.5, 0.25});
+    const bool tooManyCoefficients = polynomial.SetPolynomial({1, 2, 3, 4, 5});
+    assert(polynomialSet && !tooManyCoefficients);
+    assert(polynomial.Evaluate(4) == 2 + 2 + 4);
+
+    // Interpolated between the points and clamped outside of the table
+    CalibrationCurve<4> table;
+    const double raw[] = {0, 100, 300};
+    const double engineering[] = {-50, 0, 100};
+    const double unordered[] = {0, 100, 100};
+    const bool unorderedSet = table.SetTable(unordered, engineering, 3);
+    assert(!unorderedSet && table.GetKind() == CalibrationCurve<4>::Kind::Identity);
+    const bool tableSet = table.SetTable(raw, engineering, 3);
+    assert(tableSet);
+    assert(table.Evaluate(-10) == -50 && table.Evaluate(50) == -25 && table.Evaluate(200) == 50 && table.Evaluate(1000) == 100);
+
+    // A NaN stays NaN instead of becoming the first table value, also in the vectorized conversion
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    double limits[simd::Native::Width];
+    simd::Native::Store(limits, simd::Native::Min(simd::Native::Broadcast(nan), simd::Native::Broadcast(1)));
+    assert(limits[0] == 1 && limits[simd::Native::Width - 1] == 1);
+    simd::Native::Store(limits, simd::Native::Max(simd::Native::Broadcast(nan), simd::Native::Broadcast(2)));
+    assert(limits[0] == 2 && limits[simd::Native::Width - 1] == 2);
+    assert(std::isnan(table.Evaluate(nan)) && std::isnan(polynomial.Evaluate(nan)));
+    std::array<double, 19> nanValues;
+    nanValues.fill(50);
+    nanValues[0] = nanValues[5] = nanValues[18] = nan;
+    table.Convert<simd::Native>(nanValues.data(), nanValues.data(), nanValues.size());
+    for (size_t i = 0; i < nanValues.size(); i++)
+    {
+        assert(i == 0 || i == 5 || i == 18 ? std::isnan(nanValues[i]) : nanValues[i] == -25);
+    }
+
+    CalibrationEngine<MonitoredPacket, 4> calibration;
+    const bool tableBound = calibration.SetCalibration(1, table);
+    const bool polynomialBound = calibration.SetCalibration(2, polynomial);
+    const bool invalidBound = calibration.SetCalibration(4, table);
+    assert(tableBound && polynomialBound && !invalidBound);
+    MonitoredPacket packet;
+    get<0>(packet.GetElements()) = 7;
+    packet.Currents = {0, 50, 100, 200, 300, 400, -1, 1, 2, 3};
+    packet.Temperature = 4;
+    std::array<double, NumericLayout<MonitoredPacket>::ValueCount> values;
+    calibration.Convert(packet, values.data());
+    assert(values[0] == 7 && values[2] == -25 && values[4] == 50 && values[6] == 100 && values[11] == 8);
+
+    // Batches give the same values as single packets, also when they are converted in place
+    static PacketColumns<MonitoredPacket, 37> columns;
+    static PacketColumns<MonitoredPacket, 37> converted;
+    CalibrationEngine<MonitoredPacket, 4, simd::Scalar> scalarCalibration;
+    scalarCalibration.SetCalibration(1, table);
+    scalarCalibration.SetCalibration(2, polynomial);
+    for (size_t i = 0; i < columns.Capacity; i++)
+    {
+        packet.Currents[i % 10] = static_cast<int16_t>(i * 9 - 20);
+        packet.Temperature = static_cast<float>(i) / 3;
+        columns.Append(packet);
+    }
+    calibration.Convert(columns, converted);
+    assert(converted.GetCount() == columns.Capacity);
+    scalarCalibration.Convert(columns, columns);
+    for (size_t value = 0; value < values.size(); value++)
+    {
+        for (size_t i = 0; i < columns.Capacity; i++)
+        {
+            assert(std::abs(converted.Column(value)[i] - columns.Column(value)[i]) < 1e-9);
+        }
+    }
+}
+
+static void TestFieldStatistics()
+{
+    const uint64_t second = 1000000000;
+    FieldStatistics<MonitoredPacket, 10> statistics(10 * second);
+    MonitoredPacket packet;
+    uint64_t now = 0;
+    // Values with a large offset keep their standard deviation
+    for (size_t i = 0; i < 100; i++, now += second / 10)
+    {
+        get<0>(packet.GetElements()) = 4000000000U + (i % 2) * 2;
+        packet.Currents[2] = static_cast<int16_t>(i);
+        packet.Temperature = 20;
+        const bool updated = statistics.Update(packet, now);
+        assert(updated);
+    }
+    now -= second / 10;
+    FieldSummary counter = statistics.Summary(0, 0, now);
+    assert(counter.count == 100 && counter.min == 4000000000.0 && counter.max == 4000000002.0);
+    assert(counter.mean == 4000000001.0 && std::abs(counter.stddev - 1) < 1e-9);
+    const FieldSummary current = statistics.Summary(1, 2, now);
+    assert(current.min == 0 && current.max == 99 && std::abs(current.mean - 49.5) < 1e-9 && std::abs(current.stddev - std::sqrt(833.25)) < 1e-9);
+    assert(statistics.Summary(1, 10, now).count == 0);
+
+    // The window moves in steps of a bucket, 5 seconds later the oldest half is dropped
+    now += 5 * second;
+    const bool moved = statistics.Update(packet, now);
+    assert(moved && statistics.Summary(1, 2, now).count == 51 && statistics.Summary(1, 2, now).min == 50);
+    const bool outdated = statistics.Update(packet, now - 10 * second);
+    assert(!outdated);
+
+    // A batch gives the same statistics as single packets
+    static PacketColumns<MonitoredPacket, 37> columns;
+    FieldStatistics<MonitoredPacket, 4> single(second);
+    FieldStatistics<MonitoredPacket, 4, simd::Scalar> batch(second);
+    for (size_t i = 0; i < columns.Capacity; i++)
+    {
+        packet.Currents[i % 10] = static_cast<int16_t>(i * 7);
+        packet.Temperature = static_cast<float>(i) / 4;
+        columns.Append(packet);
+        single.Update(packet, 0);
+    }
+    batch.Update(columns, 0);
+    batch.Update(columns, 0);
+    columns.Clear();
+    const bool emptyUpdated = batch.Update(columns, 0);
+    assert(emptyUpdated);
+    size_t values = 0;
+    single.ForEachValue(0, [&](size_t field, size_t element, const FieldSummary &summary)
+    {
+        const FieldSummary other = batch.Summary(field, element, 0);
+        assert(other.count == 2 * summary.count && other.min == summary.min && other.max == summary.max);
+        assert(std::abs(other.mean - summary.mean) < 1e-9 && std::abs(other.stddev - summary.stddev) < 1e-9);
+        values++;
+    });
+    assert(values == NumericLayout<MonitoredPacket>::ValueCount);
+
+    PacketStatistics<4, MonitoredPacket, CanStatusPacket> perType(second);
+    const bool typeUpdated = perType.Update(packet, 0);
+    assert(typeUpdated && perType.Get<MonitoredPacket>().Summary(2, 0, 0).count == 1);
+    assert(perType.Get<CanStatusPacket>().Summary(0, 0, 0).count == 0);
+}
+
+static void TestFieldHistory()
+{
+    static FieldHistory<MonitoredPacket, 64, 2, 4> history;
+    static_assert(history.LevelLength(1) == 16 && history.LevelLength(2) == 4 && history.LevelFactor(2) == 16);
+    MonitoredPacket packet;
+    for (size_t i = 0; i < 100; i++)
+    {
+        packet.Temperature = static_cast<float>(i);
+        history.Append(packet, i * 10);
+    }
+    assert(history.GetCount() == 100);
+    uint64_t times[100];
+    double values[100];
+    double max[100];
+    const size_t recent = history.Read(2, 0, 10, times, values);
+    assert(recent == 10 && times[0] == 900 && values[0] == 90 && values[9] == 99);
+    const size_t all = history.Read(2, 0, 100, times, values);
+    assert(all == 64 && values[0] == 36);
+    const size_t beyond = history.Read(1, 10, 100, times, values);
+    assert(beyond == 0);
+
+    // 25 completed buckets of 4 samples on level 1, the last 16 are kept
+    const size_t level1 = history.ReadLevel(1, 2, 0, 100, times, values, max);
+    assert(level1 == 16);
+    assert(times[0] == 360 && values[0] == 36 && max[0] == 39 && values[15] == 96 && max[15] == 99);
+    const size_t level2 = history.ReadLevel(2, 2, 0, 100, times, values, max);
+    assert(level2 == 4);
+    assert(times[3] == 800 && values[3] == 80 && max[3] == 95);
+    const size_t level3 = history.ReadLevel(3, 2, 0, 100, times, values, max);
+    assert(level3 == 0);
+
+    // A reader never sees a sample that is overwritten while it is copied
+    static FieldHistory<MonitoredPacket, 64, 2, 4> concurrent;
+    std::atomic<bool> done(false);
+    std::thread writer([&done]()
+    {
+        MonitoredPacket written;
+        for (uint32_t i = 0; i < 200000; i++)
+        {
+            get<0>(written.GetElements()) = i;
+            concurrent.Append(written, i);
+        }
+        done.store(true);
+    });
+    size_t reads = 0;
+    while (!done.load() || reads == 0)
+    {
+        uint64_t readTimes[64];
+        double readValues[64];
+        double readMax[64];
+        const size_t length = concurrent.Read(0, 0, 64, readTimes, readValues);
+        for (size_t i = 0; i < length; i++)
+        {
+            assert(readValues[i] == static_cast<double>(readTimes[i]) && (i == 0 || readTimes[i] == readTimes[i - 1] + 1));
+        }
+        const size_t buckets = concurrent.ReadLevel(1, 0, 0, 16, readTimes, readValues, readMax);
+        for (size_t i = 0; i < buckets; i++)
+        {
+            assert(readValues[i] == static_cast<double>(readTimes[i]) && readMax[i] == readValues[i] + 3);
+        }
+        reads++;
+    }
+    writer.join();
+}
+
+static void TestRawFilter()
+{
+    using Fields = RawFields<MonitoredPacket>;
+    static_assert(Fields::FixedOffset<1>() == 6 && Fields::FixedOffset<2>() == 26 && Fields::FixedOffset<3>() == 30);
+
+    // Fixed length packets one after the other, every packet is checked by the batch and by the single packet evaluation
+    static const size_t COUNT = 100;
+    static const size_t STRIDE = MonitoredPacket::GetMaxSize();
+    static std::array<uint8_t, STRIDE> packets[COUNT];
+    MonitoredPacket packet;
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        get<0>(packet.GetElements()) = static_cast<uint32_t>(i);
+        packet.Currents[3] = static_cast<int16_t>(i * 7 - 300);
+        packet.Temperature = i == 50 ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(i);
+        const size_t length = packet.Serialize(packets[i]);
+        assert(length == STRIDE);
+    }
+    const uint8_t *data = packets[0].data();
+    uint64_t matches[2];
+
+    FieldPredicate<MonitoredPacket, 2> hot(RawCompare::Greater, 80.0f);
+    const size_t hotCount = hot.Evaluate(data, STRIDE, COUNT, matches);
+    assert(hotCount == 19 && matches[0] == 0 && matches[1] == ((uint64_t(1) << 19) - 1) << 17);
+    FieldPredicate<MonitoredPacket, 2, simd::Scalar> notFifty(RawCompare::NotEqual, 50.0f);
+    const size_t notFiftyCount = notFifty.Evaluate(data, STRIDE, COUNT, matches);
+    assert(notFiftyCount == COUNT && notFifty(packets[50].data(), STRIDE));
+    FieldPredicate<MonitoredPacket, 2> fifty(RawCompare::Equal, 50.0f);
+    const size_t fiftyCount = fifty.Evaluate(data, STRIDE, COUNT, matches);
+    assert(fiftyCount == 0 && !fifty(packets[50].data(), STRIDE));
+
+    FieldPredicate<MonitoredPacket, 1> current(-100, 100, 3);
+    FieldPredicate<MonitoredPacket, 0> counter(RawCompare::LessEqual, 40);
+    const RawFilter filter(current, counter);
+    // -300 + 7 * i is within [-100, 100] for i from 29 to 57
+    const size_t filterCount = filter.Evaluate(data, STRIDE, COUNT, matches);
+    assert(filterCount == 12 && matches[0] == ((uint64_t(1) << 12) - 1) << 29 && matches[1] == 0);
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        const bool bit = (matches[i / 64] >> (i % 64)) & 1;
+        assert(filter(packets[i].data(), STRIDE) == bit && filter(packets[i].data(), STRIDE) == (i >= 29 && i <= 40));
+    }
+    assert(!filter(packets[30].data(), Fields::FixedOffset<1>() + 7));
+
+    // A field behind a string is found by scanning the string
+    using LogPacket = ComPacket<uint8_t, std::string, int32_t>;
+    static_assert(!RawFields<LogPacket>::HasFixedOffset<2>());
+    uint8_t log[] = {7, 'a', 'b', 'c', 0, 0, 0, 0, 0};
+    const int32_t code = -42;
+    memcpy(&log[5], &code, sizeof(code));
+    size_t offset;
+    const bool located = RawFields<LogPacket>::Locate<2>(log, sizeof(log), offset);
+    assert(located && offset == 5);
+    const FieldPredicate<LogPacket, 2> error(RawCompare::Less, 0);
+    assert(error(log, sizeof(log)) && !error(log, sizeof(log) - 1) && !error(log, 3));
+}
+
+struct EventPacket : public TagedComPacket<2, uint64_t, bool, std::string, LargeBitField, TestBitfield, std::array<float, 2>>
+{
+    static constexpr std::array<const char *, 6> FieldNames = {{"time", "valid", "text", "flags", "mode", "values"}};
+
+    EventPacket() : TagedComPacket({0x09, 0x01})
+    {
+    }
+
+    std::string &Text = get<2>(elements);
+    LargeBitField &Flags = get<3>(elements);
+    std::array<float, 2> &Values = get<5>(elements);
+};
+
+static void TestCsvExport()
+{
+    char line[256];
+    const CsvWriter<EventPacket> writer({"time", "valid", "text", "flags", nullptr, "values"});
+    assert(std::string(line, CsvWriter<EventPacket>().WriteHeader(line, sizeof(line))).find(",flags.TestBit2,mode,values[0],") != std::string::npos);
+    const std::string header = "timestamp,time,valid,text,flags.TestBit1,flags.TestBit2,field4,values[0],values[1]\n";
+    assert(std::string(line, writer.WriteHeader(line, sizeof(line))) == header);
+
+    EventPacket packet;
+    get<0>(packet.GetElements()) = 1234;
+    get<1>(packet.GetElements()) = true;
+    packet.Text = "a,b\"c";
+    packet.Flags.WriteTestBit1(17);
+    packet.Flags.WriteTestBit2(5);
+    get<4>(packet.GetElements()).WriteTestBit(1);
+    packet.Values = {0.1f, -2.5f};
+    const std::string row = "5,1234,1,\"a,b\"\"c\",17,5,01,0.1,-2.5\n";
+    assert(std::string(line, writer.WriteRow(line, sizeof(line), 5, packet)) == row);
+    assert(writer.WriteRow(line, row.size() - 1, 5, packet) == 0);
+    const CsvWriter<EventPacket> tsv({}, '\t');
+    assert(std::string(line, tsv.WriteRow(line, sizeof(line), 5, packet)) == "5\t1234\t1\t\"a,b\"\"c\"\t17\t5\t01\t0.1\t-2.5\n");
+
+    // A capture with 20 events, a packet of another type and a truncated event
+    static uint8_t capture[4096];
+    size_t length = 0;
+    std::string expected;
+    std::array<uint8_t, 128> serialized;
+    for (size_t i = 0; i < 20; i++)
+    {
+        get<0>(packet.GetElements()) = i;
+        packet.Text = "event " + std::to_string(i);
+        const size_t packetLength = packet.Serialize(serialized);
+        length += WriteCaptureRecord(&capture[length], sizeof(capture) - length, 100 + i, serialized.data(), packetLength);
+        expected += std::string(line, writer.WriteRow(line, sizeof(line), 100 + i, packet));
+        if (i == 10)
+        {
+            length += WriteCaptureRecord(&capture[length], sizeof(capture) - length, 0, serialized.data(), packetLength - 3);
+            std::array<uint8_t, PingResponse::GetMaxSize()> ping;
+            length += WriteCaptureRecord(&capture[length], sizeof(capture) - length, 0, ping.data(), PingResponse().Serialize(ping));
+        }
+    }
+
+    const CsvExport<EventPacket> csv(writer);
+    std::string exported;
+    size_t flushes = 0;
+    char buffer[128];
+    const size_t rows = csv.Export(CaptureSegment{capture, length}, buffer, sizeof(buffer), [&](const char *text, size_t textLength)
+    {
+        exported.append(text, textLength);
+        flushes++;
+    });
+    assert(rows == 20 && exported == expected && flushes > 5);
+
+    // Split into segments that are exported in parallel, the concatenated segments are the same as the single export
+    CaptureSegment segments[4];
+    const size_t count = SplitCapture(capture, length, segments, 4);
+    assert(count == 4 && segments[0].data == capture && segments[3].data + segments[3].length == capture + length);
+    static char buffers[2 * 128];
+    std::string parts[4];
+    // Two threads take turns on the four segments
+    const size_t parallelRows = csv.ExportParallel(segments, count, buffers, 128, 2, [&parts](size_t segment, const char *text, size_t textLength)
+    {
+        parts[segment].append(text, textLength);
+    });
+    assert(parallelRows == 20);
+    assert(parts[0] + parts[1] + parts[2] + parts[3] == expected && !parts[3].empty());
+}
+
+static void TestJsonExport()
+{
+    EventPacket packet;
+    get<0>(packet.GetElements()) = 1234;
+    get<1>(packet.GetElements()) = true;
+    packet.Text = "a\"b\\c\n\x01";
+    packet.Flags.WriteTestBit1(17);
+    packet.Flags.WriteTestBit2(5);
+    get<4>(packet.GetElements()).WriteTestBit(1);
+    packet.Values = {0.1f, std::numeric_limits<float>::infinity()};
+    char json[256];
+    const std::string expected = "{\"time\":1234,\"valid\":true,\"text\":\"a\\\"b\\\\c\\n\\u0001\",\"flags\":{\"TestBit1\":17,\"TestBit2\":5},"
+                                 "\"mode\":\"01\",\"values\":[0.1,null]}";
+    assert(std::string(json, WriteJson(json, sizeof(json), packet)) == expected);
+    assert(std::string(json, JsonWriter<EventPacket>::Write(json, sizeof(json), 7, packet)) == "{\"timestamp\":7," + expected.substr(1));
+    assert(WriteJson(json, expected.size() - 1, packet) == 0);
+
+    // Types without FieldNames use the field index
+    MonitoredPacket monitored;
+    get<0>(monitored.GetElements()) = 3;
+    monitored.Currents.fill(-1);
+    monitored.Temperature = -2.5f;
+    assert(std::string(json, WriteJson(json, sizeof(json), monitored)) ==
+           "{\"field0\":3,\"field1\":[-1,-1,-1,-1,-1,-1,-1,-1,-1,-1],\"field2\":-2.5,\"field3\":0}");
+}
+
+static void TestTrafficGenerator()
+{
+    static uint8_t buffer[1 << 16];
+    TrafficGenerator<EventPacket, MonitoredPacket> generator;
+    PacketDispatcher<EventPacket, MonitoredPacket> dispatcher;
+    size_t types[2] = {};
+    for (size_t i = 0; i < 1000; i++)
+    {
+        GeneratedPacket info;
+        const size_t length = generator.Generate(buffer, sizeof(buffer), &info);
+        assert(length > 0 && info.length == length && info.serializedLength == length && info.flippedBits == 0);
+        types[info.type]++;
+        const bool valid = dispatcher.Dispatch(buffer, length, [](auto &packet)
+        {
+            if constexpr (std::is_same<std::decay_t<decltype(packet)>, EventPacket>::value)
+            {
+                assert(packet.Text.size() <= 16);
+                for (const char character : packet.Text)
+                {
+                    assert(character >= ' ' && character <= '~');
+                }
+                // Only the bits of the listed sub-fields are set
+                assert(packet.Flags.GetBits(5, 8) == 0 && packet.Flags.GetBits(16, 54) == 0);
+                assert(packet.Values[0] >= -1000.0f && packet.Values[1] <= 1000.0f);
+            }
+            else
+            {
+                assert(packet.Temperature >= -1000.0f && packet.Temperature <= 1000.0f);
+            }
+        });
+        assert(valid);
+    }
+    assert(types[0] > 400 && types[1] > 400 && generator.GetCounters().packets == 1000);
+    generator.SetWeight(0, 0);
+    generator.SetWeight(1, 0);
+    const size_t disabledLength = generator.Generate(buffer, sizeof(buffer));
+    const size_t shortLength = generator.Generate(buffer, 1);
+    assert(disabledLength == 0 && shortLength == 0);
+
+    // The same seed gives the same traffic
+    TrafficGenerator<EventPacket, MonitoredPacket> first(TrafficOptions(), 7);
+    TrafficGenerator<EventPacket, MonitoredPacket> second(TrafficOptions(), 7);
+    uint8_t copy[256];
+    for (size_t i = 0; i < 100; i++)
+    {
+        const size_t length = first.Generate(buffer, sizeof(buffer));
+        const size_t copyLength = second.Generate(copy, sizeof(copy));
+        assert(copyLength == length && memcmp(buffer, copy, length) == 0);
+    }
+
+    // Pattern data is derived from the sequence number
+    TrafficOptions options;
+    options.fill = TrafficFill::Pattern;
+    TrafficGenerator<MonitoredPacket> pattern(options);
+    pattern.SetSequence(100);
+    MonitoredPacket monitored;
+    size_t length = pattern.Generate(buffer, sizeof(buffer));
+    assert(length == MonitoredPacket::GetMaxSize());
+    const auto [match, start, remaining] = monitored.CheckIDMatch(buffer, length);
+    const auto patternResult = MonitoredPacket::Unserialize(start, remaining, monitored);
+    assert(match && std::get<1>(patternResult));
+    assert(get<0>(monitored.GetElements()) == 100 && monitored.Currents[9] == 110 && monitored.Temperature == 111.0f);
+    assert(get<3>(monitored.GetElements()) == 112.0);
+
+    // Several threads, packet i has the sequence number i
+    CaptureSegment segments[4];
+    pattern.SetSequence(0);
+    const size_t generated = pattern.GenerateParallel(buffer, sizeof(buffer), 1000, 5000, 10, segments, 4);
+    assert(generated == 1000);
+    size_t count = 0;
+    for (const CaptureSegment &segment : segments)
+    {
+        CaptureReader reader(segment.data, segment.length);
+        PacketView view;
+        while (reader.Next(view))
+        {
+            assert(view.timestamp == 5000 + 10 * count);
+            const auto [match, start, remaining] = monitored.CheckIDMatch(view.data, view.length);
+            const auto result = MonitoredPacket::Unserialize(start, remaining, monitored);
+            assert(match && std::get<1>(result));
+            assert(get<0>(monitored.GetElements()) == count);
+            count++;
+        }
+    }
+    assert(count == 1000 && pattern.GetCounters().packets == 1001);
+
+    // Truncation and bit errors
+    options.fill = TrafficFill::Random;
+    options.truncateProbability = 1.0;
+    TrafficGenerator<MonitoredPacket> truncating(options);
+    for (size_t i = 0; i < 100; i++)
+    {
+        GeneratedPacket info;
+        length = truncating.Generate(buffer, sizeof(buffer), &info);
+        assert(length > 0 && length < info.serializedLength && info.serializedLength == MonitoredPacket::GetMaxSize());
+    }
+    assert(truncating.GetCounters().truncated == 100);
+    options.truncateProbability = 0;
+    options.bitErrorRate = 0.01;
+    TrafficGenerator<EventPacket, MonitoredPacket> noisy(options);
+    size_t flipped = 0;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        GeneratedPacket info;
+        noisy.Generate(buffer, sizeof(buffer), &info);
+        flipped += info.flippedBits;
+    }
+    const TrafficCounters &counters = noisy.GetCounters();
+    assert(flipped == counters.flippedBits && counters.corrupted > 0 && counters.corrupted < 1000);
+    assert(flipped > counters.bytes * 8 * 0.008 && flipped < counters.bytes * 8 * 0.012);
+
+#ifdef USE_ETL
+    // Strings stay within the capacity of the etl::string
+    TrafficGenerator<MixedDataMessage> mixed;
+    MixedDataMessage message;
+    size_t longest = 0;
+    for (size_t i = 0; i < 100; i++)
+    {
+        length = mixed.Generate(buffer, sizeof(buffer));
+        const auto result = MixedDataMessage::Unserialize(buffer, length, message);
+        assert(std::get<1>(result));
+        longest = std::max<size_t>(longest, message.Testfield2.size());
+    }
+    assert(longest == 10);
+#endif
+}
+
+#ifdef __linux__
+static void TestCaptureReplay()
+{
+    // 20 packets recorded 1 ms apart, stored in a file
+    static uint8_t capture[4096];
+    size_t length = 0;
+    for (uint8_t i = 0; i < 20; i++)
+    {
+        const uint8_t packet[3] = {0x09, 0x01, i};
+        length += WriteCaptureRecord(&capture[length], sizeof(capture) - length, 5000000 + 1000000 * uint64_t(i), packet, sizeof(packet));
+    }
+    char path[] = "/tmp/basecom_replay_XXXXXX";
+    const int file = mkstemp(path);
+    assert(file >= 0);
+    const ssize_t written = write(file, capture, length);
+    assert(written == static_cast<ssize_t>(length));
+    close(file);
+    MappedCapture mapped;
+    const bool opened = mapped.Open(path);
+    assert(opened);
+    unlink(path);
+    assert(mapped.GetLength() == length && memcmp(mapped.GetData(), capture, length) == 0);
+
+    // 10 times faster than recorded, the 19 ms between the first and the last packet take 1.9 ms
+    CaptureReplay replay(10.0);
+    std::vector<uint64_t> emitted;
+    const uint64_t start = CaptureReplay::Now();
+    ReplayReport report = replay.Replay(mapped.GetSegment(), [&emitted](const PacketView &view)
+    {
+        assert(view.length == 3 && view.data[2] == emitted.size());
+        emitted.push_back(CaptureReplay::Now());
+        return true;
+    });
+    assert(report.completed && report.packets == 20 && report.bytes == 60);
+    assert(report.lateness.GetCount() == 20 && report.packetRate > 0);
+    for (size_t i = 0; i < emitted.size(); i++)
+    {
+        assert(emitted[i] - start >= 100000 * i);
+    }
+
+    // As fast as possible, twice, stopped by the sink after 25 packets
+    CaptureReplay fast(0);
+    size_t count = 0;
+    report = fast.Replay(mapped.GetSegment(), [&count](const PacketView &) { return ++count < 25; }, 2);
+    assert(!report.completed && report.packets == 24 && report.lateness.GetCount() == 0);
+
+    // A stop from another thread cuts a long wait short, the second record is 5 s after the first
+    uint8_t gapped[2 * (CAPTURE_RECORD_HEADER_LENGTH + 1)];
+    const uint8_t marker = 0;
+    size_t gappedLength = WriteCaptureRecord(gapped, sizeof(gapped), 0, &marker, 1);
+    gappedLength += WriteCaptureRecord(&gapped[gappedLength], sizeof(gapped) - gappedLength, 5000000000u, &marker, 1);
+    CaptureReplay paced(1.0);
+    std::thread stopper([&paced]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        paced.Stop();
+    });
+    report = paced.Replay(CaptureSegment{gapped, gappedLength}, [](const PacketView &) { return true; });
+    stopper.join();
+    assert(!report.completed && report.packets == 1 && report.duration < 1000000000u);
+
+    // Records written to a pipe read back as the same capture
+    int pipes[2];
+    const int piped = pipe(pipes);
+    assert(piped == 0);
+    report = fast.Replay(mapped.GetSegment(), FdSink(pipes[1], true));
+    assert(report.completed && report.packets == 20);
+    close(pipes[1]);
+    uint8_t copy[4096];
+    const ssize_t readLength = read(pipes[0], copy, sizeof(copy));
+    assert(readLength == static_cast<ssize_t>(length) && memcmp(copy, capture, length) == 0);
+    close(pipes[0]);
+    const bool missingOpened = mapped.Open("/nonexistent/capture");
+    assert(!missingOpened && mapped.GetLength() == 0);
+}
+#endif
+
+static void TestStringScan()
+{
+    const char data[] = {'a', 'b', 'c', 0, 'd', 'e'};
+    for (size_t length = 0; length <= sizeof(data); length++)
+    {
+        assert(utils::strlen_ct(data, length) == utils::strlen_s(data, length));
+    }
+
+    // A string that is longer than the buffer of the etl::string must not change the read length
+    std::array<uint8_t, 32> buffer;
+    buffer.fill('x');
+    buffer[20] = 0;
+    std::string text;
+    bool valid = true;
+    const size_t textRead = utils::deserializeFromBuffer(buffer.data(), buffer.size(), text, valid);
+    assert(textRead == 21 && text.size() == 20 && valid);
+#ifdef USE_ETL
+    etl::string<8> shortText;
+    const size_t shortRead = utils::deserializeFromBuffer(buffer.data(), buffer.size(), shortText, valid);
+    assert(shortRead == 9 && shortText.size() == 8 && valid);
+#endif
+}
+
+static void TestDeduplicator()
+{
+    PacketDeduplicator<64, 4> dedup(100);
+    std::array<uint8_t, 8> packet = {1, 2, 3, 4, 5, 6, 7, 8};
+    const bool first = dedup.IsFirst(packet, packet.size(), 0);
+    const bool duplicate = dedup.IsFirst(packet, packet.size(), 50);
+    assert(first && !duplicate);
+    assert(dedup.GetDuplicateCount() == 1);
+
+    packet[7] = 9;
+    const bool other = dedup.IsFirst(packet, packet.size(), 60);
+    const bool expired = dedup.IsFirst(packet, packet.size(), 200); // Outside of the window the packet is accepted again
+    assert(other && expired);
+
+    // A copy from a station with a clock behind the first one is still a duplicate
+    const bool late = dedup.IsFirst(packet, packet.size(), 150);
+    assert(!late && dedup.GetDuplicateCount() == 2);
+    const bool stillKnown = dedup.IsFirst(packet, packet.size(), 210);
+    assert(!stillKnown);
+
+    std::array<uint8_t, 2> id = {2, 3};
+    const bool firstKey = dedup.IsFirstKey(PacketDeduplicator<64, 4>::MakeKey(id, 1), 300);
+    const bool duplicateKey = dedup.IsFirstKey(PacketDeduplicator<64, 4>::MakeKey(id, 1), 301);
+    const bool otherKey = dedup.IsFirstKey(PacketDeduplicator<64, 4>::MakeKey(id, 2), 302);
+    assert(firstKey && !duplicateKey && otherKey);
+}
+
+static void TestStreamMerge()
+{
+    std::array<std::array<uint8_t, 3 * (CAPTURE_RECORD_HEADER_LENGTH + 1)>, 3> captures;
+    const uint64_t timestamps[3][3] = {{1, 4, 7}, {2, 4, 9}, {3, 5, 6}};
+    std::array<CaptureReader, 3> readers;
+    std::array<CaptureReader *, 3> sources;
+    for (size_t i = 0; i < captures.size(); i++)
+    {
+        size_t offset = 0;
+        for (size_t j = 0; j < 3; j++)
+        {
+            const uint8_t data = static_cast<uint8_t>(i);
+            offset += WriteCaptureRecord(&captures[i][offset], captures[i].size() - offset, timestamps[i][j], &data, 1);
+        }
+        assert(offset == captures[i].size());
+        readers[i] = CaptureReader(captures[i].data(), captures[i].size());
+        sources[i] = &readers[i];
+    }
+
+    StreamMerger<CaptureReader, 3, 2> merger(sources.data(), sources.size());
+    const uint64_t expectedTimes[] = {1, 2, 3, 4, 4, 5, 6, 7, 9};
+    const uint8_t expectedInputs[] = {0, 1, 2, 0, 1, 2, 2, 0, 1};
+    size_t i = 0;
+    merger.Drain([&](const PacketView &view)
+    {
+        assert(view.timestamp == expectedTimes[i] && view.length == 1 && view.data[0] == expectedInputs[i]);
+        i++;
+    });
+    assert(i == 9);
+}
+
+struct RpcResult
+{
+    RpcStatus status;
+    uint32_t value;
+    int calls;
+};
+
+static void RpcCallback(void *context, RpcStatus status, const PingResponse *response)
+{
+    RpcResult *result = static_cast<RpcResult *>(context);
+    result->status = status;
+    result->value = response != nullptr ? response->Value : 0;
+    result->calls++;
+}
+
+static void TestRpc()
+{
+    RpcClient<PingCommand, 4> client;
+    PingCommand command;
+    std::array<uint8_t, PingCommand::GetMaxSize() + sizeof(uint16_t)> commandBuffer;
+    std::array<RpcResult, 5> results = {};
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        command.Value = static_cast<uint32_t>(i);
+        const size_t sent = client.Send(command, commandBuffer, 100 + i, RpcCallback, &results[i]);
+        assert(sent == commandBuffer.size());
+    }
+    const size_t overflowSent = client.Send(command, commandBuffer, 100, RpcCallback, &results[4]);
+    assert(overflowSent == 0 && client.GetPendingCount() == 4); // The table is full
+
+    // Answer the command with the correlation id 2 like a server would do
+    PingCommand received;
+    uint16_t correlation = 0;
+    command.Value = 2;
+    rpc::SerializeWithCorrelation(command, static_cast<uint16_t>(2), commandBuffer);
+    const bool unserialized = rpc::UnserializeWithCorrelation(commandBuffer.data(), commandBuffer.size(), received, correlation);
+    assert(unserialized && correlation == 2 && received.Value == 2);
+
+    PingResponse response;
+    response.Value = received.Value * 10;
+    std::array<uint8_t, PingResponse::GetMaxSize() + sizeof(uint16_t)> responseBuffer;
+    rpc::SerializeWithCorrelation(response, correlation, responseBuffer);
+    const bool handled = client.HandleResponse(responseBuffer, responseBuffer.size());
+    assert(handled && results[2].calls == 1 && results[2].status == RpcStatus::Completed && results[2].value == 20);
+    const bool handledTwice = client.HandleResponse(responseBuffer, responseBuffer.size()); // Already completed
+    const bool handledCommand = client.HandleResponse(commandBuffer, commandBuffer.size()); // Wrong packet id
+    assert(!handledTwice && !handledCommand);
+
+    const size_t timedOut = client.Poll(101);
+    assert(timedOut == 2);
+    assert(results[0].status == RpcStatus::Timeout && results[1].status == RpcStatus::Timeout && results[3].calls == 0);
+    client.CancelAll();
+    assert(results[3].calls == 1 && results[3].status == RpcStatus::Cancelled && client.GetPendingCount() == 0);
+}
 
 int main(void)
 {
@@ -69,6 +1251,9 @@ int main(void)
     plaintest.var1 = 10;
     plaintest.var2 = 100;
     assert(plaintest.var3 == 0 && plaintest.var1 == 10 && plaintest.var2 == 100);
+    auto &[field1, field2, field3, field4] = plaintest.GetElements();
+    static_assert(std::tuple_size<PlainTestField::ElementTypes>::value == 4 && std::is_same<decltype(field4), long>::value);
+    assert(&field1 == &plaintest.var1 && field2 == 100 && field3 == 0 && &field4 == &plaintest.var4);
 
     TestBitfield bitfieldtest;
     bitfieldtest.WriteTestBit(1);
@@ -82,6 +1267,7 @@ int main(void)
 
     LargeBitField largebitfield;
 
+#ifdef USE_ETL
     MixedDataMessage mixed;
     mixed.Testfield1 = -10;
     const etl::string<10> teststring("HELLO WORLD");
@@ -116,6 +1302,33 @@ int main(void)
     decltype(falseData.cbegin()) falseIterator;
     std::tie(usedData, valid, falseIterator) = MixedDataMessage::Unserialize<falseData.max_size()>(falseData, falseData.max_size(), deserializeTest);
     assert(!valid);
+#endif
+    TestStdStringRoundTrip();
+
+    TestDeduplicator();
+    TestStreamMerge();
+    TestRpc();
+    TestPacketTemplate();
+    TestCanTransport();
+    TestFraming();
+    TestDispatcher();
+    TestStringScan();
+    TestInstrumentation();
+    TestHistogram();
+    TestLatencyInstrumentation();
+    TestLinkStatistics();
+    TestLinkBudget();
+    TestAlarmEngine();
+    TestCalibration();
+    TestFieldStatistics();
+    TestFieldHistory();
+    TestRawFilter();
+    TestCsvExport();
+    TestJsonExport();
+    TestTrafficGenerator();
+#ifdef __linux__
+    TestCaptureReplay();
+#endif
 
     return 0;
 }
\ No newline at end of file
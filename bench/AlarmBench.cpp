@@ -0,0 +1,137 @@
+#include <random>
+#include <vector>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Throughput of the AlarmEngine for a housekeeping packet with 201 numeric values, all of them with limits.
+ *
+ * gather:          copy the values of a packet to doubles, the part of evaluate that doesn't depend on the backend
+ * evaluate:        check a single packet, with the scalar and the native vector backend
+ * evaluate_batch:  check a batch of 256 packets in columnar form, ns_per_op is the time per packet
+ * append_batch:    copy a packet into the columns of a batch
+ *
+ * The values stay within their limits, except for a few values that change their state in every packet, so the time is dominated by
+ * the comparisons and not by the reporting of changes.
+ */
+
+struct HousekeepingPacket : public TagedComPacket<2, uint64_t, std::array<float, 64>, std::array<int16_t, 64>, std::array<uint32_t, 64>, std::array<double, 8>>
+{
+    HousekeepingPacket() : TagedComPacket({0x06, 0x01})
+    {
+    }
+
+    std::array<float, 64> &Temperatures = get<1>(elements);
+    std::array<int16_t, 64> &Currents = get<2>(elements);
+    std::array<uint32_t, 64> &Counters = get<3>(elements);
+    std::array<double, 8> &Voltages = get<4>(elements);
+};
+
+static const size_t BATCH = 256;
+static const size_t PACKETS = 1024;
+
+template <typename Engine>
+static void SetLimits(Engine &engine)
+{
+    engine.SetLimits(0, {0, 0, 1e18, 1e19});
+    engine.SetLimits(1, {-40, -20, 60, 85});
+    engine.SetLimits(2, {-2000, -1500, 1500, 2000});
+    engine.SetLimits(3, {0, 0, 1e9, 4e9});
+    engine.SetLimits(4, {24, 26, 30, 32});
+}
+
+template <typename Backend>
+static void BenchEvaluate(const bench::Options &options, const char *shape, const std::vector<HousekeepingPacket> &packets)
+{
+    AlarmEngine<HousekeepingPacket, Backend> engine;
+    SetLimits(engine);
+    size_t index = 0;
+    size_t changes = 0;
+    bench::Run(options, "evaluate", shape, 0, [&]
+    {
+        changes += engine.Evaluate(packets[index], [](const AlarmChange &change) { bench::DoNotOptimize(change); });
+        index = (index + 1) % packets.size();
+    });
+    bench::DoNotOptimize(changes);
+}
+
+template <typename Backend>
+static void BenchEvaluateBatch(const bench::Options &options, const char *shape, const PacketColumns<HousekeepingPacket, BATCH> &columns)
+{
+    AlarmEngine<HousekeepingPacket, Backend> engine;
+    SetLimits(engine);
+    size_t changes = 0;
+    const double ns = bench::Run(options, "evaluate_batch_raw", shape, 0, [&]
+    {
+        changes += engine.Evaluate(columns, [](const AlarmChange &change) { bench::DoNotOptimize(change); });
+    });
+    if (ns > 0)
+    {
+        printf("{\"benchmark\":\"evaluate_batch\",\"shape\":\"%s\",\"ns_per_op\":%.3f,\"packets_per_s\":%.4g}\n", shape, ns / BATCH, BATCH * 1e9 / ns);
+    }
+    bench::DoNotOptimize(changes);
+}
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> temperature(10, 40);
+    std::uniform_int_distribution<int> current(-1000, 1000);
+    std::vector<HousekeepingPacket> packets(PACKETS);
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        HousekeepingPacket &packet = packets[i];
+        get<0>(packet.GetElements()) = i;
+        for (auto &value : packet.Temperatures)
+        {
+            value = temperature(generator);
+        }
+        for (auto &value : packet.Currents)
+        {
+            value = static_cast<int16_t>(current(generator));
+        }
+        for (size_t j = 0; j < packet.Counters.size(); j++)
+        {
+            packet.Counters[j] = static_cast<uint32_t>(i * j);
+        }
+        packet.Voltages.fill(28);
+        // Two values alternate between a warning and nominal
+        packet.Temperatures[7] = (i & 1) ? 70 : 20;
+        packet.Voltages[3] = (i & 1) ? 25 : 28;
+    }
+
+    static double values[NumericLayout<HousekeepingPacket>::ValueCount];
+    size_t index = 0;
+    bench::Run(options, "gather", "housekeeping", 0, [&]
+    {
+        NumericLayout<HousekeepingPacket>::Gather(packets[index], values);
+        bench::DoNotOptimize(values);
+        index = (index + 1) % packets.size();
+    });
+
+    BenchEvaluate<simd::Scalar>(options, "scalar", packets);
+    BenchEvaluate<simd::Native>(options, "native", packets);
+
+    static PacketColumns<HousekeepingPacket, BATCH> columns;
+    bench::Run(options, "append_batch", "housekeeping", 0, [&]
+    {
+        if (!columns.Append(packets[index]))
+        {
+            columns.Clear();
+        }
+        index = (index + 1) % packets.size();
+    });
+    columns.Clear();
+    for (size_t i = 0; i < BATCH; i++)
+    {
+        columns.Append(packets[i]);
+    }
+    BenchEvaluateBatch<simd::Scalar>(options, "scalar", columns);
+    BenchEvaluateBatch<simd::Native>(options, "native", columns);
+    return 0;
+}
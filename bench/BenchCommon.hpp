@@ -0,0 +1,186 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+#ifndef BENCHCOMMON_HPP__
+#define BENCHCOMMON_HPP__
+
+/**
+ * Small helpers shared by the benchmarks.
+ *
+ * Results are printed as one JSON object per line so they could be collected with a script:
+ * {"benchmark":"serialize","shape":"plain","iterations":1048576,"ns_per_op":3.2,"bytes_per_s":5.6e9}
+ */
+namespace bench
+{
+/**
+ * @brief Prevent the compiler from optimizing away the computation of value.
+ */
+template <typename T>
+inline void DoNotOptimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    if constexpr (sizeof(T) <= sizeof(void *) && std::is_trivially_copyable<T>::value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+    else
+    {
+        asm volatile("" : : "m"(value) : "memory");
+    }
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief Force the compiler to assume that all memory was read and written.
+ */
+inline void ClobberMemory()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/**
+ * @brief Read a cycle counter for timing single calls.
+ *
+ * The time stamp counter on x86, the virtual counter on AArch64 and CLOCK_MONOTONIC in nanoseconds elsewhere.
+ * The lfence keeps earlier instructions from being executed after the counter is read.
+ */
+inline uint64_t ReadCycles()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_lfence();
+    const uint64_t cycles = __rdtsc();
+    _mm_lfence();
+    return cycles;
+#elif defined(__aarch64__)
+    uint64_t cycles;
+    asm volatile("isb; mrs %0, cntvct_el0" : "=r"(cycles) : : "memory");
+    return cycles;
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000u + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+/**
+ * @brief Unit of the values returned by ReadCycles.
+ */
+inline const char *CycleUnit()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return "tsc";
+#elif defined(__aarch64__)
+    return "cntvct";
+#else
+    return "ns";
+#endif
+}
+
+struct Options
+{
+    double minTime = 0.2;         // Minimum measured time of a repetition in seconds
+    size_t repetitions = 5;       // The fastest repetition is reported
+    const char *filter = nullptr; // Only run benchmarks whose name contains this string
+};
+
+/**
+ * @brief Parse --min-time=<seconds>, --repetitions=<n> and --filter=<text>.
+ */
+inline Options ParseOptions(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--min-time=", 11) == 0)
+        {
+            options.minTime = atof(argv[i] + 11);
+        }
+        else if (strncmp(argv[i], "--repetitions=", 14) == 0)
+        {
+            options.repetitions = std::max<size_t>(1, strtoul(argv[i] + 14, nullptr, 10));
+        }
+        else if (strncmp(argv[i], "--filter=", 9) == 0)
+        {
+            options.filter = argv[i] + 9;
+        }
+    }
+    return options;
+}
+
+/**
+ * @brief Measure the time of a single call of operation.
+ *
+ * The number of iterations is increased until a run takes at least options.minTime, then the fastest of options.repetitions runs is reported.
+ *
+ * @param options
+ * @param benchmark - Name of the measured operation.
+ * @param shape - Name of the packet shape or variant.
+ * @param bytes - Bytes processed by a single call, used to calculate the throughput.
+ * @param operation - Callable without arguments.
+ * @return double The time of a single call in nanoseconds, or a negative value if the benchmark was filtered.
+ */
+template <typename Operation>
+double Run(const Options &options, const char *benchmark, const char *shape, size_t bytes, Operation &&operation)
+{
+    if (options.filter != nullptr)
+    {
+        char name[256];
+        snprintf(name, sizeof(name), "%s/%s", benchmark, shape);
+        if (strstr(name, options.filter) == nullptr)
+        {
+            return -1;
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto measure = [&operation](size_t iterations)
+    {
+        const auto start = clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            operation();
+            ClobberMemory();
+        }
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    size_t iterations = 1;
+    double elapsed = measure(iterations);
+    while (elapsed < options.minTime && iterations < (size_t(1) << 40))
+    {
+        const double factor = elapsed > 0 ? std::min(10.0, 1.4 * options.minTime / elapsed) : 10.0;
+        iterations = static_cast<size_t>(std::max(2.0, iterations * factor));
+        elapsed = measure(iterations);
+    }
+    for (size_t i = 1; i < options.repetitions; i++)
+    {
+        elapsed = std::min(elapsed, measure(iterations));
+    }
+
+    const double ns = elapsed * 1e9 / iterations;
+    printf("{\"benchmark\":\"%s\",\"shape\":\"%s\",\"iterations\":%zu,\"ns_per_op\":%.3f,\"bytes_per_s\":%.4g}\n", benchmark, shape, iterations, ns,
+           bytes > 0 ? bytes * 1e9 / ns : 0.0);
+    fflush(stdout);
+    return ns;
+}
+}
+#endif
@@ -0,0 +1,117 @@
+#include <random>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Conversion of raw values to engineering values with the CalibrationEngine, ns_per_op is the time per converted value.
+ *
+ * polynomial:  cubic polynomial
+ * table:       interpolated table with 16 points
+ * search:      the same table converted value by value with a binary search, as reference for per field conversion code
+ *
+ * Every curve is measured with the scalar and the native vector backend on a batch of 1024 packets in columnar form.
+ */
+
+struct AdcPacket : public TagedComPacket<2, uint32_t, std::array<uint16_t, 32>>
+{
+    AdcPacket() : TagedComPacket({0x07, 0x01})
+    {
+    }
+
+    std::array<uint16_t, 32> &Counts = get<1>(elements);
+};
+
+static const size_t BATCH = 1024;
+static const size_t POINTS = 16;
+using Layout = NumericLayout<AdcPacket>;
+
+static double raw[POINTS];
+static double engineering[POINTS];
+
+template <typename Backend>
+static void BenchCurve(const bench::Options &options, const char *benchmark, const char *shape, const CalibrationCurve<POINTS> &curve,
+                       const PacketColumns<AdcPacket, BATCH> &columns)
+{
+    CalibrationEngine<AdcPacket, POINTS, Backend> calibration;
+    calibration.SetCalibration(1, curve);
+    static PacketColumns<AdcPacket, BATCH> converted;
+    const double ns = bench::Run(options, benchmark, shape, 0, [&]
+    {
+        calibration.Convert(columns, converted);
+    });
+    if (ns > 0)
+    {
+        printf("{\"benchmark\":\"%s_per_value\",\"shape\":\"%s\",\"ns_per_op\":%.3f}\n", benchmark, shape, ns / (BATCH * Layout::ValueCount));
+    }
+}
+
+static double Search(double value)
+{
+    const double *upper = std::upper_bound(raw, raw + POINTS, value);
+    if (upper == raw)
+    {
+        return engineering[0];
+    }
+    if (upper == raw + POINTS)
+    {
+        return engineering[POINTS - 1];
+    }
+    const size_t i = static_cast<size_t>(upper - raw);
+    return engineering[i - 1] + (value - raw[i - 1]) * (engineering[i] - engineering[i - 1]) / (raw[i] - raw[i - 1]);
+}
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> counts(0, 4095);
+    static PacketColumns<AdcPacket, BATCH> columns;
+    AdcPacket packet;
+    for (size_t i = 0; i < BATCH; i++)
+    {
+        for (auto &count : packet.Counts)
+        {
+            count = static_cast<uint16_t>(counts(generator));
+        }
+        columns.Append(packet);
+    }
+
+    // A thermistor like curve
+    for (size_t i = 0; i < POINTS; i++)
+    {
+        raw[i] = i * 4096.0 / (POINTS - 1);
+        engineering[i] = 150 - 200 * (static_cast<double>(i) / (POINTS - 1)) * (static_cast<double>(i) / (POINTS - 1));
+    }
+    CalibrationCurve<POINTS> polynomial;
+    polynomial.SetPolynomial({-40, 0.05, 1e-6, -2e-10});
+    CalibrationCurve<POINTS> table;
+    table.SetTable(raw, engineering, POINTS);
+
+    BenchCurve<simd::Scalar>(options, "polynomial", "scalar", polynomial, columns);
+    BenchCurve<simd::Native>(options, "polynomial", "native", polynomial, columns);
+    BenchCurve<simd::Scalar>(options, "table", "scalar", table, columns);
+    BenchCurve<simd::Native>(options, "table", "native", table, columns);
+
+    static PacketColumns<AdcPacket, BATCH> converted;
+    const double ns = bench::Run(options, "search", "scalar", 0, [&]
+    {
+        for (size_t value = 0; value < Layout::ValueCount; value++)
+        {
+            const double *input = columns.Column(value);
+            double *output = converted.Column(value);
+            for (size_t i = 0; i < columns.GetCount(); i++)
+            {
+                output[i] = Search(input[i]);
+            }
+        }
+    });
+    if (ns > 0)
+    {
+        printf("{\"benchmark\":\"search_per_value\",\"shape\":\"scalar\",\"ns_per_op\":%.3f}\n", ns / (BATCH * Layout::ValueCount));
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+#ifdef BASECOM_HAVE_JSONCPP
+#include <json/json.h>
+#endif
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Text export of decoded packets, ns_per_op is the time per packet.
+ *
+ * csv_row:       format a housekeeping packet with 33 numeric columns as CSV row with CsvWriter
+ * csv_ostream:   the same row written with an ostringstream, as reference for iostream based exporters
+ * csv_export:    decode and format a capture of 4096 packets with CsvExport, on one thread and split into 4 segments
+ * json_object:   format the packet as JSON object with JsonWriter
+ * json_jsoncpp:  the same object built as Json::Value and written with JsonCpp, if the library was found
+ */
+
+struct HousekeepingPacket : public TagedComPacket<2, uint32_t, std::array<float, 16>, std::array<int16_t, 8>, std::array<double, 8>>
+{
+    static constexpr std::array<const char *, 4> FieldNames = {{"sequence", "temperature", "current", "voltage"}};
+
+    HousekeepingPacket() : TagedComPacket({0x0A, 0x01})
+    {
+    }
+
+    std::array<float, 16> &Temperatures = get<1>(elements);
+    std::array<int16_t, 8> &Currents = get<2>(elements);
+    std::array<double, 8> &Voltages = get<3>(elements);
+};
+
+static const size_t PACKETS = 4096;
+
+static void WriteStream(std::ostringstream &stream, uint64_t timestamp, HousekeepingPacket &packet)
+{
+    stream << timestamp << ',' << get<0>(packet.GetElements());
+    stream << std::setprecision(9);
+    for (float value : packet.Temperatures)
+    {
+        stream << ',' << value;
+    }
+    for (int16_t value : packet.Currents)
+    {
+        stream << ',' << value;
+    }
+    stream << std::setprecision(17);
+    for (double value : packet.Voltages)
+    {
+        stream << ',' << value;
+    }
+    stream << '\n';
+}
+
+#ifdef BASECOM_HAVE_JSONCPP
+template <typename Array>
+static Json::Value MakeArray(const Array &values)
+{
+    Json::Value array(Json::arrayValue);
+    for (const auto &value : values)
+    {
+        array.append(value);
+    }
+    return array;
+}
+
+static std::string WriteJsonCpp(const Json::StreamWriterBuilder &builder, HousekeepingPacket &packet)
+{
+    Json::Value object(Json::objectValue);
+    object["sequence"] = get<0>(packet.GetElements());
+    object["temperature"] = MakeArray(packet.Temperatures);
+    object["current"] = MakeArray(packet.Currents);
+    object["voltage"] = MakeArray(packet.Voltages);
+    return Json::writeString(builder, object);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> temperature(-40, 85);
+    std::uniform_int_distribution<int> current(-2000, 2000);
+    std::uniform_real_distribution<double> voltage(26, 30);
+    std::vector<HousekeepingPacket> packets(PACKETS);
+    std::vector<uint8_t> capture(PACKETS * (CAPTURE_RECORD_HEADER_LENGTH + HousekeepingPacket::GetMaxSize()));
+    size_t captureLength = 0;
+    for (size_t i = 0; i < PACKETS; i++)
+    {
+        HousekeepingPacket &packet = packets[i];
+        get<0>(packet.GetElements()) = static_cast<uint32_t>(i);
+        for (auto &value : packet.Temperatures)
+        {
+            value = temperature(generator);
+        }
+        for (auto &value : packet.Currents)
+        {
+            value = static_cast<int16_t>(current(generator));
+        }
+        for (auto &value : packet.Voltages)
+        {
+            value = voltage(generator);
+        }
+        std::array<uint8_t, HousekeepingPacket::GetMaxSize()> serialized;
+        packet.Serialize(serialized);
+        captureLength += WriteCaptureRecord(&capture[captureLength], capture.size() - captureLength, 1000000 * i, serialized.data(), serialized.size());
+    }
+
+    const CsvWriter<HousekeepingPacket> writer;
+    static char line[1024];
+    size_t index = 0;
+    size_t bytes = 0;
+    bench::Run(options, "csv_row", "housekeeping", 0, [&]
+    {
+        bytes += writer.WriteRow(line, sizeof(line), 1000000 * index, packets[index]);
+        bench::DoNotOptimize(line);
+        index = (index + 1) % PACKETS;
+    });
+    std::ostringstream stream;
+    bench::Run(options, "csv_ostream", "housekeeping", 0, [&]
+    {
+        stream.str(std::string());
+        WriteStream(stream, 1000000 * index, packets[index]);
+        bench::DoNotOptimize(stream);
+        index = (index + 1) % PACKETS;
+    });
+
+    const CsvExport<HousekeepingPacket> csv(writer);
+    static char buffers[4 * 65536];
+    const double single = bench::Run(options, "csv_export_raw", "single", 0, [&]
+    {
+        bench::DoNotOptimize(csv.Export(CaptureSegment{capture.data(), captureLength}, buffers, 65536, [&](const char *text, size_t length)
+        {
+            bytes += length;
+            bench::DoNotOptimize(text);
+        }));
+    });
+    CaptureSegment segments[4];
+    const size_t count = SplitCapture(capture.data(), captureLength, segments, 4);
+    const double parallel = bench::Run(options, "csv_export_raw", "parallel4", 0, [&]
+    {
+        bench::DoNotOptimize(csv.ExportParallel(segments, count, buffers, 65536, 4, [](size_t, const char *text, size_t)
+        {
+            bench::DoNotOptimize(text);
+        }));
+    });
+    if (single > 0)
+    {
+        printf("{\"benchmark\":\"csv_export\",\"shape\":\"single\",\"ns_per_op\":%.3f,\"packets_per_s\":%.4g}\n", single / PACKETS, PACKETS * 1e9 / single);
+    }
+    if (parallel > 0)
+    {
+        printf("{\"benchmark\":\"csv_export\",\"shape\":\"parallel4\",\"ns_per_op\":%.3f,\"packets_per_s\":%.4g}\n", parallel / PACKETS, PACKETS * 1e9 / parallel);
+    }
+
+    bench::Run(options, "json_object", "housekeeping", 0, [&]
+    {
+        bytes += WriteJson(line, sizeof(line), packets[index]);
+        bench::DoNotOptimize(line);
+        index = (index + 1) % PACKETS;
+    });
+#ifdef BASECOM_HAVE_JSONCPP
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    builder["precision"] = 9;
+    bench::Run(options, "json_jsoncpp", "housekeeping", 0, [&]
+    {
+        const std::string json = WriteJsonCpp(builder, packets[index]);
+        bytes += json.size();
+        bench::DoNotOptimize(json);
+        index = (index + 1) % PACKETS;
+    });
+#endif
+    bench::DoNotOptimize(bytes);
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <random>
+#include <string>
+#include <vector>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Dropping packets by the value of a field, ns_per_op is the time per packet.
+ *
+ * unserialize:  decode every packet and compare the decoded field, the cost without a filter
+ * predicate:    check every packet with a FieldPredicate on the serialized bytes
+ * batch:        check 1024 fixed length packets that are stored one after the other, with the scalar and the native vector backend
+ *
+ * The status packets have a fixed length, the log packets have a string in front of the filtered field. About 1 of 8 packets matches.
+ */
+
+enum Mode : uint8_t
+{
+    MODE_NOMINAL = 0,
+    MODE_SAFE = 1
+};
+
+struct StatusPacket : public TagedComPacket<2, uint64_t, uint8_t, std::array<float, 12>, std::array<uint16_t, 8>>
+{
+    StatusPacket() : TagedComPacket({0x08, 0x01})
+    {
+    }
+
+    uint8_t &Mode = get<1>(elements);
+    std::array<float, 12> &Temperatures = get<2>(elements);
+};
+
+struct LogPacket : public TagedComPacket<2, uint32_t, std::string, int32_t>
+{
+    LogPacket() : TagedComPacket({0x08, 0x02})
+    {
+    }
+
+    std::string &Text = get<1>(elements);
+    int32_t &Code = get<2>(elements);
+};
+
+static const size_t PACKETS = 1024;
+static const size_t STRIDE = StatusPacket::GetMaxSize();
+
+template <typename Backend>
+static void BenchBatch(const bench::Options &options, const char *shape, const uint8_t *packets)
+{
+    const FieldPredicate<StatusPacket, 1, Backend> safe(RawCompare::Equal, MODE_SAFE);
+    static uint64_t matches[PACKETS / 64];
+    const double ns = bench::Run(options, "batch_raw", shape, 0, [&]
+    {
+        bench::DoNotOptimize(safe.Evaluate(packets, STRIDE, PACKETS, matches));
+    });
+    if (ns > 0)
+    {
+        printf("{\"benchmark\":\"batch\",\"shape\":\"%s\",\"ns_per_op\":%.3f,\"packets_per_s\":%.4g}\n", shape, ns / PACKETS, PACKETS * 1e9 / ns);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> mode(0, 7);
+    static std::array<uint8_t, STRIDE> status[PACKETS];
+    std::vector<std::vector<uint8_t>> logs(PACKETS);
+    StatusPacket statusPacket;
+    LogPacket logPacket;
+    for (size_t i = 0; i < PACKETS; i++)
+    {
+        get<0>(statusPacket.GetElements()) = i;
+        statusPacket.Mode = mode(generator) == 0 ? MODE_SAFE : MODE_NOMINAL;
+        statusPacket.Temperatures.fill(static_cast<float>(i));
+        statusPacket.Serialize(status[i]);
+
+        logPacket.Text = "Event " + std::to_string(i) + " in subsystem " + std::to_string(i % 13);
+        logPacket.Code = mode(generator) == 0 ? -1 : 0;
+        std::array<uint8_t, 256> buffer;
+        logs[i].assign(buffer.begin(), buffer.begin() + logPacket.Serialize(buffer));
+    }
+
+    size_t index = 0;
+    size_t matched = 0;
+    StatusPacket decodedStatus;
+    bench::Run(options, "unserialize", "status", 0, [&]
+    {
+        StatusPacket::PacketBase::Unserialize(status[index].data() + 2, STRIDE - 2, decodedStatus);
+        matched += decodedStatus.Mode == MODE_SAFE;
+        index = (index + 1) % PACKETS;
+    });
+    const FieldPredicate<StatusPacket, 1> safe(RawCompare::Equal, MODE_SAFE);
+    bench::Run(options, "predicate", "status", 0, [&]
+    {
+        matched += safe(status[index].data(), STRIDE);
+        index = (index + 1) % PACKETS;
+    });
+
+    LogPacket decodedLog;
+    bench::Run(options, "unserialize", "log", 0, [&]
+    {
+        LogPacket::PacketBase::Unserialize(logs[index].data() + 2, logs[index].size() - 2, decodedLog);
+        matched += decodedLog.Code < 0;
+        index = (index + 1) % PACKETS;
+    });
+    const FieldPredicate<LogPacket, 2> failed(RawCompare::Less, 0);
+    bench::Run(options, "predicate", "log", 0, [&]
+    {
+        matched += failed(logs[index].data(), logs[index].size());
+        index = (index + 1) % PACKETS;
+    });
+    bench::DoNotOptimize(matched);
+
+    BenchBatch<simd::Scalar>(options, "scalar", status[0].data());
+    BenchBatch<simd::Native>(options, "native", status[0].data());
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <atomic>
+#include <thread>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Cost of recording to a Histogram and of the latency instrumentation of a packet.
+ *
+ * record:           a single thread records pseudo random values of up to 20 bits to the histogram
+ * record_contended: a second thread records to the same histogram at the same time
+ * snapshot:         copy the buckets and calculate the 99th percentile
+ * unserialize:      decode a packet without, with counting and with latency instrumentation
+ */
+
+template <typename Policy>
+struct StatusPacket : public BasicTagedComPacket<Policy, 2, uint64_t, uint32_t, std::array<int16_t, 8>>
+{
+    StatusPacket() : BasicTagedComPacket<Policy, 2, uint64_t, uint32_t, std::array<int16_t, 8>>({0x04, 0x01})
+    {
+    }
+};
+
+template <typename Policy>
+static void BenchUnserialize(const bench::Options &options, const char *shape)
+{
+    StatusPacket<Policy> packet;
+    std::array<uint8_t, 64> buffer;
+    const size_t length = packet.Serialize(buffer);
+    bench::Run(options, "unserialize", shape, length, [&]
+    {
+        auto result = StatusPacket<Policy>::PacketBase::Unserialize(buffer.data() + 2, length - 2, packet);
+        bench::DoNotOptimize(result);
+    });
+}
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+
+    static Histogram<> histogram;
+    uint64_t value = 12345;
+    bench::Run(options, "record", "histogram", 0, [&]
+    {
+        histogram.Record(value >> 44);
+        value = value * 0x9E3779B97F4A7C15ULL + 1;
+    });
+
+    atomic<bool> stop(false);
+    thread other([&stop]()
+    {
+        uint64_t otherValue = 7;
+        while (!stop.load(memory_order_relaxed))
+        {
+            histogram.Record(otherValue >> 44);
+            otherValue = otherValue * 0x9E3779B97F4A7C15ULL + 1;
+        }
+    });
+    bench::Run(options, "record_contended", "histogram", 0, [&]
+    {
+        histogram.Record(value >> 44);
+        value = value * 0x9E3779B97F4A7C15ULL + 1;
+    });
+    stop.store(true);
+    other.join();
+
+    bench::Run(options, "snapshot", "histogram", 0, [&]
+    {
+        bench::DoNotOptimize(histogram.Snapshot().Percentile(99));
+    });
+
+    BenchUnserialize<NoInstrumentation>(options, "status");
+    BenchUnserialize<CountingInstrumentation<>>(options, "status_counted");
+    BenchUnserialize<LatencyInstrumentation<>>(options, "status_timed");
+    return 0;
+}
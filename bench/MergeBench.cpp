@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "StreamMerge.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Benchmark of the k-way merge of timestamped capture streams.
+ *
+ * For every input count a set of in memory captures with increasing random timestamps is generated and merged, the fastest of
+ * --repetitions merges is reported. ordered is false if the merged stream isn't sorted or packets were lost.
+ *
+ * Options: --repetitions=<n> --filter=<text>
+ */
+
+static const size_t PACKETS_PER_RUN = 1u << 21;
+static const size_t PACKET_LENGTH = 32;
+
+static uint64_t xorshift(uint64_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+template <size_t inputs>
+static void RunMerge(const bench::Options &options)
+{
+    char shape[32];
+    snprintf(shape, sizeof(shape), "inputs%zu", inputs);
+    char name[64];
+    snprintf(name, sizeof(name), "merge/%s", shape);
+    if (options.filter != nullptr && strstr(name, options.filter) == nullptr)
+    {
+        return;
+    }
+
+    const size_t packetsPerInput = PACKETS_PER_RUN / inputs;
+    vector<vector<uint8_t>> captures(inputs);
+    array<uint8_t, PACKET_LENGTH> packet;
+    packet.fill(0xAA);
+    uint64_t seed = 0x1234567 + inputs;
+    for (auto &capture : captures)
+    {
+        capture.resize(packetsPerInput * (CAPTURE_RECORD_HEADER_LENGTH + PACKET_LENGTH));
+        uint64_t timestamp = xorshift(seed) % 1000;
+        size_t offset = 0;
+        for (size_t i = 0; i < packetsPerInput; i++)
+        {
+            timestamp += 1 + xorshift(seed) % 2000;
+            offset += WriteCaptureRecord(&capture[offset], capture.size() - offset, timestamp, packet.data(), packet.size());
+        }
+    }
+
+    double seconds = 0;
+    size_t count = 0;
+    bool ordered = true;
+    for (size_t repetition = 0; repetition < options.repetitions; repetition++)
+    {
+        array<CaptureReader, inputs> readers;
+        array<CaptureReader *, inputs> sources;
+        for (size_t i = 0; i < inputs; i++)
+        {
+            readers[i] = CaptureReader(captures[i].data(), captures[i].size());
+            sources[i] = &readers[i];
+        }
+
+        const auto start = chrono::steady_clock::now();
+        StreamMerger<CaptureReader, inputs> merger(sources.data(), inputs);
+        uint64_t last = 0;
+        size_t bytes = 0;
+        count = merger.Drain([&](const PacketView &view)
+        {
+            ordered &= view.timestamp >= last;
+            last = view.timestamp;
+            bytes += view.length;
+        });
+        const auto stop = chrono::steady_clock::now();
+        ordered &= count == inputs * packetsPerInput && bytes == count * PACKET_LENGTH;
+        const double elapsed = chrono::duration<double>(stop - start).count();
+        seconds = repetition == 0 ? elapsed : std::min(seconds, elapsed);
+    }
+
+    printf("{\"benchmark\":\"merge\",\"shape\":\"%s\",\"packets\":%zu,\"ns_per_op\":%.3f,\"packets_per_s\":%.4g,\"ordered\":%s}\n", shape, count,
+           seconds * 1e9 / count, count / seconds, ordered ? "true" : "false");
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+    RunMerge<2>(options);
+    RunMerge<4>(options);
+    RunMerge<8>(options);
+    RunMerge<16>(options);
+    RunMerge<32>(options);
+    RunMerge<64>(options);
+    return 0;
+}
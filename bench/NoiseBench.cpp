@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Robustness of the receive path on a noisy link.
+ *
+ * A stream of framed packets (see framing::WriteFrame) of a mix of packet types is impaired with random bit errors, bursts of random
+ * bytes or dropped bytes and pushed into a StreamDeframer, every extracted frame is dispatched and decoded:
+ *
+ * framed:    throughput of the receive path in MB/s, pushed in chunks of 4096 bytes, and the accounting of a byte wise pass:
+ *            frames_ok    frames received unchanged
+ *            false_accept frames that passed the CRC but differ from every sent frame, false_accept_rate per sent frame
+ *            resync_*     bytes from the end of an impairment to the end of the next frame received unchanged
+ *            decode_*     cycles of a dispatch and decode call, to check that the cost stays bounded on corrupted data
+ * datagram:  the same packets without framing, as delivered by a datagram transport without checksum, damaged by the TrafficGenerator.
+ *            ns_per_packet is the dispatch and decode time, false_accept counts damaged packets that decoded as valid.
+ *
+ * Options: --packets=<count> --repetitions=<n> --filter=<text>
+ */
+
+#ifdef USE_ETL
+using EventText = etl::string<64>;
+#else
+using EventText = std::string;
+#endif
+
+struct StatusPacket : public TagedComPacket<2, uint64_t, uint32_t, std::array<int16_t, 8>, Bitfield<12>, float>
+{
+    StatusPacket() : TagedComPacket({0x0C, 0x01})
+    {
+    }
+};
+
+struct EventPacket : public TagedComPacket<2, uint64_t, uint16_t, EventText>
+{
+    EventPacket() : TagedComPacket({0x0C, 0x02})
+    {
+    }
+};
+
+struct HousekeepingPacket : public TagedComPacket<2, uint32_t, std::array<float, 24>, std::array<uint16_t, 16>>
+{
+    HousekeepingPacket() : TagedComPacket({0x0C, 0x03})
+    {
+    }
+};
+
+using Generator = TrafficGenerator<StatusPacket, EventPacket, HousekeepingPacket>;
+using Dispatcher = PacketDispatcher<StatusPacket, EventPacket, HousekeepingPacket>;
+
+static const size_t MAX_PAYLOAD_LENGTH = 256;
+
+/**
+ * Impairments of the link, the rates are the expected number of events per bit or byte.
+ */
+struct Impairment
+{
+    const char *name;
+    double bitErrorRate;
+    double burstRate;
+    size_t burstLength;
+    double dropRate;
+    size_t dropLength;
+};
+
+static const Impairment IMPAIRMENTS[] = {
+    {"clean", 0, 0, 0, 0, 0},
+    {"ber_1e-6", 1e-6, 0, 0, 0, 0},
+    {"ber_1e-5", 1e-5, 0, 0, 0, 0},
+    {"ber_1e-4", 1e-4, 0, 0, 0, 0},
+    {"ber_1e-3", 1e-3, 0, 0, 0, 0},
+    {"burst_16", 0, 1e-4, 16, 0, 0},
+    {"burst_256", 0, 1e-5, 256, 0, 0},
+    {"drop_1", 0, 0, 0, 1e-4, 1},
+    {"drop_64", 0, 0, 0, 1e-5, 64},
+};
+
+/**
+ * @brief Number of positions in front of the next event, geometric distributed.
+ */
+static uint64_t NextDistance(utils::TrafficRandom &random, double rate)
+{
+    if (rate <= 0)
+    {
+        return UINT64_MAX / 2;
+    }
+    return static_cast<uint64_t>(std::floor(std::log(1.0 - random.Uniform()) / std::log1p(-rate)));
+}
+
+/**
+ * @brief Copy the stream with the impairment applied.
+ *
+ * @param events - The positions in the impaired stream behind every impairment.
+ */
+static void Impair(const std::vector<uint8_t> &clean, const Impairment &impairment, uint64_t seed, std::vector<uint8_t> &out,
+                   std::vector<size_t> &events)
+{
+    utils::TrafficRandom random(seed);
+    out.clear();
+    events.clear();
+    uint64_t nextFlip = NextDistance(random, impairment.bitErrorRate);
+    uint64_t nextBurst = NextDistance(random, impairment.burstRate);
+    uint64_t nextDrop = NextDistance(random, impairment.dropRate);
+    size_t i = 0;
+    while (i < clean.size())
+    {
+        if (i >= nextDrop)
+        {
+            i += impairment.dropLength;
+            events.push_back(out.size());
+            nextDrop = i + NextDistance(random, impairment.dropRate);
+            continue;
+        }
+        if (i >= nextBurst)
+        {
+            for (size_t k = 0; k < impairment.burstLength && i < clean.size(); k++, i++)
+            {
+                out.push_back(static_cast<uint8_t>(random.Next()));
+            }
+            events.push_back(out.size());
+            nextBurst = i + NextDistance(random, impairment.burstRate);
+            continue;
+        }
+        uint8_t byte = clean[i];
+        bool flipped = false;
+        while (nextFlip < 8 * (i + 1))
+        {
+            byte ^= static_cast<uint8_t>(1 << (nextFlip % 8));
+            nextFlip += 1 + NextDistance(random, impairment.bitErrorRate);
+            flipped = true;
+        }
+        out.push_back(byte);
+        if (flipped)
+        {
+            events.push_back(out.size());
+        }
+        i++;
+    }
+}
+
+static uint64_t timerOverhead = 0;
+
+/**
+ * @brief Check if the benchmark path/impairment matches the --filter option.
+ */
+static bool Selected(const bench::Options &options, const char *path, const char *impairment)
+{
+    char name[128];
+    snprintf(name, sizeof(name), "%s/%s", path, impairment);
+    return options.filter == nullptr || strstr(name, options.filter) != nullptr;
+}
+
+static void BenchFramed(const bench::Options &options, const std::vector<uint8_t> &clean, const std::unordered_set<uint64_t> &sent,
+                        size_t frameCount, const Impairment &impairment)
+{
+    if (!Selected(options, "framed", impairment.name))
+    {
+        return;
+    }
+    std::vector<uint8_t> stream;
+    std::vector<size_t> events;
+    Impair(clean, impairment, 1, stream, events);
+    static Dispatcher dispatcher;
+    size_t decoded = 0;
+    auto decode = [&decoded](const uint8_t *payload, size_t length)
+    {
+        decoded += dispatcher.Dispatch(payload, length, [](auto &packet) { bench::DoNotOptimize(packet); }) ? 1 : 0;
+    };
+
+    // Throughput of the receive path
+    double best = 1e300;
+    for (size_t repetition = 0; repetition < options.repetitions; repetition++)
+    {
+        static StreamDeframer<MAX_PAYLOAD_LENGTH> deframer;
+        deframer.Reset();
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < stream.size(); offset += 4096)
+        {
+            deframer.Push(&stream[offset], std::min<size_t>(4096, stream.size() - offset), decode);
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // Byte wise pass, every frame is checked against the sent frames and its decoding is timed
+    static StreamDeframer<MAX_PAYLOAD_LENGTH> deframer;
+    deframer = StreamDeframer<MAX_PAYLOAD_LENGTH>();
+    Histogram<> decodeCycles;
+    std::vector<size_t> goodEnds;
+    size_t falseAccepts = 0;
+    size_t position = 0;
+    auto check = [&](const uint8_t *payload, size_t length)
+    {
+        if (sent.count(utils::hashBytes(payload, length)) != 0)
+        {
+            goodEnds.push_back(position + 1);
+        }
+        else
+        {
+            falseAccepts++;
+        }
+        const uint64_t begin = bench::ReadCycles();
+        decode(payload, length);
+        bench::ClobberMemory();
+        const uint64_t elapsed = bench::ReadCycles() - begin;
+        decodeCycles.Record(elapsed > timerOverhead ? elapsed - timerOverhead : 0);
+    };
+    for (position = 0; position < stream.size(); position++)
+    {
+        deframer.Push(&stream[position], 1, check);
+    }
+
+    // Resynchronization after every impairment
+    Histogram<> resync;
+    size_t next = 0;
+    for (const size_t event : events)
+    {
+        while (next < goodEnds.size() && goodEnds[next] <= event)
+        {
+            next++;
+        }
+        if (next < goodEnds.size())
+        {
+            resync.Record(goodEnds[next] - event);
+        }
+    }
+    const auto decodes = decodeCycles.Snapshot();
+    const auto resyncs = resync.Snapshot();
+    printf("{\"benchmark\":\"noise\",\"path\":\"framed\",\"impairment\":\"%s\",\"bytes\":%zu,\"mb_per_s\":%.1f,\"events\":%zu,\"frames_sent\":%zu,"
+           "\"frames_ok\":%zu,\"crc_errors\":%llu,\"skipped_bytes\":%llu,\"false_accept\":%zu,\"false_accept_rate\":%.3g,"
+           "\"resync_mean_bytes\":%.0f,\"resync_p99_bytes\":%llu,\"resync_max_bytes\":%llu,\"unit\":\"%s\",\"decode_p999\":%llu,\"decode_max\":%llu}\n",
+           impairment.name, stream.size(), stream.size() / best / 1e6, events.size(), frameCount, goodEnds.size(),
+           static_cast<unsigned long long>(deframer.GetErrorCount()), static_cast<unsigned long long>(deframer.GetSkippedBytes()), falseAccepts,
+           static_cast<double>(falseAccepts) / frameCount, resyncs.Mean(), static_cast<unsigned long long>(resyncs.Percentile(99)),
+           static_cast<unsigned long long>(resyncs.Max()), bench::CycleUnit(), static_cast<unsigned long long>(decodes.Percentile(99.9)),
+           static_cast<unsigned long long>(decodes.Max()));
+    fflush(stdout);
+    bench::DoNotOptimize(decoded);
+}
+
+static void BenchDatagram(const bench::Options &options, size_t packets, const char *name, double bitErrorRate, double truncateProbability)
+{
+    if (!Selected(options, "datagram", name))
+    {
+        return;
+    }
+    TrafficOptions traffic;
+    traffic.fill = TrafficFill::Pattern;
+    traffic.bitErrorRate = bitErrorRate;
+    traffic.truncateProbability = truncateProbability;
+    Generator generator(traffic);
+    static Dispatcher dispatcher;
+    std::vector<uint8_t> buffer(packets * MAX_PAYLOAD_LENGTH);
+    std::vector<GeneratedPacket> infos(packets);
+    for (size_t i = 0; i < packets; i++)
+    {
+        generator.Generate(&buffer[i * MAX_PAYLOAD_LENGTH], MAX_PAYLOAD_LENGTH, &infos[i]);
+    }
+    auto dispatch = [&buffer, &infos](size_t i)
+    {
+        return dispatcher.Dispatch(&buffer[i * MAX_PAYLOAD_LENGTH], infos[i].length, [](auto &packet) { bench::DoNotOptimize(packet); });
+    };
+
+    double best = 1e300;
+    for (size_t repetition = 0; repetition < options.repetitions; repetition++)
+    {
+        size_t valid = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < packets; i++)
+        {
+            valid += dispatch(i) ? 1 : 0;
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        bench::DoNotOptimize(valid);
+    }
+
+    Histogram<> decodeCycles;
+    size_t damaged = 0;
+    size_t falseAccepts = 0;
+    size_t rejected = 0;
+    for (size_t i = 0; i < packets; i++)
+    {
+        const bool damage = infos[i].flippedBits > 0 || infos[i].length < infos[i].serializedLength;
+        const uint64_t begin = bench::ReadCycles();
+        const bool valid = dispatch(i);
+        bench::ClobberMemory();
+        const uint64_t elapsed = bench::ReadCycles() - begin;
+        decodeCycles.Record(elapsed > timerOverhead ? elapsed - timerOverhead : 0);
+        damaged += damage ? 1 : 0;
+        falseAccepts += damage && valid ? 1 : 0;
+        rejected += valid ? 0 : 1;
+    }
+    const auto decodes = decodeCycles.Snapshot();
+    printf("{\"benchmark\":\"noise\",\"path\":\"datagram\",\"impairment\":\"%s\",\"packets\":%zu,\"ns_per_packet\":%.1f,\"damaged\":%zu,"
+           "\"rejected\":%zu,\"false_accept\":%zu,\"false_accept_rate\":%.3g,\"unit\":\"%s\",\"decode_p999\":%llu,\"decode_max\":%llu}\n",
+           name, packets, best * 1e9 / packets, damaged, rejected, falseAccepts, static_cast<double>(falseAccepts) / packets, bench::CycleUnit(),
+           static_cast<unsigned long long>(decodes.Percentile(99.9)), static_cast<unsigned long long>(decodes.Max()));
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+    size_t packets = 20000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--packets=", 10) == 0)
+        {
+            packets = std::max<size_t>(1, strtoul(argv[i] + 10, nullptr, 10));
+        }
+    }
+    timerOverhead = UINT64_MAX;
+    for (size_t i = 0; i < 10000; i++)
+    {
+        const uint64_t start = bench::ReadCycles();
+        timerOverhead = std::min(timerOverhead, bench::ReadCycles() - start);
+    }
+
+    // The clean stream and the hashes of all sent frames
+    TrafficOptions traffic;
+    traffic.fill = TrafficFill::Pattern;
+    Generator generator(traffic);
+    std::vector<uint8_t> clean(packets * (MAX_PAYLOAD_LENGTH + framing::OVERHEAD));
+    std::unordered_set<uint64_t> sent;
+    size_t length = 0;
+    uint8_t payload[MAX_PAYLOAD_LENGTH];
+    for (size_t i = 0; i < packets; i++)
+    {
+        const size_t payloadLength = generator.Generate(payload, sizeof(payload));
+        sent.insert(utils::hashBytes(payload, payloadLength));
+        length += framing::WriteFrame(&clean[length], clean.size() - length, payload, payloadLength);
+    }
+    clean.resize(length);
+
+    for (const Impairment &impairment : IMPAIRMENTS)
+    {
+        BenchFramed(options, clean, sent, packets, impairment);
+    }
+    BenchDatagram(options, packets, "clean", 0, 0);
+    BenchDatagram(options, packets, "ber_1e-5", 1e-5, 0);
+    BenchDatagram(options, packets, "ber_1e-4", 1e-4, 0);
+    BenchDatagram(options, packets, "ber_1e-3", 1e-3, 0);
+    BenchDatagram(options, packets, "truncate_10", 0, 0.1);
+    return 0;
+}
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "BaseCom.hpp"
+#include "Framing.hpp"
+#include "Dispatcher.hpp"
+#include "SpscQueue.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * End to end benchmark of a receive path.
+ *
+ * producer thread:  builds a mix of packet types, serializes and frames them and writes them to a socketpair
+ * reader thread:    reads the stream and extracts the frames
+ * decoder thread:   dispatches the frames by id and decodes them
+ * consumer thread:  takes the decoded packets and records the latency from the send timestamp in the packet
+ *
+ * The threads are connected with lock free queues. Without --rate the producer sends as fast as possible and the latency includes
+ * the queueing delay of a saturated pipeline, with --rate=<packets per second> the producer is paced.
+ *
+ * Options: --packets=<count> --rate=<packets per second>
+ */
+
+#ifdef USE_ETL
+using EventText = etl::string<48>;
+#else
+using EventText = std::string;
+#endif
+
+struct HousekeepingPacket : public TagedComPacket<2, uint64_t, uint32_t, std::array<int16_t, 16>, uint8_t>
+{
+    HousekeepingPacket() : TagedComPacket({0x01, 0x01})
+    {
+    }
+
+    uint64_t &Timestamp = get<0>(elements);
+    uint32_t &Counter = get<1>(elements);
+    std::array<int16_t, 16> &Temperatures = get<2>(elements);
+    uint8_t &Mode = get<3>(elements);
+};
+
+struct AttitudePacket : public TagedComPacket<2, uint64_t, std::array<float, 4>, std::array<float, 3>>
+{
+    AttitudePacket() : TagedComPacket({0x01, 0x02})
+    {
+    }
+
+    uint64_t &Timestamp = get<0>(elements);
+    std::array<float, 4> &Quaternion = get<1>(elements);
+    std::array<float, 3> &Rates = get<2>(elements);
+};
+
+struct EventPacket : public TagedComPacket<2, uint64_t, uint16_t, EventText>
+{
+    EventPacket() : TagedComPacket({0x01, 0x03})
+    {
+    }
+
+    uint64_t &Timestamp = get<0>(elements);
+    uint16_t &Code = get<1>(elements);
+    EventText &Text = get<2>(elements);
+};
+
+struct BulkPacket : public TagedComPacket<2, uint64_t, std::array<uint8_t, 200>>
+{
+    BulkPacket() : TagedComPacket({0x01, 0x04})
+    {
+    }
+
+    uint64_t &Timestamp = get<0>(elements);
+    std::array<uint8_t, 200> &Data = get<1>(elements);
+};
+
+static const size_t MAX_PACKET_LENGTH = 256;
+
+struct FrameSlot
+{
+    uint16_t length; // 0 marks the end of the stream
+    std::array<uint8_t, MAX_PACKET_LENGTH> data;
+};
+
+struct DecodedSlot
+{
+    uint64_t timestamp; // 0 marks the end of the stream
+    uint8_t type;
+};
+
+static uint64_t NowNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename Queue, typename T>
+static void BlockingPush(Queue &queue, const T &element)
+{
+    while (!queue.TryPush(element))
+    {
+        this_thread::yield();
+    }
+}
+
+template <typename Packet, size_t bufferLength>
+static size_t AppendFrame(const Packet &packet, std::array<uint8_t, bufferLength> &stream, size_t fill)
+{
+    std::array<uint8_t, MAX_PACKET_LENGTH> serialized;
+    const size_t length = packet.Serialize(serialized);
+    return fill + framing::WriteFrame(&stream[fill], stream.size() - fill, serialized.data(), length);
+}
+
+static void Producer(int fd, size_t packets, double rate)
+{
+    HousekeepingPacket housekeeping;
+    AttitudePacket attitude;
+    EventPacket event;
+    BulkPacket bulk;
+    housekeeping.Temperatures.fill(215);
+    attitude.Quaternion = {1.0f, 0.0f, 0.0f, 0.0f};
+    event.Text = "Heater switched on";
+    bulk.Data.fill(0x55);
+
+    static const size_t BATCH = 16;
+    std::array<uint8_t, BATCH * (MAX_PACKET_LENGTH + framing::OVERHEAD)> stream;
+    const uint64_t start = NowNs();
+    size_t sent = 0;
+    bool failed = false;
+    while (sent < packets && !failed)
+    {
+        if (rate > 0)
+        {
+            const uint64_t due = start + static_cast<uint64_t>(sent * 1e9 / rate);
+            while (NowNs() < due)
+            {
+            }
+        }
+        const size_t batch = rate > 0 ? 1 : std::min(BATCH, packets - sent);
+        size_t fill = 0;
+        for (size_t i = 0; i < batch; i++, sent++)
+        {
+            const uint64_t now = NowNs();
+            switch (sent % 4)
+            {
+            case 0:
+                housekeeping.Timestamp = now;
+                housekeeping.Counter = static_cast<uint32_t>(sent);
+                fill = AppendFrame(housekeeping, stream, fill);
+                break;
+            case 1:
+                attitude.Timestamp = now;
+                fill = AppendFrame(attitude, stream, fill);
+                break;
+            case 2:
+                event.Timestamp = now;
+                event.Code = static_cast<uint16_t>(sent);
+                fill = AppendFrame(event, stream, fill);
+                break;
+            default:
+                bulk.Timestamp = now;
+                fill = AppendFrame(bulk, stream, fill);
+                break;
+            }
+        }
+        size_t written = 0;
+        while (written < fill)
+        {
+            const ssize_t result = write(fd, &stream[written], fill - written);
+            if (result <= 0)
+            {
+                // The reader must still see the end of the stream, otherwise it blocks in read
+                failed = true;
+                break;
+            }
+            written += static_cast<size_t>(result);
+        }
+    }
+    shutdown(fd, SHUT_WR);
+}
+
+template <typename Queue>
+static void Reader(int fd, Queue &frames, uint64_t &errors)
+{
+    StreamDeframer<MAX_PACKET_LENGTH> deframer;
+    std::array<uint8_t, 65536> buffer;
+    FrameSlot end = {};
+    for (;;)
+    {
+        const ssize_t result = read(fd, buffer.data(), buffer.size());
+        if (result <= 0)
+        {
+            break;
+        }
+        deframer.Push(buffer.data(), static_cast<size_t>(result), [&frames](const uint8_t *payload, size_t length)
+        {
+            FrameSlot *slot;
+            while ((slot = frames.BeginPush()) == nullptr)
+            {
+                this_thread::yield();
+            }
+            slot->length = static_cast<uint16_t>(length);
+            memcpy(slot->data.data(), payload, length);
+            frames.CommitPush();
+        });
+    }
+    errors = deframer.GetErrorCount();
+    BlockingPush(frames, end);
+}
+
+template <typename FrameQueue, typename DecodedQueue>
+static void Decoder(FrameQueue &frames, DecodedQueue &decoded, uint64_t &errors)
+{
+    PacketDispatcher<HousekeepingPacket, AttitudePacket, EventPacket, BulkPacket> dispatcher;
+    for (;;)
+    {
+        const FrameSlot *frame;
+        while ((frame = frames.Front()) == nullptr)
+        {
+            this_thread::yield();
+        }
+        if (frame->length == 0)
+        {
+            break;
+        }
+        const size_t type = dispatcher.Lookup(frame->data.data(), frame->length);
+        dispatcher.Dispatch(frame->data.data(), frame->length, [&decoded, type](const auto &packet)
+        {
+            BlockingPush(decoded, DecodedSlot{packet.Timestamp, static_cast<uint8_t>(type)});
+        });
+        frames.Pop();
+    }
+    errors = dispatcher.GetUnknownCount() + dispatcher.GetInvalidCount();
+    BlockingPush(decoded, DecodedSlot{0, 0});
+}
+
+template <typename Queue>
+static void Consumer(Queue &decoded, vector<uint64_t> &latencies, std::array<uint64_t, 4> &perType)
+{
+    DecodedSlot slot;
+    for (;;)
+    {
+        while (!decoded.TryPop(slot))
+        {
+            this_thread::yield();
+        }
+        if (slot.timestamp == 0)
+        {
+            break;
+        }
+        latencies.push_back(NowNs() - slot.timestamp);
+        perType[slot.type]++;
+    }
+}
+
+static uint64_t Percentile(const vector<uint64_t> &sorted, double percentile)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(percentile / 100.0 * sorted.size()));
+    return sorted[index];
+}
+
+int main(int argc, char **argv)
+{
+    size_t packets = 2000000;
+    double rate = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--packets=", 10) == 0)
+        {
+            packets = strtoull(argv[i] + 10, nullptr, 10);
+        }
+        else if (strncmp(argv[i], "--rate=", 7) == 0)
+        {
+            rate = atof(argv[i] + 7);
+        }
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        perror("socketpair");
+        return 1;
+    }
+
+    static SpscQueue<FrameSlot, 4096> frames;
+    static SpscQueue<DecodedSlot, 4096> decoded;
+    vector<uint64_t> latencies;
+    latencies.reserve(packets);
+    std::array<uint64_t, 4> perType = {};
+    uint64_t framingErrors = 0;
+    uint64_t decodeErrors = 0;
+
+    const uint64_t start = NowNs();
+    thread consumer(Consumer<decltype(decoded)>, ref(decoded), ref(latencies), ref(perType));
+    thread decoder(Decoder<decltype(frames), decltype(decoded)>, ref(frames), ref(decoded), ref(decodeErrors));
+    thread reader(Reader<decltype(frames)>, fds[1], ref(frames), ref(framingErrors));
+    thread producer(Producer, fds[0], packets, rate);
+    producer.join();
+    reader.join();
+    decoder.join();
+    consumer.join();
+    const double seconds = (NowNs() - start) / 1e9;
+    close(fds[0]);
+    close(fds[1]);
+
+    sort(latencies.begin(), latencies.end());
+    printf("{\"benchmark\":\"pipeline\",\"packets\":%zu,\"received\":%zu,\"rate_limit\":%.0f,\"seconds\":%.3f,\"packets_per_s\":%.0f,"
+           "\"latency_p50_ns\":%llu,\"latency_p99_ns\":%llu,\"latency_p999_ns\":%llu,\"latency_max_ns\":%llu,"
+           "\"per_type\":[%llu,%llu,%llu,%llu],\"framing_errors\":%llu,\"decode_errors\":%llu}\n",
+           packets, latencies.size(), rate, seconds, latencies.size() / seconds,
+           static_cast<unsigned long long>(Percentile(latencies, 50)), static_cast<unsigned long long>(Percentile(latencies, 99)),
+           static_cast<unsigned long long>(Percentile(latencies, 99.9)), static_cast<unsigned long long>(latencies.empty() ? 0 : latencies.back()),
+           static_cast<unsigned long long>(perType[0]), static_cast<unsigned long long>(perType[1]), static_cast<unsigned long long>(perType[2]),
+           static_cast<unsigned long long>(perType[3]), static_cast<unsigned long long>(framingErrors), static_cast<unsigned long long>(decodeErrors));
+    return latencies.size() == packets ? 0 : 1;
+}
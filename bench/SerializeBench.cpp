@@ -0,0 +1,235 @@
+#include <cstring>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Microbenchmarks of Serialize, Unserialize, CheckIDMatch and GetSerializedLength for representative packet shapes.
+ *
+ * Every shape is compared against a memcpy of the same number of bytes as lower bound,
+ * the plain shape additionally against a hand written field by field memcpy.
+ * Without ETL the string shapes use std::string. The plain_counted shape is the plain shape with CountingInstrumentation.
+ * SerializeBenchTable is built with USE_TABLE_SERIALIZER, its shapes are suffixed with /table.
+ */
+
+#ifdef USE_TABLE_SERIALIZER
+#define SERIALIZER_MODE "/table"
+#else
+#define SERIALIZER_MODE ""
+#endif
+
+#ifdef USE_ETL
+using SmallString = etl::string<10>;
+using LongString = etl::string<32>;
+#else
+using SmallString = std::string;
+using LongString = std::string;
+#endif
+
+struct PlainTestField : public ComPacket<uint8_t, uint16_t, int, long>
+{
+    uint8_t &var1 = get<0>(elements);
+    uint16_t &var2 = get<1>(elements);
+    int &var3 = get<2>(elements);
+    long &var4 = get<3>(elements);
+};
+
+// The plain shape with counters, to measure the cost of the instrumentation
+struct CountedTestField : public BasicComPacket<CountingInstrumentation<>, uint8_t, uint16_t, int, long>
+{
+    uint8_t &var1 = get<0>(elements);
+    uint16_t &var2 = get<1>(elements);
+    int &var3 = get<2>(elements);
+    long &var4 = get<3>(elements);
+};
+
+struct TestBitfield : public Bitfield<1>
+{
+};
+
+struct LargeBitField : public Bitfield<70>
+{
+};
+
+struct MixedDataMessage : public ComPacket<int32_t, SmallString, TestBitfield, LargeBitField, std::array<uint8_t, 10>>
+{
+    int &Testfield1 = get<0>(elements);
+    SmallString &Testfield2 = get<1>(elements);
+    TestBitfield &Testfield3 = get<2>(elements);
+    LargeBitField &Testfield4 = get<3>(elements);
+    std::array<uint8_t, 10> &TestArray = get<4>(elements);
+};
+
+struct LargeArrayPacket : public ComPacket<uint32_t, std::array<uint16_t, 512>>
+{
+    uint32_t &Counter = get<0>(elements);
+    std::array<uint16_t, 512> &Samples = get<1>(elements);
+};
+
+struct StringPacket : public ComPacket<LongString, LongString, LongString, LongString, uint32_t>
+{
+    LongString &Name = get<0>(elements);
+    LongString &Unit = get<1>(elements);
+    LongString &Description = get<2>(elements);
+    LongString &Source = get<3>(elements);
+    uint32_t &Flags = get<4>(elements);
+};
+
+struct LargeBitfieldPacket : public ComPacket<Bitfield<4096>, Bitfield<13>>
+{
+    Bitfield<4096> &Flags = get<0>(elements);
+    Bitfield<13> &Status = get<1>(elements);
+};
+
+// A typical housekeeping packet of a catalog with many scalar fields
+struct WidePacket : public ComPacket<uint32_t, uint16_t, uint16_t, int16_t, int16_t, int16_t, int16_t, float, float, float, float, float, float,
+                                     uint8_t, uint8_t, uint8_t, uint8_t, uint32_t, uint32_t, double, double, int32_t, int32_t, uint64_t>
+{
+    uint32_t &Counter = get<0>(elements);
+    float &Voltage = get<7>(elements);
+};
+
+static const std::array<uint8_t, 2> PacketID = {2, 3};
+
+template <typename Packet>
+constexpr size_t BufferLength()
+{
+    if constexpr (Packet::SupportsMaxSize)
+    {
+        return Packet::GetMaxSize() + PacketID.size();
+    }
+    else
+    {
+        return 512;
+    }
+}
+
+template <typename Packet>
+static void BenchShape(const bench::Options &options, const char *shape, const Packet &packet)
+{
+    const size_t bufferLength = BufferLength<Packet>();
+    std::array<uint8_t, bufferLength> buffer = {};
+    const size_t length = packet.Serialize(buffer, PacketID);
+
+    bench::Run(options, "serialize", shape, length, [&]
+    {
+        bench::DoNotOptimize(packet.Serialize(buffer, PacketID));
+    });
+
+    Packet out;
+    bench::Run(options, "unserialize", shape, length, [&]
+    {
+        auto result = Packet::template Unserialize<bufferLength>(buffer.cbegin() + PacketID.size(), buffer.cend(), length - PacketID.size(), out);
+        bench::DoNotOptimize(result);
+    });
+
+    bench::Run(options, "check_id_match", shape, PacketID.size(), [&]
+    {
+        auto result = Packet::CheckIDMatch(buffer, length, PacketID);
+        bench::DoNotOptimize(result);
+    });
+
+    bench::Run(options, "get_serialized_length", shape, 0, [&]
+    {
+        bench::DoNotOptimize(packet.GetSerializedLength());
+    });
+
+    std::array<uint8_t, bufferLength> copy = {};
+    bench::Run(options, "memcpy_baseline", shape, length, [&]
+    {
+        memcpy(copy.data(), buffer.data(), length);
+        bench::DoNotOptimize(copy);
+    });
+}
+
+/**
+ * Hand written serialization of the plain shape, the best case for a packet with the same fields.
+ */
+static void BenchPlainBaseline(const bench::Options &options)
+{
+    struct Plain
+    {
+        uint8_t var1;
+        uint16_t var2;
+        int var3;
+        long var4;
+    } plain = {1, 2, 3, 4};
+    std::array<uint8_t, 2 + sizeof(uint8_t) + sizeof(uint16_t) + sizeof(int) + sizeof(long)> buffer;
+    const size_t length = buffer.size();
+
+    bench::Run(options, "serialize_baseline", "plain", length, [&]
+    {
+        uint8_t *out = buffer.data();
+        memcpy(out, PacketID.data(), 2);
+        memcpy(out + 2, &plain.var1, sizeof(plain.var1));
+        memcpy(out + 3, &plain.var2, sizeof(plain.var2));
+        memcpy(out + 5, &plain.var3, sizeof(plain.var3));
+        memcpy(out + 5 + sizeof(int), &plain.var4, sizeof(plain.var4));
+        bench::DoNotOptimize(buffer);
+    });
+
+    Plain out;
+    bench::Run(options, "unserialize_baseline", "plain", length, [&]
+    {
+        const uint8_t *in = buffer.data();
+        memcpy(&out.var1, in + 2, sizeof(out.var1));
+        memcpy(&out.var2, in + 3, sizeof(out.var2));
+        memcpy(&out.var3, in + 5, sizeof(out.var3));
+        memcpy(&out.var4, in + 5 + sizeof(int), sizeof(out.var4));
+        bench::DoNotOptimize(out);
+    });
+}
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+
+    PlainTestField plain;
+    plain.var1 = 10;
+    plain.var2 = 100;
+    plain.var3 = -1000;
+    plain.var4 = 100000;
+    BenchShape(options, "plain" SERIALIZER_MODE, plain);
+    BenchPlainBaseline(options);
+
+    CountedTestField counted;
+    counted.var1 = 10;
+    counted.var2 = 100;
+    BenchShape(options, "plain_counted" SERIALIZER_MODE, counted);
+
+    MixedDataMessage mixed;
+    mixed.Testfield1 = -10;
+    mixed.Testfield2 = "HELLO";
+    mixed.Testfield3.WriteData(0, 1, static_cast<uint8_t>(1));
+    mixed.TestArray.fill(5);
+    BenchShape(options, "mixed" SERIALIZER_MODE, mixed);
+
+    LargeArrayPacket array;
+    array.Counter = 1;
+    for (size_t i = 0; i < array.Samples.size(); i++)
+    {
+        array.Samples[i] = static_cast<uint16_t>(i);
+    }
+    BenchShape(options, "large_array" SERIALIZER_MODE, array);
+
+    StringPacket strings;
+    strings.Name = "BATTERY_VOLTAGE_MAIN_BUS";
+    strings.Unit = "V";
+    strings.Description = "Voltage of the main power bus";
+    strings.Source = "EPS";
+    strings.Flags = 3;
+    BenchShape(options, "strings" SERIALIZER_MODE, strings);
+
+    LargeBitfieldPacket bitfield;
+    bitfield.Status.WriteData(3, 2, static_cast<uint8_t>(2));
+    BenchShape(options, "large_bitfield" SERIALIZER_MODE, bitfield);
+
+    WidePacket wide;
+    wide.Counter = 7;
+    wide.Voltage = 28.1f;
+    BenchShape(options, "wide" SERIALIZER_MODE, wide);
+
+    return 0;
+}
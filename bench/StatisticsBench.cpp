@@ -0,0 +1,112 @@
+#include <random>
+#include <vector>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Cost of updating the FieldStatistics and the FieldHistory of a housekeeping packet with 201 numeric values.
+ *
+ * update:          add a single packet, with the scalar and the native vector backend
+ * update_batch:    add a batch of 256 packets in columnar form, ns_per_op is the time per packet
+ * summary:         merge the 10 buckets of the window for all values
+ * history_append:  append a packet to a history of 4096 samples with 2 pyramid levels
+ * history_read:    read the latest 1024 samples of a value, or the 256 buckets of pyramid level 1
+ */
+
+struct HousekeepingPacket : public TagedComPacket<2, uint64_t, std::array<float, 64>, std::array<int16_t, 64>, std::array<uint32_t, 64>, std::array<double, 8>>
+{
+    HousekeepingPacket() : TagedComPacket({0x06, 0x01})
+    {
+    }
+
+    std::array<float, 64> &Temperatures = get<1>(elements);
+    std::array<int16_t, 64> &Currents = get<2>(elements);
+};
+
+static const size_t BATCH = 256;
+static const uint64_t SECOND = 1000000000;
+
+template <typename Backend>
+static void BenchUpdate(const bench::Options &options, const char *shape, const std::vector<HousekeepingPacket> &packets,
+                        const PacketColumns<HousekeepingPacket, BATCH> &columns)
+{
+    static FieldStatistics<HousekeepingPacket, 10, Backend> statistics(10 * SECOND);
+    size_t index = 0;
+    uint64_t now = 0;
+    bench::Run(options, "update", shape, 0, [&]
+    {
+        statistics.Update(packets[index], now);
+        index = (index + 1) % packets.size();
+        now += 1000;
+    });
+
+    const double ns = bench::Run(options, "update_batch_raw", shape, 0, [&]
+    {
+        statistics.Update(columns, now);
+        now += 1000;
+    });
+    if (ns > 0)
+    {
+        printf("{\"benchmark\":\"update_batch\",\"shape\":\"%s\",\"ns_per_op\":%.3f,\"packets_per_s\":%.4g}\n", shape, ns / BATCH, BATCH * 1e9 / ns);
+    }
+
+    bench::Run(options, "summary", shape, 0, [&]
+    {
+        double sum = 0;
+        statistics.ForEachValue(now, [&sum](size_t, size_t, const FieldSummary &summary) { sum += summary.stddev; });
+        bench::DoNotOptimize(sum);
+    });
+}
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> temperature(10, 40);
+    std::uniform_int_distribution<int> current(-1000, 1000);
+    std::vector<HousekeepingPacket> packets(1024);
+    static PacketColumns<HousekeepingPacket, BATCH> columns;
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        HousekeepingPacket &packet = packets[i];
+        get<0>(packet.GetElements()) = i;
+        for (auto &value : packet.Temperatures)
+        {
+            value = temperature(generator);
+        }
+        for (auto &value : packet.Currents)
+        {
+            value = static_cast<int16_t>(current(generator));
+        }
+        columns.Append(packet);
+    }
+
+    BenchUpdate<simd::Scalar>(options, "scalar", packets, columns);
+    BenchUpdate<simd::Native>(options, "native", packets, columns);
+
+    static FieldHistory<HousekeepingPacket, 4096, 2, 16> history;
+    size_t index = 0;
+    uint64_t now = 0;
+    bench::Run(options, "history_append", "housekeeping", 0, [&]
+    {
+        history.Append(packets[index], now);
+        index = (index + 1) % packets.size();
+        now += 1000;
+    });
+    static uint64_t times[1024];
+    static double values[1024];
+    static double max[1024];
+    bench::Run(options, "history_read", "raw", 1024 * sizeof(double), [&]
+    {
+        bench::DoNotOptimize(history.Read(1, 5, 1024, times, values));
+    });
+    bench::Run(options, "history_read", "level1", 256 * sizeof(double) * 2, [&]
+    {
+        bench::DoNotOptimize(history.ReadLevel(1, 1, 5, 256, times, values, max));
+    });
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Throughput of the TrafficGenerator.
+ *
+ * generate:          generate and serialize a single packet, random or pattern data, of a small status packet, a housekeeping packet
+ *                    with 25 numeric values and a mix of three types with a string and a bitfield
+ * generate_errors:   the same mix with 10 % truncated packets and a bit error rate of 1e-4
+ * generate_capture:  generate a capture of 65536 packets of the mix on 1 thread and on as many threads as there are cores,
+ *                    ns_per_op is the time per packet
+ */
+
+struct StatusPacket : public TagedComPacket<2, uint8_t, uint16_t, float>
+{
+    StatusPacket() : TagedComPacket({0x0B, 0x01})
+    {
+    }
+};
+
+struct HousekeepingPacket : public TagedComPacket<2, uint32_t, std::array<float, 16>, std::array<int16_t, 8>>
+{
+    HousekeepingPacket() : TagedComPacket({0x0B, 0x02})
+    {
+    }
+};
+
+struct ModeBits : public Bitfield<12>
+{
+    static constexpr std::array<BitfieldMember, 3> Members = {{{"mode", 0, 4}, {"heater", 4, 1}, {"channel", 8, 4}}};
+};
+
+struct EventPacket : public TagedComPacket<2, uint64_t, ModeBits, std::string>
+{
+    EventPacket() : TagedComPacket({0x0B, 0x03})
+    {
+    }
+};
+
+static const size_t PACKETS = 65536;
+
+template <typename Generator>
+static void BenchGenerate(const bench::Options &options, const char *benchmark, const char *shape, Generator &generator)
+{
+    static uint8_t buffer[4096];
+    size_t bytes = 0;
+    bench::Run(options, benchmark, shape, 0, [&]
+    {
+        bytes += generator.Generate(buffer, sizeof(buffer));
+        bench::DoNotOptimize(buffer);
+    });
+    bench::DoNotOptimize(bytes);
+}
+
+int main(int argc, char **argv)
+{
+    const bench::Options options = bench::ParseOptions(argc, argv);
+
+    TrafficOptions pattern;
+    pattern.fill = TrafficFill::Pattern;
+    TrafficGenerator<StatusPacket> status;
+    TrafficGenerator<StatusPacket> statusPattern(pattern);
+    TrafficGenerator<HousekeepingPacket> housekeeping;
+    TrafficGenerator<HousekeepingPacket> housekeepingPattern(pattern);
+    TrafficGenerator<StatusPacket, HousekeepingPacket, EventPacket> mix;
+    TrafficGenerator<StatusPacket, HousekeepingPacket, EventPacket> mixPattern(pattern);
+    BenchGenerate(options, "generate", "status_random", status);
+    BenchGenerate(options, "generate", "status_pattern", statusPattern);
+    BenchGenerate(options, "generate", "housekeeping_random", housekeeping);
+    BenchGenerate(options, "generate", "housekeeping_pattern", housekeepingPattern);
+    BenchGenerate(options, "generate", "mix_random", mix);
+    BenchGenerate(options, "generate", "mix_pattern", mixPattern);
+
+    TrafficOptions errors;
+    errors.truncateProbability = 0.1;
+    errors.bitErrorRate = 1e-4;
+    TrafficGenerator<StatusPacket, HousekeepingPacket, EventPacket> noisy(errors);
+    BenchGenerate(options, "generate_errors", "mix_random", noisy);
+
+    std::vector<uint8_t> capture(PACKETS * (CAPTURE_RECORD_HEADER_LENGTH + 128));
+    std::vector<size_t> threads = {1};
+    if (std::thread::hardware_concurrency() > 1)
+    {
+        threads.push_back(std::thread::hardware_concurrency());
+    }
+    for (const size_t count : threads)
+    {
+        std::vector<CaptureSegment> segments(count);
+        char shape[32];
+        snprintf(shape, sizeof(shape), "threads%zu", count);
+        const double ns = bench::Run(options, "generate_capture_raw", shape, 0, [&]
+        {
+            bench::DoNotOptimize(mix.GenerateParallel(capture.data(), capture.size(), PACKETS, 0, 1000, segments.data(), count));
+        });
+        if (ns > 0)
+        {
+            printf("{\"benchmark\":\"generate_capture\",\"shape\":\"%s\",\"ns_per_op\":%.3f,\"packets_per_s\":%.4g}\n", shape, ns / PACKETS,
+                   PACKETS * 1e9 / ns);
+        }
+    }
+    return 0;
+}
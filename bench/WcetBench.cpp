@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "BaseCom.hpp"
+#include "BenchCommon.hpp"
+
+using namespace std;
+using namespace translib;
+
+/**
+ * Worst case execution time harness for the decode and encode paths.
+ *
+ * Every packet type is driven with adversarial inputs: strings of maximum length, unterminated strings, truncated buffers, wrong ids
+ * and random bytes. Every input is decoded a number of times, each call is timed with bench::ReadCycles and the minimum, the 99.9th
+ * percentile and the maximum are printed, followed by a summary per packet type with the spread over all inputs:
+ *
+ * {"benchmark":"wcet","packet":"event","operation":"decode","input":"max_strings","unit":"tsc","samples":20000,"min":84,"p999":120,"max":2210}
+ * {"benchmark":"wcet_summary","packet":"event","operation":"decode","unit":"tsc","best_min":30,"worst_min":88,"worst_p999":130,"worst_max":2210}
+ *
+ * The timer overhead is measured at startup and subtracted. The maximum includes interrupts and cache misses, run the harness on an
+ * isolated core for meaningful numbers. WcetBenchConstantTime is built with USE_CONSTANT_TIME_DECODE, its packet names are suffixed
+ * with /ct. With constant time decoding worst_min and best_min of the inputs that reach Unserialize should be close together.
+ *
+ * Options: --samples=<count> --filter=<text>
+ */
+
+#ifdef USE_CONSTANT_TIME_DECODE
+#define DECODE_MODE "/ct"
+#else
+#define DECODE_MODE ""
+#endif
+
+#ifdef USE_ETL
+using NameString = etl::string<32>;
+using EventString = etl::string<64>;
+#else
+using NameString = std::string;
+using EventString = std::string;
+#endif
+
+static const size_t MAX_STRING_LENGTH = 32;
+static const size_t MAX_EVENT_LENGTH = 64;
+
+struct StatusPacket : public TagedComPacket<2, uint64_t, uint32_t, std::array<int16_t, 16>, Bitfield<12>, float>
+{
+    StatusPacket() : TagedComPacket({0x03, 0x01})
+    {
+    }
+
+    uint64_t &Timestamp = get<0>(elements);
+    std::array<int16_t, 16> &Temperatures = get<2>(elements);
+};
+
+struct EventPacket : public TagedComPacket<2, uint64_t, uint16_t, EventString>
+{
+    EventPacket() : TagedComPacket({0x03, 0x02})
+    {
+    }
+
+    uint64_t &Timestamp = get<0>(elements);
+    EventString &Text = get<2>(elements);
+};
+
+struct NamesPacket : public TagedComPacket<2, NameString, NameString, NameString, NameString, uint32_t>
+{
+    NamesPacket() : TagedComPacket({0x03, 0x03})
+    {
+    }
+
+    NameString &Name = get<0>(elements);
+    NameString &Unit = get<1>(elements);
+    NameString &Description = get<2>(elements);
+    NameString &Source = get<3>(elements);
+};
+
+static const size_t BUFFER_LENGTH = 512;
+
+struct Input
+{
+    const char *name;
+    std::array<uint8_t, BUFFER_LENGTH> data;
+    size_t length;
+};
+
+struct Result
+{
+    uint64_t min;
+    uint64_t p999;
+    uint64_t max;
+};
+
+static size_t samples = 20000;
+static const char *filter = nullptr;
+static uint64_t timerOverhead = 0;
+
+static uint64_t MeasureTimerOverhead()
+{
+    uint64_t overhead = UINT64_MAX;
+    for (size_t i = 0; i < 10000; i++)
+    {
+        const uint64_t start = bench::ReadCycles();
+        const uint64_t end = bench::ReadCycles();
+        overhead = std::min(overhead, end - start);
+    }
+    return overhead;
+}
+
+/**
+ * @brief Time every call of operation and print the distribution.
+ */
+template <typename Operation>
+static Result Measure(const char *packet, const char *operation, const char *input, Operation &&call)
+{
+    std::vector<uint64_t> cycles(samples);
+    for (size_t i = 0; i < 16; i++)
+    {
+        call();
+    }
+    for (size_t i = 0; i < samples; i++)
+    {
+        const uint64_t start = bench::ReadCycles();
+        call();
+        bench::ClobberMemory();
+        const uint64_t end = bench::ReadCycles();
+        const uint64_t elapsed = end - start;
+        cycles[i] = elapsed > timerOverhead ? elapsed - timerOverhead : 0;
+    }
+    std::sort(cycles.begin(), cycles.end());
+    const Result result = {cycles.front(), cycles[std::min(samples - 1, samples * 999 / 1000)], cycles.back()};
+    printf("{\"benchmark\":\"wcet\",\"packet\":\"%s\",\"operation\":\"%s\",\"input\":\"%s\",\"unit\":\"%s\",\"samples\":%zu,"
+           "\"min\":%llu,\"p999\":%llu,\"max\":%llu}\n",
+           packet, operation, input, bench::CycleUnit(), samples, static_cast<unsigned long long>(result.min),
+           static_cast<unsigned long long>(result.p999), static_cast<unsigned long long>(result.max));
+    fflush(stdout);
+    return result;
+}
+
+static void PrintSummary(const char *packet, const char *operation, const std::vector<Result> &results)
+{
+    if (results.empty())
+    {
+        return;
+    }
+    Result worst = {0, 0, 0};
+    uint64_t bestMin = UINT64_MAX;
+    for (const Result &result : results)
+    {
+        bestMin = std::min(bestMin, result.min);
+        worst.min = std::max(worst.min, result.min);
+        worst.p999 = std::max(worst.p999, result.p999);
+        worst.max = std::max(worst.max, result.max);
+    }
+    printf("{\"benchmark\":\"wcet_summary\",\"packet\":\"%s\",\"operation\":\"%s\",\"unit\":\"%s\",\"best_min\":%llu,\"worst_min\":%llu,"
+           "\"worst_p999\":%llu,\"worst_max\":%llu}\n",
+           packet, operation, bench::CycleUnit(), static_cast<unsigned long long>(bestMin), static_cast<unsigned long long>(worst.min),
+           static_cast<unsigned long long>(worst.p999), static_cast<unsigned long long>(worst.max));
+    fflush(stdout);
+}
+
+template <typename Packet>
+static Input Serialized(const char *name, const Packet &packet)
+{
+    Input input = {name, {}, 0};
+    input.length = packet.Serialize(input.data);
+    return input;
+}
+
+/**
+ * @brief Build the adversarial inputs of a packet type.
+ *
+ * @param nominal - Packet with typical content.
+ * @param maximal - Packet with strings of maximum length.
+ * @param empty - Packet with empty strings.
+ */
+template <typename Packet>
+static std::vector<Input> BuildInputs(const Packet &nominal, const Packet &maximal, const Packet &empty)
+{
+    std::vector<Input> inputs;
+    const Input base = Serialized("nominal", nominal);
+    inputs.push_back(base);
+    inputs.push_back(Serialized("max_strings", maximal));
+    inputs.push_back(Serialized("empty_strings", empty));
+
+    // The whole buffer after the id without a string terminator
+    Input unterminated = base;
+    unterminated.name = "unterminated";
+    std::fill(unterminated.data.begin() + 2, unterminated.data.end(), 'x');
+    unterminated.length = unterminated.data.size();
+    inputs.push_back(unterminated);
+
+    Input truncated = base;
+    truncated.name = "truncated_1";
+    truncated.length = 3;
+    inputs.push_back(truncated);
+    truncated.name = "truncated_half";
+    truncated.length = 2 + (base.length - 2) / 2;
+    inputs.push_back(truncated);
+    truncated.name = "truncated_minus1";
+    truncated.length = base.length - 1;
+    inputs.push_back(truncated);
+
+    Input wrongid = base;
+    wrongid.name = "wrong_id_first";
+    wrongid.data[0] ^= 0xFF;
+    inputs.push_back(wrongid);
+    wrongid = base;
+    wrongid.name = "wrong_id_last";
+    wrongid.data[1] ^= 0xFF;
+    inputs.push_back(wrongid);
+
+    // Random payload behind a matching id
+    std::mt19937 generator(1);
+    Input random = base;
+    random.name = "random";
+    for (size_t i = 2; i < random.data.size(); i++)
+    {
+        random.data[i] = static_cast<uint8_t>(generator());
+    }
+    random.length = random.data.size();
+    inputs.push_back(random);
+    return inputs;
+}
+
+static bool Selected(const char *packet, const char *operation)
+{
+    if (filter == nullptr)
+    {
+        return true;
+    }
+    char name[128];
+    snprintf(name, sizeof(name), "%s/%s", operation, packet);
+    return strstr(name, filter) != nullptr;
+}
+
+template <typename Packet>
+static void BenchPacket(const char *name, const Packet &nominal, const Packet &maximal, const Packet &empty)
+{
+    if (Selected(name, "decode"))
+    {
+        const std::vector<Input> inputs = BuildInputs(nominal, maximal, empty);
+        std::vector<Result> results;
+        Packet packet;
+        for (const Input &input : inputs)
+        {
+            results.push_back(Measure(name, "decode", input.name, [&]
+            {
+                auto [match, data, remaining] = packet.CheckIDMatch(input.data.data(), input.length);
+                bool valid = false;
+                if (match)
+                {
+                    valid = std::get<1>(Packet::PacketBase::Unserialize(data, remaining, packet));
+                }
+                bench::DoNotOptimize(valid);
+            }));
+        }
+        PrintSummary(name, "decode", results);
+    }
+
+    if (Selected(name, "encode"))
+    {
+        std::vector<Result> results;
+        std::array<uint8_t, BUFFER_LENGTH> buffer;
+        const std::pair<const char *, const Packet *> packets[] = {{"nominal", &nominal}, {"max_strings", &maximal}, {"empty_strings", &empty}};
+        for (const auto &[input, packet] : packets)
+        {
+            results.push_back(Measure(name, "encode", input, [&, packet = packet]
+            {
+                bench::DoNotOptimize(packet->Serialize(buffer));
+            }));
+        }
+        PrintSummary(name, "encode", results);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--samples=", 10) == 0)
+        {
+            samples = std::max<size_t>(1, strtoull(argv[i] + 10, nullptr, 10));
+        }
+        else if (strncmp(argv[i], "--filter=", 9) == 0)
+        {
+            filter = argv[i] + 9;
+        }
+    }
+    timerOverhead = MeasureTimerOverhead();
+    printf("{\"benchmark\":\"wcet_timer\",\"unit\":\"%s\",\"overhead\":%llu}\n", bench::CycleUnit(), static_cast<unsigned long long>(timerOverhead));
+
+    const std::string longName(MAX_STRING_LENGTH, 'N');
+    const std::string longEvent(MAX_EVENT_LENGTH, 'E');
+
+    StatusPacket status;
+    status.Timestamp = 123456789;
+    status.Temperatures.fill(215);
+    BenchPacket("status" DECODE_MODE, status, status, status);
+
+    EventPacket event;
+    EventPacket longEventPacket;
+    EventPacket emptyEvent;
+    event.Text = "Heater switched on";
+    longEventPacket.Text = longEvent.c_str();
+    BenchPacket("event" DECODE_MODE, event, longEventPacket, emptyEvent);
+
+    NamesPacket names;
+    NamesPacket longNames;
+    NamesPacket emptyNames;
+    names.Name = "BATTERY_VOLTAGE_MAIN_BUS";
+    names.Unit = "V";
+    names.Description = "Voltage of the main power bus";
+    names.Source = "EPS";
+    longNames.Name = longName.c_str();
+    longNames.Unit = longName.c_str();
+    longNames.Description = longName.c_str();
+    longNames.Source = longName.c_str();
+    BenchPacket("names" DECODE_MODE, names, longNames, emptyNames);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Compile time and code size scaling of large packet catalogs.
+
+Generates translation units with a catalog of TagedComPacket types and a serialize/unserialize
+function for every type, compiles them and prints one JSON object per configuration:
+
+{"benchmark":"catalog","mode":"unrolled","types":100,"fields":20,"compile_s":1.9,"object_bytes":...,"text_bytes":...,"text_per_type":...}
+
+The fields cycle through arithmetic types, arrays and bitfields, so every kind of field is
+instantiated, and every packet type has a different list of fields. Run it from the repository root:
+
+    bench/catalog_scaling.py --types 1,10,100 --fields 10
+    bench/catalog_scaling.py --types 10 --fields 10,100,500
+    bench/catalog_scaling.py --types 100 --fields 20 --modes unrolled,table
+
+The table mode compiles the catalog with USE_TABLE_SERIALIZER. The text size includes the shared
+interpreter, the descriptor tables are counted in rodata_bytes.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+FIELD_TYPES = [
+    "uint8_t",
+    "uint16_t",
+    "uint32_t",
+    "float",
+    "int64_t",
+    "double",
+    "std::array<uint8_t, 4>",
+    "translib::Bitfield<5>",
+]
+
+
+def generate(types, fields):
+    lines = ['#include "BaseCom.hpp"', "", "using namespace translib;", ""]
+    for t in range(types):
+        # The first fields encode the packet number, so every packet has a different field list like in a real catalog
+        field_types = [FIELD_TYPES[(t >> (3 * f)) & 7] if f < 4 else FIELD_TYPES[(f + t) % len(FIELD_TYPES)] for f in range(fields)]
+        lines.append("struct CatalogPacket%d : public TagedComPacket<2, %s>" % (t, ", ".join(field_types)))
+        lines.append("{")
+        lines.append("    CatalogPacket%d() : TagedComPacket({%d, %d})" % (t, t >> 8, t & 0xFF))
+        lines.append("    {")
+        lines.append("    }")
+        lines.append("};")
+        lines.append("")
+        lines.append("size_t Serialize%d(const CatalogPacket%d &packet, std::array<uint8_t, %d> &buffer)" % (t, t, fields * 8 + 2))
+        lines.append("{")
+        lines.append("    return packet.Serialize(buffer);")
+        lines.append("}")
+        lines.append("")
+        lines.append("bool Unserialize%d(const uint8_t *data, size_t length, CatalogPacket%d &packet)" % (t, t))
+        lines.append("{")
+        lines.append("    auto [match, start, remaining] = packet.CheckIDMatch(data, length);")
+        lines.append("    return match && std::get<1>(CatalogPacket%d::PacketBase::Unserialize(start, remaining, packet));" % t)
+        lines.append("}")
+        lines.append("")
+    return "\n".join(lines)
+
+
+def section_sizes(objfile):
+    """Return the size of the text sections, of the read only data sections and of the whole object file."""
+    output = subprocess.run(["size", "-A", objfile], check=True, capture_output=True, text=True).stdout
+    text = 0
+    rodata = 0
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith(".text"):
+            text += int(parts[1])
+        elif len(parts) >= 2 and (parts[0].startswith(".rodata") or parts[0].startswith(".data.rel.ro")):
+            rodata += int(parts[1])
+    return text, rodata, os.path.getsize(objfile)
+
+
+def largest_symbols(objfile, count):
+    output = subprocess.run(["nm", "--size-sort", "-C", "-S", objfile], check=True, capture_output=True, text=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        match = re.match(r"^[0-9a-f]+ ([0-9a-f]+) [tTwW] (.*)$", line)
+        if match:
+            symbols.append((int(match.group(1), 16), match.group(2)))
+    symbols.sort(reverse=True)
+    return symbols[:count]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--types", default="1,10,100", help="Comma separated list of packet type counts")
+    parser.add_argument("--fields", default="10", help="Comma separated list of field counts per packet")
+    parser.add_argument("--compiler", default=os.environ.get("CXX", "c++"))
+    parser.add_argument("--flags", default="-std=c++17 -O2", help="Compiler flags")
+    parser.add_argument("--include", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "inv"))
+    parser.add_argument("--modes", default="unrolled", help="Comma separated list of serializer modes: unrolled, table")
+    parser.add_argument("--symbols", type=int, default=0, help="Print the largest symbols of every configuration")
+    parser.add_argument("--keep", action="store_true", help="Keep the generated sources")
+    args = parser.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix="basecom_catalog_")
+    configurations = [(mode, int(types), int(fields)) for types in args.types.split(",") for fields in args.fields.split(",")
+                      for mode in args.modes.split(",")]
+    for mode, types, fields in configurations:
+        source = os.path.join(workdir, "catalog_%s_%d_%d.cpp" % (mode, types, fields))
+        objfile = source[:-4] + ".o"
+        with open(source, "w") as out:
+            out.write(generate(types, fields))
+        command = [args.compiler] + args.flags.split() + ["-I", args.include, "-c", source, "-o", objfile]
+        if mode == "table":
+            command.append("-DUSE_TABLE_SERIALIZER")
+        start = time.monotonic()
+        result = subprocess.run(command, capture_output=True, text=True)
+        elapsed = time.monotonic() - start
+        if result.returncode != 0:
+            sys.stderr.write(result.stderr[:4000])
+            print(json.dumps({"benchmark": "catalog", "mode": mode, "types": types, "fields": fields, "error": "compilation failed"}))
+            continue
+        text, rodata, total = section_sizes(objfile)
+        print(json.dumps({"benchmark": "catalog", "mode": mode, "types": types, "fields": fields, "compile_s": round(elapsed, 3),
+                          "object_bytes": total, "text_bytes": text, "rodata_bytes": rodata, "text_per_type": text // types,
+                          "text_per_field": round(text / (types * fields), 1)}))
+        for size, name in largest_symbols(objfile, args.symbols):
+            print("    %8d %s" % (size, name[:160]))
+        sys.stdout.flush()
+        if not args.keep:
+            os.remove(source)
+            os.remove(objfile)
+    if not args.keep:
+        os.rmdir(workdir)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,415 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include "NumericFields.hpp"
+#include "simd.hpp"
+
+#ifndef ALARMENGINE_HPP__
+#define ALARMENGINE_HPP__
+
+namespace translib
+{
+/**
+ * @brief Limit state of a value.
+ *
+ * The bits are the results of the four limit comparisons: below the soft low limit, below the hard low limit, above the soft high limit
+ * and above the hard high limit. A NaN fails all comparisons and is Invalid.
+ */
+enum class AlarmState : uint8_t
+{
+	Nominal = 0,
+	LowWarning = 1,
+	LowAlarm = 3,
+	HighWarning = 4,
+	HighAlarm = 12,
+	Invalid = 15
+};
+
+/**
+ * @brief Soft and hard limits of a value, hardLow <= softLow <= softHigh <= hardHigh. The defaults disable the limits.
+ *
+ */
+struct AlarmLimits
+{
+	double hardLow = -std::numeric_limits<double>::infinity();
+	double softLow = -std::numeric_limits<double>::infinity();
+	double softHigh = std::numeric_limits<double>::infinity();
+	double hardHigh = std::numeric_limits<double>::infinity();
+};
+
+/**
+ * @brief A value that changed its limit state.
+ *
+ */
+struct AlarmChange
+{
+	size_t field;
+	size_t element;    // Index within an array field, 0 for other fields
+	size_t sample;     // Index of the packet within a batch, 0 for a single packet
+	AlarmState previous;
+	AlarmState state;
+	double value;
+};
+
+namespace utils
+{
+/**
+ * @brief Individual limits of the values of a block, loaded from the limit arrays.
+ *
+ * @tparam Backend
+ */
+template<class Backend>
+struct ValueLimits
+{
+	const double *hardLow;
+	const double *softLow;
+	const double *softHigh;
+	const double *hardHigh;
+
+	typename Backend::Vector HardLow(size_t i) const
+	{
+		return Backend::Load(&hardLow[i]);
+	}
+
+	typename Backend::Vector SoftLow(size_t i) const
+	{
+		return Backend::Load(&softLow[i]);
+	}
+
+	typename Backend::Vector SoftHigh(size_t i) const
+	{
+		return Backend::Load(&softHigh[i]);
+	}
+
+	typename Backend::Vector HardHigh(size_t i) const
+	{
+		return Backend::Load(&hardHigh[i]);
+	}
+};
+
+/**
+ * @brief The same limits for all values of a block, for example of a column of a batch.
+ *
+ * @tparam Backend
+ */
+template<class Backend>
+struct BroadcastLimits
+{
+	explicit BroadcastLimits(const AlarmLimits &limits)
+		: hardLow(Backend::Broadcast(limits.hardLow)), softLow(Backend::Broadcast(limits.softLow)), softHigh(Backend::Broadcast(limits.softHigh)),
+		  hardHigh(Backend::Broadcast(limits.hardHigh))
+	{
+	}
+
+	typename Backend::Vector HardLow(size_t) const
+	{
+		return hardLow;
+	}
+
+	typename Backend::Vector SoftLow(size_t) const
+	{
+		return softLow;
+	}
+
+	typename Backend::Vector SoftHigh(size_t) const
+	{
+		return softHigh;
+	}
+
+	typename Backend::Vector HardHigh(size_t) const
+	{
+		return hardHigh;
+	}
+
+	typename Backend::Vector hardLow;
+	typename Backend::Vector softLow;
+	typename Backend::Vector softHigh;
+	typename Backend::Vector hardHigh;
+};
+
+/**
+ * @brief Calculate the AlarmState of a block of 8 values.
+ *
+ * While all values are within their soft limits only the soft limits are compared.
+ *
+ * @tparam Backend - simd::Native or simd::Scalar.
+ * @tparam Limits - ValueLimits or BroadcastLimits.
+ * @param values
+ * @param limits
+ * @return uint64_t Byte i is the AlarmState of value i.
+ */
+template<class Backend, class Limits>
+static inline uint64_t classifyBlock(const double *values, const Limits &limits)
+{
+	static constexpr size_t Vectors = 8 / Backend::Width;
+	typename Backend::Vector vectors[Vectors];
+	unsigned outside = 0;
+	for (size_t j = 0; j < Vectors; j++)
+	{
+		const size_t i = j * Backend::Width;
+		vectors[j] = Backend::Load(&values[i]);
+		outside |= Backend::NotGreaterEqual(vectors[j], limits.SoftLow(i)) | Backend::NotLessEqual(vectors[j], limits.SoftHigh(i));
+	}
+	if (outside == 0)
+	{
+		return 0;
+	}
+	uint64_t states = 0;
+	for (size_t j = 0; j < Vectors; j++)
+	{
+		const size_t i = j * Backend::Width;
+		const uint64_t state = simd::spreadMask(Backend::NotGreaterEqual(vectors[j], limits.SoftLow(i))) |
+							   simd::spreadMask(Backend::NotGreaterEqual(vectors[j], limits.HardLow(i))) << 1 |
+							   simd::spreadMask(Backend::NotLessEqual(vectors[j], limits.SoftHigh(i))) << 2 |
+							   simd::spreadMask(Backend::NotLessEqual(vectors[j], limits.HardHigh(i))) << 3;
+		states |= state << (8 * i);
+	}
+	return states;
+}
+
+/**
+ * @brief Get the state of a value from the result of classifyBlock.
+ *
+ * @param states
+ * @param index - 0 to 7.
+ * @return uint8_t
+ */
+static inline uint8_t blockState(uint64_t states, size_t index)
+{
+	return static_cast<uint8_t>(states >> (8 * index));
+}
+}
+
+/**
+ * @brief Checks the numeric values of a packet type against soft and hard limits and reports only the values that changed their state.
+ *
+ * The limits are set per field index of the packet, array fields could have limits per element. All values of a packet, or all packets
+ * of a PacketColumns batch, are compared with vector instructions, the states are compared 8 at a time with the previous states, so the
+ * cost of a packet without state changes is a few instructions per value. The engine has a fixed size and doesn't allocate memory.
+ *
+ * @code
+ * AlarmEngine<HousekeepingPacket> alarms;
+ * alarms.SetLimits(2, {0, 10, 80, 100});
+ * alarms.Evaluate(packet, [](const AlarmChange &change) { ... });
+ * @endcode
+ *
+ * @tparam Packet - ComPacket or TagedComPacket with at least one numeric field.
+ * @tparam Backend - simd::Native or simd::Scalar.
+ */
+template<class Packet, class Backend = simd::Native>
+class AlarmEngine
+{
+public:
+	using Layout = NumericLayout<Packet>;
+	static_assert(Layout::ValueCount > 0, "The packet must contain at least one numeric field");
+
+	/**
+	 * @brief Number of values rounded up to a multiple of 8, the padding values are always Nominal.
+	 *
+	 */
+	static constexpr size_t PaddedCount = (Layout::ValueCount + 7) & ~size_t(7);
+	static constexpr size_t Blocks = PaddedCount / 8;
+
+	AlarmEngine()
+	{
+		for (size_t i = 0; i < PaddedCount; i++)
+		{
+			SetValueLimits(i, AlarmLimits());
+		}
+	}
+
+	/**
+	 * @brief Set the limits of all values of a field.
+	 *
+	 * @param field - Index of the field in the packet.
+	 * @param limits
+	 * @return true
+	 * @return false The field isn't numeric or the limits aren't ordered.
+	 */
+	bool SetLimits(size_t field, const AlarmLimits &limits)
+	{
+		if (Layout::FieldWidth(field) == 0 || !Ordered(limits))
+		{
+			return false;
+		}
+		for (size_t i = 0; i < Layout::FieldWidth(field); i++)
+		{
+			SetValueLimits(Layout::FieldOffset(field) + i, limits);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Set the limits of a single element of an array field.
+	 *
+	 * @param field - Index of the field in the packet.
+	 * @param element - Index in the array.
+	 * @param limits
+	 * @return true
+	 * @return false The element doesn't exist or the limits aren't ordered.
+	 */
+	bool SetLimits(size_t field, size_t element, const AlarmLimits &limits)
+	{
+		if (element >= Layout::FieldWidth(field) || !Ordered(limits))
+		{
+			return false;
+		}
+		SetValueLimits(Layout::FieldOffset(field) + element, limits);
+		return true;
+	}
+
+	/**
+	 * @brief Get the state of a value after the last evaluation.
+	 *
+	 * @param field
+	 * @param element
+	 * @return AlarmState Nominal for values that don't exist.
+	 */
+	AlarmState GetState(size_t field, size_t element = 0) const
+	{
+		if (element >= Layout::FieldWidth(field))
+		{
+			return AlarmState::Nominal;
+		}
+		return static_cast<AlarmState>(GetValueState(Layout::FieldOffset(field) + element));
+	}
+
+	/**
+	 * @brief Set all states to Nominal, the next evaluation reports all values outside their limits.
+	 *
+	 */
+	void Reset()
+	{
+		states.fill(0);
+	}
+
+	/**
+	 * @brief Check all values of a packet and call function with an AlarmChange for every value that changed its state.
+	 *
+	 * @tparam Function
+	 * @param packet
+	 * @param function
+	 * @return size_t The number of changes.
+	 */
+	template<typename Function>
+	size_t Evaluate(const Packet &packet, Function &&function)
+	{
+		Layout::Gather(packet, values.data());
+		size_t changes = 0;
+		for (size_t block = 0; block < Blocks; block++)
+		{
+			const size_t offset = block * 8;
+			const utils::ValueLimits<Backend> limits = { &hardLow[offset], &softLow[offset], &softHigh[offset], &hardHigh[offset] };
+			const uint64_t current = utils::classifyBlock<Backend>(&values[offset], limits);
+			if (current == states[block])
+			{
+				continue;
+			}
+			for (size_t i = 0; i < 8; i++)
+			{
+				const uint8_t previous = utils::blockState(states[block], i);
+				const uint8_t state = utils::blockState(current, i);
+				if (previous != state)
+				{
+					function(AlarmChange{ Layout::FieldOfValue(offset + i), Layout::ElementOfValue(offset + i), 0, static_cast<AlarmState>(previous),
+										  static_cast<AlarmState>(state), values[offset + i] });
+					changes++;
+				}
+			}
+			states[block] = current;
+		}
+		return changes;
+	}
+
+	/**
+	 * @brief Check a batch of packets in columnar form, the changes are reported in the order of the packets for every value.
+	 *
+	 * @tparam capacity
+	 * @tparam Function
+	 * @param columns
+	 * @param function
+	 * @return size_t The number of changes.
+	 */
+	template<const size_t capacity, typename Function>
+	size_t Evaluate(const PacketColumns<Packet, capacity> &columns, Function &&function)
+	{
+		size_t changes = 0;
+		const size_t count = columns.GetCount();
+		for (size_t value = 0; value < Layout::ValueCount; value++)
+		{
+			const double *column = columns.Column(value);
+			const utils::BroadcastLimits<Backend> limits(AlarmLimits{ hardLow[value], softLow[value], softHigh[value], hardHigh[value] });
+			uint8_t state = GetValueState(value);
+			for (size_t start = 0; start < count; start += 8)
+			{
+				const size_t length = std::min<size_t>(8, count - start);
+				uint64_t current;
+				if (length == 8)
+				{
+					current = utils::classifyBlock<Backend>(&column[start], limits);
+				}
+				else
+				{
+					double tail[8] = {};
+					std::copy(&column[start], &column[start] + length, tail);
+					current = utils::classifyBlock<Backend>(tail, limits);
+				}
+				// Skip 8 packets at once while the state doesn't change
+				if (current == state * 0x0101010101010101ULL)
+				{
+					continue;
+				}
+				for (size_t i = 0; i < length; i++)
+				{
+					const uint8_t next = utils::blockState(current, i);
+					if (next != state)
+					{
+						function(AlarmChange{ Layout::FieldOfValue(value), Layout::ElementOfValue(value), start + i, static_cast<AlarmState>(state),
+											  static_cast<AlarmState>(next), column[start + i] });
+						state = next;
+						changes++;
+					}
+				}
+			}
+			SetValueState(value, state);
+		}
+		return changes;
+	}
+
+private:
+	static bool Ordered(const AlarmLimits &limits)
+	{
+		return limits.hardLow <= limits.softLow && limits.softLow <= limits.softHigh && limits.softHigh <= limits.hardHigh;
+	}
+
+	uint8_t GetValueState(size_t value) const
+	{
+		return utils::blockState(states[value / 8], value % 8);
+	}
+
+	void SetValueState(size_t value, uint8_t state)
+	{
+		const size_t shift = 8 * (value % 8);
+		states[value / 8] = (states[value / 8] & ~(uint64_t(0xFF) << shift)) | (uint64_t(state) << shift);
+	}
+
+	void SetValueLimits(size_t value, const AlarmLimits &limits)
+	{
+		hardLow[value] = limits.hardLow;
+		softLow[value] = limits.softLow;
+		softHigh[value] = limits.softHigh;
+		hardHigh[value] = limits.hardHigh;
+	}
+
+	std::array<double, PaddedCount> hardLow;
+	std::array<double, PaddedCount> softLow;
+	std::array<double, PaddedCount> softHigh;
+	std::array<double, PaddedCount> hardHigh;
+	std::array<double, PaddedCount> values = {};
+	std::array<uint64_t, Blocks> states = {};  // The states of 8 values in every element, as returned by classifyBlock
+};
+}
+#endif
@@ -1,3 +1,25 @@
 #include "bitfield.hpp"
 #include "helper.hpp"
-#include "ComPacket.hpp"
\ No newline at end of file
+#include "Histogram.hpp"
+#include "Instrumentation.hpp"
+#include "ComPacket.hpp"
+#include "Deduplicator.hpp"
+#include "Capture.hpp"
+#include "StreamMerge.hpp"
+#include "Rpc.hpp"
+#include "PacketTemplate.hpp"
+#include "CanTransport.hpp"
+#include "Framing.hpp"
+#include "SpscQueue.hpp"
+#include "Dispatcher.hpp"
+#include "LinkStatistics.hpp"
+#include "LinkBudget.hpp"
+#include "AlarmEngine.hpp"
+#include "Calibration.hpp"
+#include "FieldStatistics.hpp"
+#include "FieldHistory.hpp"
+#include "RawFilter.hpp"
+#include "TextFormat.hpp"
+#include "CsvExport.hpp"
+#include "JsonExport.hpp"
+#include "TrafficGenerator.hpp"
\ No newline at end of file
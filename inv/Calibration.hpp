@@ -0,0 +1,336 @@
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <algorithm>
+#include <initializer_list>
+#include "NumericFields.hpp"
+#include "simd.hpp"
+
+#ifndef CALIBRATION_HPP__
+#define CALIBRATION_HPP__
+
+namespace translib
+{
+/**
+ * @brief Conversion of a raw value, for example ADC counts, to an engineering value.
+ *
+ * A curve is either the identity, a polynomial or a table of points that is linearly interpolated between the points and clamped to the
+ * first and last point outside of the table. The table is evaluated without search as sum of the segments, each segment adds
+ * slope * min(max(raw - start, 0), width), so a vector of values is converted without branches and gathers. The cost grows linearly
+ * with the number of points, which is limited by maxPoints.
+ *
+ * @tparam maxPoints - Maximum number of polynomial coefficients or table points.
+ */
+template<const size_t maxPoints = 16>
+class CalibrationCurve
+{
+	static_assert(maxPoints >= 2, "A calibration curve needs at least 2 points");
+
+public:
+	enum class Kind : uint8_t
+	{
+		Identity,
+		Polynomial,
+		Table
+	};
+
+	/**
+	 * @brief Set the coefficients of a polynomial.
+	 *
+	 * @param coefficients - Coefficients starting with the constant term, c0 + c1 * raw + c2 * raw^2 + ...
+	 * @param count - 1 to maxPoints.
+	 * @return true
+	 * @return false The number of coefficients is invalid, the curve isn't changed.
+	 */
+	bool SetPolynomial(const double *coefficients, size_t count)
+	{
+		if (count == 0 || count > maxPoints)
+		{
+			return false;
+		}
+		kind = Kind::Polynomial;
+		length = count;
+		std::copy(coefficients, coefficients + count, a.begin());
+		return true;
+	}
+
+	bool SetPolynomial(std::initializer_list<double> coefficients)
+	{
+		return SetPolynomial(coefficients.begin(), coefficients.size());
+	}
+
+	/**
+	 * @brief Set the points of a table.
+	 *
+	 * @param raw - Raw values of the points, strictly increasing.
+	 * @param engineering - Engineering values of the points.
+	 * @param count - 2 to maxPoints.
+	 * @return true
+	 * @return false The number of points is invalid or the raw values aren't increasing, the curve isn't changed.
+	 */
+	bool SetTable(const double *raw, const double *engineering, size_t count)
+	{
+		if (count < 2 || count > maxPoints)
+		{
+			return false;
+		}
+		for (size_t i = 1; i < count; i++)
+		{
+			if (!(raw[i] > raw[i - 1]))
+			{
+				return false;
+			}
+		}
+		kind = Kind::Table;
+		length = count - 1;
+		offset = engineering[0];
+		for (size_t i = 0; i < length; i++)
+		{
+			a[i] = raw[i];
+			b[i] = raw[i + 1] - raw[i];
+			c[i] = (engineering[i + 1] - engineering[i]) / b[i];
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Make the curve the identity again.
+	 *
+	 */
+	void SetIdentity()
+	{
+		kind = Kind::Identity;
+		length = 0;
+	}
+
+	Kind GetKind() const
+	{
+		return kind;
+	}
+
+	/**
+	 * @brief Convert a single value.
+	 *
+	 * @param raw
+	 * @return double
+	 */
+	double Evaluate(double raw) const
+	{
+		return Evaluate<simd::Scalar>(raw);
+	}
+
+	/**
+	 * @brief Convert a vector of values.
+	 *
+	 * @tparam Backend - simd::Native or simd::Scalar.
+	 * @param raw
+	 * @return Backend::Vector
+	 */
+	template<class Backend>
+	typename Backend::Vector Evaluate(typename Backend::Vector raw) const
+	{
+		typename Backend::Vector result[1];
+		Evaluate<Backend, 1>(&raw, result);
+		return result[0];
+	}
+
+	/**
+	 * @brief Convert an array of values, input and output may be the same array.
+	 *
+	 * @tparam Backend - simd::Native or simd::Scalar, the remainder that doesn't fill a vector is converted with simd::Scalar.
+	 * @param raw
+	 * @param engineering
+	 * @param count
+	 */
+	template<class Backend>
+	void Convert(const double *raw, double *engineering, size_t count) const
+	{
+		if (kind == Kind::Identity)
+		{
+			if (raw != engineering)
+			{
+				std::copy(raw, raw + count, engineering);
+			}
+			return;
+		}
+		// Independent vectors are converted together, so the latency of the additions of one vector is hidden behind the others
+		static constexpr size_t Interleave = 4;
+		using Vector = typename Backend::Vector;
+		size_t i = 0;
+		for (; i + Interleave * Backend::Width <= count; i += Interleave * Backend::Width)
+		{
+			Vector values[Interleave];
+			for (size_t j = 0; j < Interleave; j++)
+			{
+				values[j] = Backend::Load(&raw[i + j * Backend::Width]);
+			}
+			Evaluate<Backend, Interleave>(values, values);
+			for (size_t j = 0; j < Interleave; j++)
+			{
+				Backend::Store(&engineering[i + j * Backend::Width], values[j]);
+			}
+		}
+		for (; i + Backend::Width <= count; i += Backend::Width)
+		{
+			Backend::Store(&engineering[i], Evaluate<Backend>(Backend::Load(&raw[i])));
+		}
+		for (; i < count; i++)
+		{
+			engineering[i] = Evaluate(raw[i]);
+		}
+	}
+
+private:
+	template<class Backend, const size_t count>
+	void Evaluate(const typename Backend::Vector *raw, typename Backend::Vector *result) const
+	{
+		typename Backend::Vector values[count];
+		std::copy(raw, raw + count, values);
+		if (kind == Kind::Polynomial)
+		{
+			for (size_t j = 0; j < count; j++)
+			{
+				result[j] = Backend::Broadcast(a[length - 1]);
+			}
+			for (size_t i = length - 1; i > 0; i--)
+			{
+				const auto coefficient = Backend::Broadcast(a[i - 1]);
+				for (size_t j = 0; j < count; j++)
+				{
+					result[j] = Backend::Add(Backend::Multiply(result[j], values[j]), coefficient);
+				}
+			}
+		}
+		else if (kind == Kind::Table)
+		{
+			const auto zero = Backend::Broadcast(0);
+			for (size_t j = 0; j < count; j++)
+			{
+				result[j] = Backend::Broadcast(offset);
+			}
+			for (size_t i = 0; i < length; i++)
+			{
+				const auto start = Backend::Broadcast(a[i]);
+				const auto width = Backend::Broadcast(b[i]);
+				const auto slope = Backend::Broadcast(c[i]);
+				for (size_t j = 0; j < count; j++)
+				{
+					const auto position = Backend::Min(Backend::Max(Backend::Subtract(values[j], start), zero), width);
+					result[j] = Backend::Add(result[j], Backend::Multiply(position, slope));
+				}
+			}
+			// Max and Min replace NaN by the segment limits, a NaN must stay NaN like with a polynomial
+			for (size_t j = 0; j < count; j++)
+			{
+				result[j] = Backend::PropagateNaN(result[j], values[j]);
+			}
+		}
+		else
+		{
+			std::copy(values, values + count, result);
+		}
+	}
+
+	Kind kind = Kind::Identity;
+	size_t length = 0;
+	double offset = 0;
+	std::array<double, maxPoints> a = {}; // Coefficients of the polynomial or start of the segments of the table
+	std::array<double, maxPoints> b = {}; // Width of the segments
+	std::array<double, maxPoints> c = {}; // Slope of the segments
+};
+
+/**
+ * @brief Binds calibration curves to the numeric fields of a packet type and converts packets or batches of packets to engineering values.
+ *
+ * The values are numbered like in the NumericLayout of the packet, all elements of an array field share the curve of the field.
+ * Fields without a curve are copied unchanged. The engineering values of a batch are written to a second PacketColumns or converted in place.
+ *
+ * @code
+ * CalibrationEngine<HousekeepingPacket> calibration;
+ * CalibrationCurve<> thermistor;
+ * thermistor.SetTable(counts, celsius, 12);
+ * calibration.SetCalibration(1, thermistor);
+ * calibration.Convert(rawColumns, engineeringColumns);
+ * @endcode
+ *
+ * @tparam Packet - ComPacket or TagedComPacket.
+ * @tparam maxPoints - Maximum number of polynomial coefficients or table points of a curve.
+ * @tparam Backend - simd::Native or simd::Scalar.
+ */
+template<class Packet, const size_t maxPoints = 16, class Backend = simd::Native>
+class CalibrationEngine
+{
+public:
+	using Layout = NumericLayout<Packet>;
+	using Curve = CalibrationCurve<maxPoints>;
+
+	/**
+	 * @brief Bind a curve to a field, the curve is copied.
+	 *
+	 * @param field - Index of the field in the packet.
+	 * @param curve
+	 * @return true
+	 * @return false The field isn't numeric.
+	 */
+	bool SetCalibration(size_t field, const Curve &curve)
+	{
+		if (Layout::FieldWidth(field) == 0)
+		{
+			return false;
+		}
+		curves[field] = curve;
+		return true;
+	}
+
+	/**
+	 * @brief Get the curve of a field.
+	 *
+	 * @param field - Index of the field, must be below the number of fields.
+	 * @return const Curve&
+	 */
+	const Curve &GetCalibration(size_t field) const
+	{
+		return curves[field];
+	}
+
+	/**
+	 * @brief Convert the numeric values of a packet.
+	 *
+	 * @param packet
+	 * @param engineering - Output with space for Layout::ValueCount values.
+	 */
+	void Convert(const Packet &packet, double *engineering) const
+	{
+		Layout::Gather(packet, engineering);
+		for (size_t field = 0; field < Layout::FieldCount; field++)
+		{
+			if (Layout::FieldWidth(field) != 0)
+			{
+				double *values = &engineering[Layout::FieldOffset(field)];
+				curves[field].template Convert<Backend>(values, values, Layout::FieldWidth(field));
+			}
+		}
+	}
+
+	/**
+	 * @brief Convert a batch of packets in columnar form.
+	 *
+	 * @tparam capacity
+	 * @param raw
+	 * @param engineering - Output, may be the same object as raw. Gets the same number of packets as raw.
+	 */
+	template<const size_t capacity>
+	void Convert(const PacketColumns<Packet, capacity> &raw, PacketColumns<Packet, capacity> &engineering) const
+	{
+		for (size_t value = 0; value < Layout::ValueCount; value++)
+		{
+			curves[Layout::FieldOfValue(value)].template Convert<Backend>(raw.Column(value), engineering.Column(value), raw.GetCount());
+		}
+		engineering.SetCount(raw.GetCount());
+	}
+
+private:
+	std::array<Curve, Layout::FieldCount> curves;
+};
+}
+#endif
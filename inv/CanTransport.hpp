@@ -0,0 +1,544 @@
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <cassert>
+#include <array>
+#include <tuple>
+#include <algorithm>
+#include "ComPacket.hpp"
+
+#ifndef CANTRANSPORT_HPP__
+#define CANTRANSPORT_HPP__
+
+namespace translib
+{
+/**
+ * @brief A classic CAN or CAN FD frame.
+ *
+ */
+struct CanFrame
+{
+	/**
+	 * @brief Flag in the id that marks an extended 29 bit identifier, same value as CAN_EFF_FLAG of SocketCAN.
+	 *
+	 */
+	static const uint32_t ExtendedFlag = 0x80000000U;
+
+	uint32_t id;
+	uint8_t length;
+	std::array<uint8_t, 64> data;
+};
+
+namespace can
+{
+/**
+ * @brief Map the id of a TagedComPacket to a CAN identifier.
+ *
+ * The id bytes are interpreted as big endian number and added to the base identifier.
+ * Identifiers that don't fit into 11 bit are sent as extended 29 bit identifiers.
+ *
+ * @tparam idLength
+ * @param id
+ * @param base - Offset added to the id, for example to seperate subsystems on a shared bus.
+ * @return constexpr uint32_t The CAN identifier including the ExtendedFlag if needed.
+ */
+template<const size_t idLength>
+constexpr uint32_t CanIdFromPacketId(const std::array<uint8_t, idLength> &id, uint32_t base = 0)
+{
+	static_assert(idLength <= 4, "The packet id must not be longer than 4 bytes to be mapped to a CAN identifier");
+	uint32_t canid = 0;
+	for (size_t i = 0; i < idLength; i++)
+	{
+		canid = (canid << 8) | id[i];
+	}
+	canid = (canid + base) & 0x1FFFFFFFU;
+	return canid > 0x7FFU ? (canid | CanFrame::ExtendedFlag) : canid;
+}
+
+/**
+ * @brief Round the payload length of a frame up to the next length that could be encoded in a CAN FD DLC.
+ *
+ * @param length
+ * @return constexpr uint8_t
+ */
+constexpr uint8_t ValidFrameLength(size_t length)
+{
+	const uint8_t lengths[] = { 8, 12, 16, 20, 24, 32, 48, 64 };
+	if (length <= 8)
+	{
+		return static_cast<uint8_t>(length);
+	}
+	for (const auto l : lengths)
+	{
+		if (length <= l)
+		{
+			return l;
+		}
+	}
+	return 64;
+}
+}
+
+/**
+ * @brief Splits packets into CAN frames similar to ISO-TP (ISO 15765-2) and joins them again.
+ *
+ * A packet that fits into one frame is sent as single frame, longer packets as first frame followed by consecutive frames
+ * with a 4 bit sequence number. Unlike ISO-TP there are no flow control frames, the receiver must keep up with the sender.
+ * Lost or reordered frames are detected with the sequence number and the incomplete packet is dropped.
+ *
+ * @tparam frameLength - 8 for classic CAN or 64 for CAN FD.
+ */
+template<const size_t frameLength = 8>
+class IsoTpSegmenter
+{
+	static_assert(frameLength == 8 || frameLength == 64, "Only classic CAN and CAN FD frames are supported");
+
+public:
+	/**
+	 * @brief Maximum length of a packet, limited by the 12 bit length of the first frame.
+	 *
+	 */
+	static const size_t MaxPacketLength = 4095;
+
+	/**
+	 * @brief Maximum payload of a single frame.
+	 *
+	 */
+	static const size_t SingleFrameLength = frameLength == 8 ? 7 : frameLength - 2;
+
+	/**
+	 * @brief Get the number of frames that are needed to send a packet.
+	 *
+	 * @param length
+	 * @return constexpr size_t
+	 */
+	static constexpr size_t FrameCount(size_t length)
+	{
+		if (length <= SingleFrameLength)
+		{
+			return 1;
+		}
+		const size_t remaining = length - (frameLength - 2);
+		return 1 + (remaining + frameLength - 2) / (frameLength - 1);
+	}
+
+	/**
+	 * @brief Split a packet into frames.
+	 *
+	 * @param canid - Identifier of all frames.
+	 * @param data - The serialized packet.
+	 * @param length - Length of the packet.
+	 * @param frames - Output array for the frames.
+	 * @param maxframes - Size of the output array.
+	 * @return size_t The number of frames or 0 if the packet is too long or the output array too small.
+	 */
+	static size_t Segment(uint32_t canid, const uint8_t *data, size_t length, CanFrame *frames, size_t maxframes)
+	{
+		const size_t count = FrameCount(length);
+		if (length > MaxPacketLength || count > maxframes)
+		{
+			return 0;
+		}
+		if (count == 1)
+		{
+			CanFrame &frame = frames[0];
+			frame.id = canid;
+			size_t header = 1;
+			if (length <= 7)
+			{
+				frame.data[0] = static_cast<uint8_t>(length);
+			}
+			else
+			{
+				frame.data[0] = 0;
+				frame.data[1] = static_cast<uint8_t>(length);
+				header = 2;
+			}
+			memcpy(&frame.data[header], data, length);
+			Pad(frame, header + length);
+			return 1;
+		}
+
+		CanFrame &first = frames[0];
+		first.id = canid;
+		first.data[0] = static_cast<uint8_t>(0x10 | ((length >> 8) & 0x0F));
+		first.data[1] = static_cast<uint8_t>(length & 0xFF);
+		memcpy(&first.data[2], data, frameLength - 2);
+		first.length = frameLength;
+		size_t offset = frameLength - 2;
+		for (size_t i = 1; i < count; i++)
+		{
+			CanFrame &frame = frames[i];
+			const size_t chunk = std::min<size_t>(length - offset, frameLength - 1);
+			frame.id = canid;
+			frame.data[0] = static_cast<uint8_t>(0x20 | (i & 0x0F));
+			memcpy(&frame.data[1], &data[offset], chunk);
+			Pad(frame, chunk + 1);
+			offset += chunk;
+		}
+		return count;
+	}
+
+private:
+	/**
+	 * @brief Set the frame length, CAN FD frames are padded to the next valid DLC length.
+	 *
+	 * @param frame
+	 * @param used
+	 */
+	static void Pad(CanFrame &frame, size_t used)
+	{
+		const size_t length = frameLength == 8 ? used : can::ValidFrameLength(used);
+		std::fill(frame.data.begin() + used, frame.data.begin() + length, 0xCC);
+		frame.length = static_cast<uint8_t>(length);
+	}
+};
+
+/**
+ * @brief Joins the frames produced by the IsoTpSegmenter to packets.
+ *
+ * Packets of different CAN identifiers could be received interleaved, every identifier with a multi frame transfer in progress occupies one channel.
+ * If all channels are in use the oldest transfer is dropped. No memory is allocated, every channel has a buffer of maxPacketLength bytes.
+ *
+ * @tparam maxPacketLength - Maximum length of a received packet.
+ * @tparam channels - Number of transfers that could be in progress at the same time.
+ * @tparam frameLength - 8 for classic CAN or 64 for CAN FD.
+ */
+template<const size_t maxPacketLength, const size_t channels, const size_t frameLength = 8>
+class IsoTpReassembler
+{
+	static_assert(maxPacketLength <= IsoTpSegmenter<frameLength>::MaxPacketLength, "The packet length is limited to 4095 bytes");
+	static_assert(channels > 0, "At least one channel is needed");
+
+	struct Channel
+	{
+		bool active = false;
+		uint32_t canid = 0;
+		uint8_t sequence = 0;
+		size_t length = 0;
+		size_t received = 0;
+		uint64_t age = 0;
+		std::array<uint8_t, maxPacketLength> buffer;
+	};
+
+public:
+	/**
+	 * @brief Process a received frame.
+	 *
+	 * @param frame
+	 * @param data - Is set to the packet if the frame completed a packet. It stays valid until the next call to Push.
+	 * @param length - Is set to the length of the completed packet.
+	 * @return true if a packet was completed.
+	 */
+	bool Push(const CanFrame &frame, const uint8_t *&data, size_t &length)
+	{
+		if (frame.length == 0)
+		{
+			errors++;
+			return false;
+		}
+		const uint8_t type = frame.data[0] >> 4;
+		if (type == 0)
+		{
+			size_t header = 1;
+			length = frame.data[0] & 0x0F;
+			if (length == 0 && frame.length > 1)
+			{
+				length = frame.data[1];
+				header = 2;
+			}
+			if (header + length > frame.length || length > maxPacketLength)
+			{
+				errors++;
+				return false;
+			}
+			data = &frame.data[header];
+			return true;
+		}
+		else if (type == 1)
+		{
+			StartTransfer(frame);
+			return false;
+		}
+		else if (type == 2)
+		{
+			return ContinueTransfer(frame, data, length);
+		}
+		errors++;
+		return false;
+	}
+
+	/**
+	 * @brief Get the number of dropped frames and incomplete packets.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetErrorCount() const
+	{
+		return errors;
+	}
+
+private:
+	Channel *FindChannel(uint32_t canid)
+	{
+		for (auto &channel : channelList)
+		{
+			if (channel.active && channel.canid == canid)
+			{
+				return &channel;
+			}
+		}
+		return nullptr;
+	}
+
+	void StartTransfer(const CanFrame &frame)
+	{
+		const size_t length = (static_cast<size_t>(frame.data[0] & 0x0F) << 8) | frame.data[1];
+		if (length > maxPacketLength || length < frameLength - 2 || frame.length < frameLength)
+		{
+			errors++;
+			return;
+		}
+		Channel *channel = FindChannel(frame.id);
+		if (channel != nullptr)
+		{
+			errors++; // The previous transfer on this identifier was not completed
+		}
+		else
+		{
+			channel = &channelList[0];
+			for (auto &c : channelList)
+			{
+				if (!c.active)
+				{
+					channel = &c;
+					break;
+				}
+				if (c.age < channel->age)
+				{
+					channel = &c;
+				}
+			}
+			if (channel->active)
+			{
+				errors++;
+			}
+		}
+		channel->active = true;
+		channel->canid = frame.id;
+		channel->sequence = 1;
+		channel->length = length;
+		channel->received = frameLength - 2;
+		channel->age = ++clock;
+		memcpy(channel->buffer.data(), &frame.data[2], frameLength - 2);
+	}
+
+	bool ContinueTransfer(const CanFrame &frame, const uint8_t *&data, size_t &length)
+	{
+		Channel *channel = FindChannel(frame.id);
+		if (channel == nullptr)
+		{
+			errors++;
+			return false;
+		}
+		const size_t chunk = std::min<size_t>(channel->length - channel->received, frameLength - 1);
+		if ((frame.data[0] & 0x0F) != channel->sequence || frame.length < chunk + 1)
+		{
+			channel->active = false;
+			errors++;
+			return false;
+		}
+		memcpy(&channel->buffer[channel->received], &frame.data[1], chunk);
+		channel->received += chunk;
+		channel->sequence = (channel->sequence + 1) & 0x0F;
+		channel->age = ++clock;
+		if (channel->received < channel->length)
+		{
+			return false;
+		}
+		channel->active = false;
+		data = channel->buffer.data();
+		length = channel->length;
+		return true;
+	}
+
+	std::array<Channel, channels> channelList;
+	uint64_t clock = 0;
+	uint64_t errors = 0;
+};
+
+/**
+ * @brief In process stand in for a CAN bus, every sent frame is received in the same order.
+ *
+ * It provides the same batched Send and Receive interface as the SocketCanBus and could be used to test a CanPacketTransport without CAN hardware.
+ *
+ * @tparam capacity - Number of frames that could be queued.
+ */
+template<const size_t capacity>
+class CanLoopback
+{
+public:
+	/**
+	 * @brief Queue frames.
+	 *
+	 * @param frames
+	 * @param count
+	 * @return size_t The number of queued frames, less than count if the queue is full.
+	 */
+	size_t Send(const CanFrame *frames, size_t count)
+	{
+		size_t i = 0;
+		for (; i < count && fill < capacity; i++, fill++)
+		{
+			queue[(head + fill) % capacity] = frames[i];
+		}
+		return i;
+	}
+
+	/**
+	 * @brief Take queued frames.
+	 *
+	 * @param frames
+	 * @param maxcount
+	 * @return size_t The number of received frames.
+	 */
+	size_t Receive(CanFrame *frames, size_t maxcount)
+	{
+		size_t i = 0;
+		for (; i < maxcount && fill > 0; i++, fill--)
+		{
+			frames[i] = queue[head];
+			head = (head + 1) % capacity;
+		}
+		return i;
+	}
+
+private:
+	std::array<CanFrame, capacity> queue;
+	size_t head = 0;
+	size_t fill = 0;
+};
+
+/**
+ * @brief Sends and receives TagedComPackets over a CAN bus.
+ *
+ * The packet id is mapped to the CAN identifier with can::CanIdFromPacketId and only the packet data is sent in the frames.
+ * The bus is any type that provides size_t Send(const CanFrame *frames, size_t count) and size_t Receive(CanFrame *frames, size_t maxcount),
+ * like the CanLoopback or the SocketCanBus.
+ *
+ * @tparam Bus
+ * @tparam maxPacketLength - Maximum serialized length of a packet without id.
+ * @tparam channels - Number of multi frame transfers that could be received interleaved.
+ * @tparam frameLength - 8 for classic CAN or 64 for CAN FD.
+ * @tparam batchSize - Number of frames received with one call to the bus.
+ */
+template<typename Bus, const size_t maxPacketLength, const size_t channels = 4, const size_t frameLength = 8, const size_t batchSize = 32>
+class CanPacketTransport
+{
+	using Segmenter = IsoTpSegmenter<frameLength>;
+	static const size_t maxFrames = Segmenter::FrameCount(maxPacketLength);
+
+public:
+	explicit CanPacketTransport(Bus &bus, uint32_t canIdBase = 0) : bus(bus), canIdBase(canIdBase)
+	{
+	}
+
+	/**
+	 * @brief Serialize the packet and send it.
+	 *
+	 * @tparam Packet - A type derived from TagedComPacket.
+	 * @param packet
+	 * @return true if all frames were accepted by the bus.
+	 */
+	template<typename Packet>
+	bool SendPacket(const Packet &packet)
+	{
+		static_assert(Packet::SupportsMaxSize && Packet::PacketBase::GetMaxSize() <= maxPacketLength, "The packet is too long for the transport");
+		std::array<uint8_t, Packet::PacketBase::GetMaxSize()> buffer;
+		const std::array<uint8_t, 0> noid = {};
+		const size_t length = static_cast<const typename Packet::PacketBase&>(packet).Serialize(buffer, noid);
+		return Send(can::CanIdFromPacketId(packet.GetID(), canIdBase), buffer.data(), length);
+	}
+
+	/**
+	 * @brief Send raw data with the CAN identifier.
+	 *
+	 * @param canid
+	 * @param data
+	 * @param length
+	 * @return true if all frames were accepted by the bus.
+	 */
+	bool Send(uint32_t canid, const uint8_t *data, size_t length)
+	{
+		const size_t count = Segmenter::Segment(canid, data, length, frames.data(), frames.size());
+		return count > 0 && bus.Send(frames.data(), count) == count;
+	}
+
+	/**
+	 * @brief Receive the available frames and call the handler for every completed packet.
+	 *
+	 * @tparam Handler - Callable with the signature void(uint32_t canid, const uint8_t *data, size_t length).
+	 * @param handler
+	 * @return size_t The number of completed packets.
+	 */
+	template<typename Handler>
+	size_t Poll(Handler &&handler)
+	{
+		size_t packets = 0;
+		size_t received = bus.Receive(receivedFrames.data(), batchSize);
+		while (received > 0)
+		{
+			for (size_t i = 0; i < received; i++)
+			{
+				const uint8_t *data;
+				size_t length;
+				if (reassembler.Push(receivedFrames[i], data, length))
+				{
+					handler(receivedFrames[i].id, data, length);
+					packets++;
+				}
+			}
+			received = received < batchSize ? 0 : bus.Receive(receivedFrames.data(), batchSize);
+		}
+		return packets;
+	}
+
+	/**
+	 * @brief Deserialize a received packet if the CAN identifier matches the id of the packet.
+	 *
+	 * @tparam Packet - A type derived from TagedComPacket.
+	 * @param canid
+	 * @param data
+	 * @param length
+	 * @param packet
+	 * @return true if the identifier matched and the data could be valid.
+	 */
+	template<typename Packet>
+	bool Decode(uint32_t canid, const uint8_t *data, size_t length, Packet &packet) const
+	{
+		if (canid != can::CanIdFromPacketId(packet.GetID(), canIdBase))
+		{
+			return false;
+		}
+		return std::get<1>(Packet::PacketBase::Unserialize(data, length, packet));
+	}
+
+	/**
+	 * @brief Get the number of dropped frames and incomplete packets.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetErrorCount() const
+	{
+		return reassembler.GetErrorCount();
+	}
+
+private:
+	Bus &bus;
+	uint32_t canIdBase;
+	std::array<CanFrame, maxFrames> frames;
+	std::array<CanFrame, batchSize> receivedFrames;
+	IsoTpReassembler<maxPacketLength, channels, frameLength> reassembler;
+};
+}
+#endif
@@ -0,0 +1,194 @@
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <array>
+
+#ifndef CAPTURE_HPP__
+#define CAPTURE_HPP__
+
+namespace translib
+{
+/**
+ * @brief View on a timestamped serialized packet.
+ *
+ * The view doesn't own the data, it points into the memory of the source that produced it.
+ *
+ */
+struct PacketView
+{
+	uint64_t timestamp;
+	const uint8_t *data;
+	size_t length;
+};
+
+/**
+ * @brief Length of the header in front of every record in a capture.
+ *
+ * Every record consists of the receive timestamp as uint64, the packet length as uint32 and the serialized packet.
+ * The header fields are stored in host byte order without padding.
+ *
+ */
+static const size_t CAPTURE_RECORD_HEADER_LENGTH = sizeof(uint64_t) + sizeof(uint32_t);
+
+/**
+ * @brief Append a packet as record to a capture buffer.
+ *
+ * @param out - Next free byte in the capture buffer.
+ * @param space - Free bytes in the capture buffer.
+ * @param timestamp - The receive timestamp of the packet.
+ * @param data - The serialized packet.
+ * @param length - Length of the serialized packet.
+ * @return size_t The number of written bytes or 0 if the record doesn't fit into the buffer.
+ */
+static inline size_t WriteCaptureRecord(uint8_t *out, size_t space, uint64_t timestamp, const uint8_t *data, size_t length)
+{
+	if (length > UINT32_MAX || space < CAPTURE_RECORD_HEADER_LENGTH + length)
+	{
+		return 0;
+	}
+	const uint32_t recordlength = static_cast<uint32_t>(length);
+	memcpy(out, &timestamp, sizeof(timestamp));
+	memcpy(out + sizeof(timestamp), &recordlength, sizeof(recordlength));
+	memcpy(out + CAPTURE_RECORD_HEADER_LENGTH, data, length);
+	return CAPTURE_RECORD_HEADER_LENGTH + length;
+}
+
+/**
+ * @brief A part of a capture that starts at a record.
+ *
+ */
+struct CaptureSegment
+{
+	const uint8_t *data;
+	size_t length;
+};
+
+/**
+ * @brief Split a capture at record boundaries into segments of about the same length, for example to process them on several threads.
+ *
+ * Only the record headers are read. A truncated record at the end stays in the last segment.
+ *
+ * @param data - The capture.
+ * @param length
+ * @param segments - Output for the segments.
+ * @param count - Maximum number of segments.
+ * @return size_t The number of segments, less than count if the capture has less records.
+ */
+static inline size_t SplitCapture(const uint8_t *data, size_t length, CaptureSegment *segments, size_t count)
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+	size_t segment = 0;
+	size_t start = 0;
+	size_t offset = 0;
+	while (segment + 1 < count && length - offset >= CAPTURE_RECORD_HEADER_LENGTH)
+	{
+		uint32_t recordlength;
+		memcpy(&recordlength, &data[offset + sizeof(uint64_t)], sizeof(recordlength));
+		if (length - offset - CAPTURE_RECORD_HEADER_LENGTH < recordlength)
+		{
+			break;
+		}
+		offset += CAPTURE_RECORD_HEADER_LENGTH + recordlength;
+		// Segment i ends at the first record boundary behind (i + 1) / count of the capture
+		if (offset >= (length / count) * (segment + 1))
+		{
+			segments[segment++] = CaptureSegment { &data[start], offset - start };
+			start = offset;
+		}
+	}
+	if (start < length)
+	{
+		segments[segment++] = CaptureSegment { &data[start], length - start };
+	}
+	return segment;
+}
+
+/**
+ * @brief Reads the records of a capture stored in memory, for example a memory mapped archive file.
+ *
+ * The returned views point directly into the capture memory, no packet data is copied.
+ * Reading stops at the end of the capture or at the first truncated record.
+ *
+ */
+class CaptureReader
+{
+public:
+	CaptureReader() : CaptureReader(nullptr, 0)
+	{
+	}
+
+	CaptureReader(const uint8_t *data, size_t length) : data(data), length(length), offset(0)
+	{
+	}
+
+	/**
+	 * @brief Read the next record.
+	 *
+	 * @param view - Is set to the record if one is available.
+	 * @return true if a record was read, false at the end of the capture.
+	 */
+	bool Next(PacketView &view)
+	{
+		if (length - offset < CAPTURE_RECORD_HEADER_LENGTH)
+		{
+			return false;
+		}
+		uint32_t recordlength;
+		memcpy(&view.timestamp, &data[offset], sizeof(view.timestamp));
+		memcpy(&recordlength, &data[offset + sizeof(view.timestamp)], sizeof(recordlength));
+		if (length - offset - CAPTURE_RECORD_HEADER_LENGTH < recordlength)
+		{
+			return false;
+		}
+		view.data = &data[offset + CAPTURE_RECORD_HEADER_LENGTH];
+		view.length = recordlength;
+		offset += CAPTURE_RECORD_HEADER_LENGTH + recordlength;
+		return true;
+	}
+
+	/**
+	 * @brief Read up to maxcount records at once.
+	 *
+	 * @param views - Output array for the records.
+	 * @param maxcount - Size of the output array.
+	 * @return size_t The number of read records, 0 at the end of the capture.
+	 */
+	size_t Pull(PacketView *views, size_t maxcount)
+	{
+		size_t i = 0;
+		while (i < maxcount && Next(views[i]))
+		{
+			i++;
+		}
+		return i;
+	}
+
+	/**
+	 * @brief Start reading from the first record again.
+	 *
+	 */
+	void Rewind()
+	{
+		offset = 0;
+	}
+
+	/**
+	 * @brief Get the number of bytes consumed from the capture.
+	 *
+	 * @return size_t
+	 */
+	size_t GetOffset() const
+	{
+		return offset;
+	}
+
+private:
+	const uint8_t *data;
+	size_t length;
+	size_t offset;
+};
+}
+#endif
@@ -0,0 +1,420 @@
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <atomic>
+#include <algorithm>
+#include "Capture.hpp"
+#include "Histogram.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#endif
+
+#ifndef CAPTUREREPLAY_HPP__
+#define CAPTUREREPLAY_HPP__
+
+#ifdef __linux__
+namespace translib
+{
+/**
+ * @brief A capture file mapped read only into memory.
+ *
+ * The pages are read on demand by the kernel, so replaying or exporting a capture larger than the memory needs no copy and no buffer.
+ *
+ */
+class MappedCapture
+{
+public:
+	MappedCapture() = default;
+	MappedCapture(const MappedCapture&) = delete;
+	MappedCapture& operator=(const MappedCapture&) = delete;
+
+	~MappedCapture()
+	{
+		Close();
+	}
+
+	/**
+	 * @brief Map a capture file.
+	 *
+	 * @param path
+	 * @return true on success, false otherwise. errno holds the reason of the failure.
+	 */
+	bool Open(const char *path)
+	{
+		Close();
+		const int fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+		{
+			return false;
+		}
+		struct stat status;
+		if (fstat(fd, &status) != 0)
+		{
+			const int error = errno;
+			close(fd);
+			errno = error;
+			return false;
+		}
+		length = static_cast<size_t>(status.st_size);
+		if (length > 0)
+		{
+			void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapping == MAP_FAILED)
+			{
+				const int error = errno;
+				close(fd);
+				length = 0;
+				errno = error;
+				return false;
+			}
+			// The records are read once from the start to the end
+			madvise(mapping, length, MADV_SEQUENTIAL);
+			data = static_cast<const uint8_t*>(mapping);
+		}
+		close(fd);
+		return true;
+	}
+
+	void Close()
+	{
+		if (data != nullptr)
+		{
+			munmap(const_cast<uint8_t*>(data), length);
+		}
+		data = nullptr;
+		length = 0;
+	}
+
+	const uint8_t* GetData() const
+	{
+		return data;
+	}
+
+	size_t GetLength() const
+	{
+		return length;
+	}
+
+	CaptureSegment GetSegment() const
+	{
+		return CaptureSegment { data, length };
+	}
+
+private:
+	const uint8_t *data = nullptr;
+	size_t length = 0;
+};
+
+/**
+ * @brief Writes replayed packets to a file descriptor, for example a connected UDP socket, a pipe or a file.
+ *
+ * Every packet is written with a single system call, so every packet is one datagram on a socket. With records set the capture record
+ * header is written in front of the packet, so a stream could be read again with a CaptureReader. The descriptor should be blocking,
+ * partial writes and interrupted calls are continued.
+ *
+ */
+class FdSink
+{
+public:
+	/**
+	 * @brief Construct a new FdSink object.
+	 *
+	 * @param fd - The descriptor, stays owned by the caller.
+	 * @param records - Write the record header with the timestamp and the length in front of every packet.
+	 */
+	explicit FdSink(int fd, bool records = false) : fd(fd), records(records)
+	{
+	}
+
+	/**
+	 * @brief Write a packet.
+	 *
+	 * @param view
+	 * @return true on success, false if the write failed. errno holds the reason of the failure.
+	 */
+	bool operator()(const PacketView &view)
+	{
+		uint8_t header[CAPTURE_RECORD_HEADER_LENGTH];
+		const uint32_t recordlength = static_cast<uint32_t>(view.length);
+		memcpy(header, &view.timestamp, sizeof(view.timestamp));
+		memcpy(&header[sizeof(view.timestamp)], &recordlength, sizeof(recordlength));
+		struct iovec parts[2] = {
+			{ header, records ? sizeof(header) : 0 },
+			{ const_cast<uint8_t*>(view.data), view.length } };
+		struct iovec *part = records ? &parts[0] : &parts[1];
+		int count = records ? 2 : 1;
+		while (count > 0)
+		{
+			const ssize_t written = writev(fd, part, count);
+			if (written < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			// Skip the written parts and continue the partially written one
+			size_t remaining = static_cast<size_t>(written);
+			while (count > 0 && remaining >= part->iov_len)
+			{
+				remaining -= part->iov_len;
+				part++;
+				count--;
+			}
+			if (count > 0)
+			{
+				part->iov_base = static_cast<uint8_t*>(part->iov_base) + remaining;
+				part->iov_len -= remaining;
+			}
+		}
+		return true;
+	}
+
+private:
+	int fd;
+	bool records;
+};
+
+/**
+ * @brief Result of a replay.
+ *
+ * The pacing error of a packet is the time between the point in time it should have been emitted, derived from its receive timestamp
+ * and the speed, and the point in time the sink was called. Packets are never emitted early, so the error is the lateness.
+ *
+ */
+struct ReplayReport
+{
+	uint64_t packets = 0;
+	uint64_t bytes = 0;
+	uint64_t duration = 0;         // Wall clock time of the replay in ns
+	double packetRate = 0;         // Emitted packets per second
+	double byteRate = 0;           // Emitted packet bytes per second
+	bool completed = false;        // false if the sink failed or the replay was stopped
+	HistogramSnapshot<> lateness;  // Pacing error in ns, empty when replaying as fast as possible
+};
+
+/**
+ * @brief Replays the records of a capture at the recorded pace, at a multiple of it or as fast as possible.
+ *
+ * Every record is passed to a sink at the time given by its receive timestamp relative to the first record, divided by the speed.
+ * Waits longer than the spin threshold sleep on a timerfd until the threshold before the deadline, the rest is busy polled on the
+ * monotonic clock. This keeps the pacing error in the range of microseconds without burning a core during long gaps. Records with a
+ * timestamp earlier than their predecessor are emitted at once.
+ *
+ * @code
+ * MappedCapture capture;
+ * capture.Open("pass.cap");
+ * CaptureReplay replay(10.0); // 10 times faster than recorded
+ * ReplayReport report = replay.Replay(capture.GetSegment(), FdSink(socket));
+ * @endcode
+ *
+ */
+class CaptureReplay
+{
+public:
+	/**
+	 * @brief Construct a new CaptureReplay object.
+	 *
+	 * @param speed - 1 for the recorded pace, 2 for twice as fast, 0 as fast as possible.
+	 * @param spinThreshold - Waits up to this time in ns are busy polled.
+	 */
+	explicit CaptureReplay(double speed = 1.0, uint64_t spinThreshold = 200000) : speed(speed), spinThreshold(spinThreshold)
+	{
+		timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	}
+
+	CaptureReplay(const CaptureReplay&) = delete;
+	CaptureReplay& operator=(const CaptureReplay&) = delete;
+
+	~CaptureReplay()
+	{
+		if (timer >= 0)
+		{
+			close(timer);
+		}
+	}
+
+	/**
+	 * @brief Replay a capture.
+	 *
+	 * @tparam Sink - Callable with (const PacketView &packet) that returns false to stop the replay.
+	 * @param capture
+	 * @param sink
+	 * @param loops - Number of times the capture is replayed. The loops follow each other with the mean record interval in between.
+	 * @return ReplayReport
+	 */
+	template<typename Sink>
+	ReplayReport Replay(const CaptureSegment &capture, Sink &&sink, size_t loops = 1)
+	{
+		stopped.store(false, std::memory_order_relaxed);
+		Histogram<> lateness;
+		ReplayReport report;
+		uint64_t first = 0;
+		uint64_t span = 0;
+		if (!GetSpan(capture, first, span))
+		{
+			report.completed = true;
+			return report;
+		}
+		const uint64_t start = Now();
+		uint64_t offset = 0;
+		uint64_t previous = 0;
+		report.completed = true;
+		for (size_t loop = 0; loop < loops && report.completed; loop++)
+		{
+			CaptureReader reader(capture.data, capture.length);
+			PacketView view;
+			while (reader.Next(view))
+			{
+				if (speed > 0)
+				{
+					const uint64_t relative = view.timestamp > first ? view.timestamp - first : 0;
+					previous = std::max(previous, offset + relative);
+					const uint64_t deadline = start + static_cast<uint64_t>(previous / speed);
+					const uint64_t now = WaitUntil(deadline);
+					if (now >= deadline) // Not reached if the replay was stopped while waiting
+					{
+						lateness.Record(now - deadline);
+					}
+				}
+				if (stopped.load(std::memory_order_relaxed) || !sink(static_cast<const PacketView&>(view)))
+				{
+					report.completed = false;
+					break;
+				}
+				report.packets++;
+				report.bytes += view.length;
+			}
+			offset += span;
+		}
+		report.duration = Now() - start;
+		if (report.duration > 0)
+		{
+			report.packetRate = report.packets * 1e9 / report.duration;
+			report.byteRate = report.bytes * 1e9 / report.duration;
+		}
+		if (speed > 0)
+		{
+			report.lateness = lateness.Snapshot();
+		}
+		return report;
+	}
+
+	/**
+	 * @brief Stop a running replay, could be called from another thread or a signal handler. A wait on the timer is cut short by
+	 * letting the timer expire at once, the packet that was waited for isn't emitted.
+	 *
+	 */
+	void Stop()
+	{
+		stopped.store(true);
+		if (timer >= 0)
+		{
+			// timerfd_settime is async signal safe, the errno of the interrupted code is kept
+			const int error = errno;
+			struct itimerspec setting = {};
+			setting.it_value.tv_nsec = 1;
+			timerfd_settime(timer, 0, &setting, nullptr);
+			errno = error;
+		}
+	}
+
+	/**
+	 * @brief Read the monotonic clock that is used for the pacing.
+	 *
+	 * @return uint64_t Time in ns.
+	 */
+	static uint64_t Now()
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<uint64_t>(now.tv_sec) * 1000000000u + static_cast<uint64_t>(now.tv_nsec);
+	}
+
+private:
+	/**
+	 * @brief Get the first timestamp of a capture and the time from the first record to the start of the next loop.
+	 *
+	 * @return false if the capture has no records.
+	 */
+	static bool GetSpan(const CaptureSegment &capture, uint64_t &first, uint64_t &span)
+	{
+		CaptureReader reader(capture.data, capture.length);
+		PacketView view;
+		if (!reader.Next(view))
+		{
+			return false;
+		}
+		first = view.timestamp;
+		uint64_t last = first;
+		size_t count = 1;
+		while (reader.Next(view))
+		{
+			last = std::max(last, view.timestamp);
+			count++;
+		}
+		span = (last - first) + (count > 1 ? (last - first) / (count - 1) : 0);
+		return true;
+	}
+
+	/**
+	 * @brief Sleep on the timer until the spin threshold before the deadline, then busy poll the clock.
+	 *
+	 * @param deadline
+	 * @return uint64_t The time at which the deadline was reached.
+	 */
+	uint64_t WaitUntil(uint64_t deadline)
+	{
+		uint64_t now = Now();
+		if (deadline > now + spinThreshold)
+		{
+			const uint64_t wakeup = deadline - spinThreshold;
+			if (timer >= 0)
+			{
+				struct itimerspec setting = {};
+				setting.it_value = { static_cast<time_t>(wakeup / 1000000000u), static_cast<long>(wakeup % 1000000000u) };
+				uint64_t expirations;
+				// A Stop before the timer is set is seen here, a Stop after it lets the timer expire
+				if (timerfd_settime(timer, TFD_TIMER_ABSTIME, &setting, nullptr) == 0 && !stopped.load())
+				{
+					while (read(timer, &expirations, sizeof(expirations)) < 0 && errno == EINTR && !stopped.load(std::memory_order_relaxed))
+					{
+					}
+				}
+			}
+			else
+			{
+				// Without a timer the sleep is split into steps, so a Stop from another thread is seen within a step
+				static const uint64_t STEP = 10000000;
+				for (uint64_t current = Now(); current < wakeup && !stopped.load(std::memory_order_relaxed); current = Now())
+				{
+					const uint64_t until = std::min(wakeup, current + STEP);
+					const struct timespec step = { static_cast<time_t>(until / 1000000000u), static_cast<long>(until % 1000000000u) };
+					clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &step, nullptr);
+				}
+			}
+			now = Now();
+		}
+		while (now < deadline && !stopped.load(std::memory_order_relaxed))
+		{
+			now = Now();
+		}
+		return now;
+	}
+
+	double speed;
+	uint64_t spinThreshold;
+	int timer = -1;
+	std::atomic<bool> stopped { false };
+};
+}
+#endif
+#endif
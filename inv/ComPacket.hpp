@@ -5,6 +5,7 @@
 #include "helper.hpp"
 #include <array>
 #include "bitfield.hpp"
+#include "Instrumentation.hpp"
 
 #ifdef USE_MEMALLOC
 #include <vector>
@@ -47,6 +48,41 @@ static inline size_t strlen_s(const char *data, size_t maxlength)
 	return i;
 }
 
+/**
+ * @brief Length of a string like strlen_s, but always reads maxlength bytes so the running time doesn't depend on the content of the data.
+ *
+ * @param data
+ * @param maxlength
+ * @return size_t
+ */
+static inline size_t strlen_ct(const char *data, size_t maxlength)
+{
+	size_t length = 0;
+	size_t terminated = 0;
+	for (size_t i = 0; i < maxlength; i++)
+	{
+		terminated |= static_cast<size_t>(data[i] == 0);
+		length += terminated ^ 1;
+	}
+	return length;
+}
+
+/**
+ * @brief Length of a serialized string, constant time if USE_CONSTANT_TIME_DECODE is defined.
+ *
+ * @param data
+ * @param maxlength
+ * @return size_t
+ */
+static inline size_t scanString(const char *data, size_t maxlength)
+{
+#ifdef USE_CONSTANT_TIME_DECODE
+	return strlen_ct(data, maxlength);
+#else
+	return strlen_s(data, maxlength);
+#endif
+}
+
 /***************************************Calculate Byte Length of different types********************************/
 
 /**
@@ -175,6 +211,167 @@ struct max_byte_length
 {
 	static const size_t value = (max_size<Types>::value + ...);
 };
+/**
+ * @brief is_std_array<T>::value is true if T is a std::array.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct is_std_array : std::false_type
+{
+};
+
+template<typename T, size_t length>
+struct is_std_array<std::array<T, length>> : std::true_type
+{
+};
+
+/**
+ * @brief Get the serialized length of a type whose length doesn't depend on its value.
+ *
+ * @tparam T
+ * @return constexpr size_t The serialized length or 0 if the length of the type depends on the value (strings).
+ */
+template<typename T>
+constexpr size_t fixedSerializedLength()
+{
+	if constexpr (is_arithmetic_v<T>)
+	{
+		return sizeof(T);
+	}
+	else if constexpr (is_bitfield_v<T>)
+	{
+		return T::BYTE_LENGTH;
+	}
+	else if constexpr (is_std_array<T>::value)
+	{
+		return fixedSerializedLength<typename T::value_type>() * std::tuple_size<T>::value;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+/**
+ * @brief is_fixed_size<T>::value is true if the serialized length of T doesn't depend on its value.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct is_fixed_size : std::integral_constant<bool, (fixedSerializedLength<T>() > 0)>
+{
+};
+
+/**
+ * @brief Helper struct to calculate the byte offset of a field in the serialized packet at compile time.
+ *
+ * All fields before the field index must have a fixed size.
+ *
+ * @tparam index
+ * @tparam Types
+ */
+template<const size_t index, typename ... Types>
+struct fixed_field_offset
+{
+	static_assert(index < sizeof...(Types), "The field index is out of range");
+
+	static constexpr size_t Calculate()
+	{
+		constexpr size_t lengths[] = { fixedSerializedLength<Types>()... };
+		size_t offset = 0;
+		for (size_t i = 0; i < index; i++)
+		{
+			offset += lengths[i];
+		}
+		return offset;
+	}
+
+	static constexpr bool CheckFixedPrefix()
+	{
+		constexpr size_t lengths[] = { fixedSerializedLength<Types>()... };
+		for (size_t i = 0; i < index; i++)
+		{
+			if (lengths[i] == 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static_assert(CheckFixedPrefix(), "All fields in front of the field must have a fixed size");
+	static const size_t value = Calculate();
+};
+
+/***************************************Serialize Message at compile time********************************/
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_bit_cast)
+#define BASECOM_HAS_BUILTIN_BIT_CAST
+#endif
+#elif defined(_MSC_VER) && _MSC_VER >= 1927
+#define BASECOM_HAS_BUILTIN_BIT_CAST
+#endif
+
+/**
+ * @brief Serialize an object to a byte buffer in a constant expression.
+ *
+ * Produces the same bytes as serializeToBuffer but could be evaluated at compile time.
+ * Only types with a fixed serialized length are supported. If the compiler doesn't provide a constexpr bit cast
+ * floating point values can't be serialized at compile time.
+ *
+ * @tparam T
+ * @param data - The object to serialize.
+ * @param out - The output buffer, must hold at least fixedSerializedLength<T>() bytes.
+ * @return constexpr size_t The number of written bytes.
+ */
+template<typename T>
+constexpr size_t encodeToBuffer(const T &data, uint8_t *out)
+{
+	static_assert(is_fixed_size<T>::value, "Only types with a fixed serialized length could be serialized at compile time");
+	if constexpr (is_arithmetic_v<T>)
+	{
+#ifdef BASECOM_HAS_BUILTIN_BIT_CAST
+		const auto bytes = __builtin_bit_cast(std::array<uint8_t, sizeof(T)>, data);
+		for (size_t i = 0; i < sizeof(T); i++)
+		{
+			out[i] = bytes[i];
+		}
+#else
+		static_assert(is_integral_v<T>, "Floating point values need a compiler with __builtin_bit_cast to be serialized at compile time");
+		using unsignedtype = make_unsigned_t<conditional_t<is_same_v<T, bool>, uint8_t, T>>;
+		const unsignedtype value = static_cast<unsignedtype>(data);
+		for (size_t i = 0; i < sizeof(T); i++)
+		{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			out[sizeof(T) - 1 - i] = static_cast<uint8_t>(value >> (8 * i));
+#else
+			out[i] = static_cast<uint8_t>(value >> (8 * i));
+#endif
+		}
+#endif
+		return sizeof(T);
+	}
+	else if constexpr (is_bitfield_v<T>)
+	{
+		for (size_t i = 0; i < T::BYTE_LENGTH; i++)
+		{
+			out[i] = data.GetSerializedByte(i);
+		}
+		return T::BYTE_LENGTH;
+	}
+	else
+	{
+		size_t offset = 0;
+		for (size_t i = 0; i < data.size(); i++)
+		{
+			offset += encodeToBuffer(data[i], &out[offset]);
+		}
+		return offset;
+	}
+}
+
 /***************************************Serialize Message to buffer********************************/
 
 /**
@@ -337,8 +534,9 @@ deserializeFromBuffer(const uint8_t *data, const size_t length, T &element, bool
 static inline size_t deserializeFromBuffer(const uint8_t *data, const size_t length, string &element, bool &valid)
 {
 	(void) valid;
-	size_t stringlength = strlen_s(reinterpret_cast<const char*>(data), length);
-	element = string(reinterpret_cast<const char*>(data), stringlength);
+	size_t stringlength = scanString(reinterpret_cast<const char*>(data), length);
+	// Also with USE_CONSTANT_TIME_DECODE only the string is copied, a std::string allocates depending on its length anyway
+	element.assign(reinterpret_cast<const char*>(data), stringlength);
 	if (stringlength < length) // If we read the last bytes in the string no null terminator is needed for termination, so just return the number of read charakters.
 	{
 		stringlength++; // If the data is longer than the found string, a nullterminator was present in the string, so mark that as read.
@@ -383,8 +581,16 @@ template<const size_t MAX_SIZE_>
 size_t inline deserializeFromBuffer(const uint8_t *data, const size_t length, etl::string<MAX_SIZE_> &element, bool &valid)
 {
 	(void) valid;
-	size_t stringlength = min<size_t>(strlen_s(reinterpret_cast<const char*>(data), length), MAX_SIZE_);
+	// Characters after MAX_SIZE_ are not used, so the scan could stop there
+	const size_t window = min<size_t>(length, MAX_SIZE_ + 1);
+	size_t stringlength = min<size_t>(scanString(reinterpret_cast<const char*>(data), window), MAX_SIZE_);
+#ifdef USE_CONSTANT_TIME_DECODE
+	// Copy the whole window, so the time doesn't depend on the string length
+	element.assign(reinterpret_cast<const char*>(data), min<size_t>(window, MAX_SIZE_));
+	element.resize(stringlength);
+#else
 	element = etl::string<MAX_SIZE_>(reinterpret_cast<const char*>(data), stringlength);
+#endif
 	if (stringlength < length) // If we read the last bytes in the string no null terminator is needed for termination, so just return the number of read charakters.
 	{
 		stringlength++; // If the data is longer than the found string, a nullterminator was present in the string, so mark that as read.
@@ -413,22 +619,329 @@ static inline size_t deserializeFromBuffer(const uint8_t *data, const size_t len
 }
 }
 
+/***************************************Table driven serialization********************************/
+
+#ifdef USE_TABLE_SERIALIZER
+#if defined(_MSC_VER)
+#define BASECOM_NOINLINE __declspec(noinline)
+#else
+#define BASECOM_NOINLINE __attribute__((noinline))
+#endif
+
+namespace utils
+{
+/**
+ * @brief How a field is serialized by the table serializer.
+ *
+ */
+enum class FieldKind : uint8_t
+{
+	Raw,   // Copied as it is: arithmetic types, bitfields and arrays of them
+	String // Characters followed by a null terminator
+};
+
+/**
+ * @brief Access to the characters of a string type, shared by all fields with the same string type.
+ *
+ */
+struct StringAccess
+{
+	const char* (*data)(const void *field);
+	size_t (*length)(const void *field);
+	void (*assign)(void *field, const char *data, size_t length, size_t window);
+};
+
+/**
+ * @brief Description of a single packet field for the table serializer.
+ *
+ */
+struct FieldDescriptor
+{
+	FieldKind kind;
+	uint32_t size;  // Raw: bytes of one element; String: maximum number of characters, 0 if unlimited
+	uint32_t count; // Raw: number of elements
+	const StringAccess *access;
+};
+
+template<typename T>
+struct is_etl_string : std::false_type
+{
+};
+
+#ifdef USE_ETL
+template<const size_t MAX_SIZE_>
+struct is_etl_string<etl::string<MAX_SIZE_>> : std::true_type
+{
+};
+#endif
+
+template<typename StringType>
+struct string_access
+{
+	static const char* Data(const void *field)
+	{
+		return static_cast<const StringType*>(field)->c_str();
+	}
+
+	static size_t Length(const void *field)
+	{
+		return static_cast<const StringType*>(field)->length();
+	}
+
+	static void Assign(void *field, const char *data, size_t length, size_t window)
+	{
+		StringType &string = *static_cast<StringType*>(field);
+#ifdef USE_CONSTANT_TIME_DECODE
+		// Only the fixed capacity of an etl::string makes the copy constant time, a std::string would copy the whole buffer
+		if constexpr (is_etl_string<StringType>::value)
+		{
+			string.assign(data, window);
+			string.resize(length);
+			return;
+		}
+#endif
+		(void) window;
+		string.assign(data, length);
+	}
+
+	static constexpr StringAccess value = { &Data, &Length, &Assign };
+};
+
+/**
+ * @brief Build the descriptor of a field type.
+ *
+ * @tparam T
+ * @return constexpr FieldDescriptor
+ */
+template<typename T>
+constexpr FieldDescriptor describeField()
+{
+	if constexpr (is_arithmetic_v<T>)
+	{
+		return { FieldKind::Raw, sizeof(T), 1, nullptr };
+	}
+	else if constexpr (is_bitfield_v<T>)
+	{
+		static_assert(sizeof(T) == T::BYTE_LENGTH, "Bitfields must not have additional members to be copied as a whole");
+		return { FieldKind::Raw, T::BYTE_LENGTH, 1, nullptr };
+	}
+	else if constexpr (is_std_array<T>::value)
+	{
+		constexpr FieldDescriptor element = describeField<typename T::value_type>();
+		static_assert(element.kind == FieldKind::Raw, "Arrays of strings are not supported by the table serializer");
+		static_assert(sizeof(T) == sizeof(typename T::value_type) * std::tuple_size<T>::value, "Arrays must not have padding");
+		return { FieldKind::Raw, element.size, static_cast<uint32_t>(element.count * std::tuple_size<T>::value), nullptr };
+	}
+	else if constexpr (is_same<T, string>::value)
+	{
+		return { FieldKind::String, 0, 1, &string_access<T>::value };
+	}
+#ifdef USE_ETL
+	else if constexpr (is_etl_string<T>::value)
+	{
+		return { FieldKind::String, static_cast<uint32_t>(T::MAX_SIZE), 1, &string_access<T>::value };
+	}
+#endif
+	else
+	{
+		static_assert(is_arithmetic_v<T>, "The field type is not supported by the table serializer");
+		return {};
+	}
+}
+
+/**
+ * @brief Copy the bytes of a raw field, the common small sizes are copied without a call to memcpy.
+ *
+ * @param destination
+ * @param source
+ * @param length
+ */
+static inline void copyRawField(void *destination, const void *source, size_t length)
+{
+	switch (length)
+	{
+	case 1:
+		memcpy(destination, source, 1);
+		break;
+	case 2:
+		memcpy(destination, source, 2);
+		break;
+	case 4:
+		memcpy(destination, source, 4);
+		break;
+	case 8:
+		memcpy(destination, source, 8);
+		break;
+	default:
+		memcpy(destination, source, length);
+		break;
+	}
+}
+
+/**
+ * @brief Get the serialized length of the fields described by the table.
+ *
+ * @param table
+ * @param fields - Pointers to the fields.
+ * @param count - Number of fields.
+ * @return size_t
+ */
+BASECOM_NOINLINE inline size_t tableSerializedLength(const FieldDescriptor *table, const void *const *fields, size_t count)
+{
+	size_t length = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (table[i].kind == FieldKind::Raw)
+		{
+			length += static_cast<size_t>(table[i].size) * table[i].count;
+		}
+		else
+		{
+			length += table[i].access->length(fields[i]) + 1;
+		}
+	}
+	return length;
+}
+
+/**
+ * @brief Serialize the fields described by the table.
+ *
+ * This is the shared interpreter used by all packet types. The caller must check that the output buffer is large enough.
+ *
+ * @param table
+ * @param fields - Pointers to the fields.
+ * @param count - Number of fields.
+ * @param out - Output buffer.
+ * @return size_t The number of written bytes.
+ */
+BASECOM_NOINLINE inline size_t tableSerialize(const FieldDescriptor *table, const void *const *fields, size_t count, uint8_t *out)
+{
+	size_t offset = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (table[i].kind == FieldKind::Raw)
+		{
+			const size_t length = static_cast<size_t>(table[i].size) * table[i].count;
+			copyRawField(&out[offset], fields[i], length);
+			offset += length;
+		}
+		else
+		{
+			const size_t length = table[i].access->length(fields[i]);
+			memcpy(&out[offset], table[i].access->data(fields[i]), length);
+			offset += length;
+			out[offset++] = 0;
+		}
+	}
+	return offset;
+}
+
+/**
+ * @brief Deserialize the fields described by the table.
+ *
+ * The data is checked first and the fields are only written if the data could be valid, like the unrolled serializer does.
+ *
+ * @param table
+ * @param fields - Pointers to the fields.
+ * @param count - Number of fields.
+ * @param data
+ * @param length
+ * @param fixedLength - The serialized length if the packet has no strings, 0 otherwise.
+ * @return tuple<size_t, bool> The number of read bytes and if the data could be valid.
+ */
+BASECOM_NOINLINE inline tuple<size_t, bool> tableDeserialize(const FieldDescriptor *table, void *const *fields, size_t count, const uint8_t *data, size_t length,
+		size_t fixedLength)
+{
+	// Without strings only the length must be checked, otherwise the first pass checks the data without writing the fields
+	if (fixedLength > 0 && length < fixedLength)
+	{
+		return make_tuple(length, false);
+	}
+	bool valid = true;
+	size_t offset = 0;
+	for (size_t pass = fixedLength > 0 ? 1 : 0; pass < 2; pass++)
+	{
+		offset = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const size_t remaining = length - offset;
+			if (table[i].kind == FieldKind::Raw)
+			{
+				const size_t fieldLength = static_cast<size_t>(table[i].size) * table[i].count;
+				if (remaining < fieldLength)
+				{
+					valid = false;
+					offset = length;
+					continue;
+				}
+				if (pass > 0)
+				{
+					copyRawField(fields[i], &data[offset], fieldLength);
+				}
+				offset += fieldLength;
+			}
+			else
+			{
+				const char *characters = reinterpret_cast<const char*>(&data[offset]);
+				const size_t window = table[i].size > 0 ? min<size_t>(remaining, table[i].size + 1) : remaining;
+				size_t stringlength = scanString(characters, window);
+				if (table[i].size > 0)
+				{
+					stringlength = min<size_t>(stringlength, table[i].size);
+				}
+				if (pass > 0)
+				{
+					table[i].access->assign(fields[i], characters, stringlength, table[i].size > 0 ? min<size_t>(window, table[i].size) : window);
+				}
+				offset += stringlength < remaining ? stringlength + 1 : stringlength;
+			}
+		}
+		if (!valid)
+		{
+			break;
+		}
+	}
+	return make_tuple(offset, valid);
+}
+}
+#endif
+
 /***************************************Base class for all communication packets********************************/
 
 /**
  * @brief Data structure to be used as a base class for all data packets
  *
- * This class contains all methods and fields to serialize and deserialize data to and from the packet
+ * This class contains all methods and fields to serialize and deserialize data to and from the packet.
+ * Packets are usually derived from ComPacket or TagedComPacket, which use the NoInstrumentation policy.
  *
+ * @tparam Policy - Instrumentation policy, the hooks of the policy are called if Policy::Enabled is true.
  * @tparam T
  */
-template<class ... T>
-class ComPacket
+template<class Policy, class ... T>
+class BasicComPacket
 {
-	using tupletype = tuple<T...>;
+	using tupletype = FieldTuple<T...>;
 
 public:
-	ComPacket()
+	/**
+	 * @brief The instrumentation policy of the packet.
+	 *
+	 */
+	using InstrumentationPolicy = Policy;
+
+	/**
+	 * @brief The tuple type that holds the fields of the packet, the fields are accessed with get<index>(elements).
+	 *
+	 */
+	using ElementTypes = tupletype;
+
+	/**
+	 * @brief Number of fields in the packet.
+	 *
+	 */
+	static const size_t FieldCount = sizeof...(T);
+
+	constexpr BasicComPacket()
 	{
 	}
 
@@ -437,9 +950,28 @@ public:
 	 *
 	 * @param values
 	 */
-	ComPacket(T ... values)
+	constexpr BasicComPacket(T ... values) : elements(values...)
+	{
+	}
+
+	/**
+	 * @brief Get the tuple that holds the fields of the packet.
+	 *
+	 * @return const tupletype&
+	 */
+	constexpr const tupletype& GetElements() const
+	{
+		return elements;
+	}
+
+	/**
+	 * @brief Get the tuple that holds the fields of the packet.
+	 *
+	 * @return tupletype&
+	 */
+	tupletype& GetElements()
 	{
-		elements = tupletype(values...);
+		return elements;
 	}
 
 	/**
@@ -449,7 +981,7 @@ public:
 	 * This field could be used in a compile time if constexpr to decide if the packet supports compile time size expressions.
 	 *
 	 */
-	static const bool SupportsMaxSize = !tuple_helper::tuple_contains_type<string, tupletype>::value;
+	static const bool SupportsMaxSize = !tuple_helper::tuple_contains_type<string, tuple<T...>>::value;
 
 	/**
 	 * @brief Get the Max Size of the object
@@ -471,8 +1003,19 @@ public:
 	 */
 	size_t GetSerializedLength() const
 	{
-		return apply([](auto &&...args)
-		{	return ((utils::getSerializedLength(args)) + ...);}, elements);
+#ifdef USE_TABLE_SERIALIZER
+		if constexpr (FixedLength > 0)
+		{
+			return FixedLength;
+		}
+		else
+		{
+			return utils::tableSerializedLength(FieldTable.data(), GetFieldPointers().data(), FieldCount);
+		}
+#else
+		return elements.Apply([](auto &&...args)
+		{	return ((utils::getSerializedLength(args)) + ...);});
+#endif
 	}
 
 	/**
@@ -499,6 +1042,7 @@ public:
 		return Serialize(it, buffer.end()) + idlength;
 	}
 
+#ifdef USE_ETL
 	/**
 	 * @brief Serialize the packet to the buffer with the specified id data before the serialized data.
 	 *
@@ -525,6 +1069,28 @@ public:
 		auto it = copy(idbytes.begin(), idbytes.end(), buffer.begin());
 		return Serialize(it, buffer.end()) + idlength;
 	}
+#endif
+
+	/**
+	 * @brief Serialize the packet to a caller provided buffer with the specified id data before the serialized data.
+	 *
+	 * @tparam idlength
+	 * @param buffer
+	 * @param length - Length of the buffer.
+	 * @param idbytes
+	 * @return size_t The number of written bytes or 0 if the packet doesn't fit into the buffer.
+	 */
+	template<const size_t idlength>
+	size_t Serialize(uint8_t *buffer, size_t length, const array<uint8_t, idlength> &idbytes) const
+	{
+		if (length < idlength)
+		{
+			return 0;
+		}
+		copy(idbytes.begin(), idbytes.end(), buffer);
+		const size_t written = Serialize(buffer + idlength, buffer + length);
+		return written > 0 || GetSerializedLength() == 0 ? written + idlength : 0;
+	}
 
 #ifdef USE_MEMALLOC
         /**
@@ -569,6 +1135,28 @@ public:
         }
 #endif
 
+	/**
+	 * @brief Get a snapshot of the counters of this packet type, only available with an instrumentation policy that counts.
+	 *
+	 * @return instrumentation::PacketCounters
+	 */
+	static instrumentation::PacketCounters GetCounters()
+	{
+		static_assert(Policy::Enabled, "The packet has no instrumentation");
+		return Policy::template Counters<BasicComPacket>().Snapshot();
+	}
+
+	/**
+	 * @brief Get the latency histograms of this packet type, only available with an instrumentation policy that times the decoding.
+	 *
+	 * @return const instrumentation::LatencySet&
+	 */
+	static const instrumentation::LatencySet& GetLatencies()
+	{
+		static_assert(instrumentation::times_decode<Policy>::value, "The packet has no latency instrumentation");
+		return Policy::template Latencies<BasicComPacket>();
+	}
+
 	/**
 	 * @brief Check if the id data at the packet start matches with the provided id.
 	 *
@@ -596,6 +1184,59 @@ public:
 		return make_tuple(false, data.begin(), 0);
 	}
 
+	/**
+	 * @brief Check if the id data at the packet start matches with the provided id.
+	 *
+	 * @tparam arraylength
+	 * @param data
+	 * @param datalength
+	 * @param idbytes
+	 * @return tuple<bool, uint8_t*, size_t> If the packet start matches the id; The beginn of the data section; The remaining bytes in the packet.
+	 */
+	template<const size_t arraylength>
+	static tuple<bool, const uint8_t*, size_t> CheckIDMatch(const uint8_t *data, size_t datalength, const array<uint8_t, arraylength> &idbytes)
+	{
+		if (datalength < arraylength)
+		{
+			if constexpr (Policy::Enabled)
+			{
+				Policy::template IDMismatch<BasicComPacket>();
+			}
+			return make_tuple(false, nullptr, 0);
+		}
+#ifdef USE_CONSTANT_TIME_DECODE
+		// Compare all bytes, i is the index of the first mismatch like below
+		uint8_t mismatch = 0;
+		size_t i = 0;
+		for (size_t j = 0; j < arraylength; j++)
+		{
+			mismatch |= static_cast<uint8_t>(idbytes[j] ^ data[j]);
+			i += static_cast<size_t>(mismatch == 0);
+		}
+		const bool ret = mismatch == 0;
+#else
+		bool ret = true;
+		// Check if data starts with idbytes
+		size_t i;
+		for (i = 0; i < arraylength; i++)
+		{
+			if (idbytes[i] != data[i])
+			{
+				ret = false;
+				break;
+			}
+		}
+#endif
+		if constexpr (Policy::Enabled)
+		{
+			if (!ret)
+			{
+				Policy::template IDMismatch<BasicComPacket>();
+			}
+		}
+		return make_tuple(ret, &data[i], static_cast<size_t>(datalength - i));
+	}
+
 	/**
 	 * @brief Deserialize data from the buffer.
 	 *
@@ -608,7 +1249,7 @@ public:
 	 */
 	template<const size_t maxdatalength>
 	static auto Unserialize(typename std::array<uint8_t, maxdatalength>::const_iterator it, const typename std::array<uint8_t, maxdatalength>::const_iterator end, size_t length,
-			ComPacket<T...> &packet)
+			BasicComPacket &packet)
 	{
 		assert(length <= maxdatalength);
 		auto dist = std::distance(it, end);
@@ -616,27 +1257,71 @@ public:
 		assert(length <= static_cast<size_t>(dist));
 		if (length <= maxdatalength && length <= static_cast<size_t>(dist))
 		{
-
-			auto parsed_elements = tupletype();
-			size_t offset = 0;
-			const uint8_t *data = &(*it);
-			bool valid = apply([&offset, &data, length](auto &&...args)
-			{
-				bool valid = true;
-				((offset += utils::deserializeFromBuffer(&data[offset], length - offset, args, valid)), ...);
-				return valid;}, parsed_elements);
-			if (valid)
-			{
-				packet.elements = parsed_elements;
-			}
+			auto [offset, valid] = Unserialize(&(*it), length, packet);
 			return make_tuple(offset, valid, it + offset);
 		}
 		else
 		{
-			return make_tuple(0U, false, it);
+			return make_tuple(static_cast<size_t>(0), false, it);
 		}
 	}
 
+	/**
+	 * @brief Deserialize data from a raw buffer.
+	 *
+	 * @param data - Start of the serialized data.
+	 * @param length - The number of bytes in the buffer.
+	 * @param packet - The packet the data should be unserialized to.
+	 * @return a tuple which holds the number of read bytes as a size_t and a boolean that marks if the deserialized data could be valid.
+	 */
+	static tuple<size_t, bool> Unserialize(const uint8_t *data, size_t length, BasicComPacket &packet)
+	{
+		[[maybe_unused]] uint64_t decodeStart = 0;
+		if constexpr (instrumentation::times_decode<Policy>::value)
+		{
+			decodeStart = Policy::Now();
+		}
+#ifdef USE_TABLE_SERIALIZER
+		const auto fields = packet.elements.Apply([](auto &...args)
+		{	return std::array<void*, FieldCount> { { static_cast<void*>(&args)... } };});
+		const auto [offset, valid] = utils::tableDeserialize(FieldTable.data(), fields.data(), FieldCount, data, length, FixedLength);
+#else
+		auto parsed_elements = tupletype();
+		size_t offset = 0;
+		bool valid = parsed_elements.Apply([&offset, &data, length](auto &&...args)
+		{
+			bool valid = true;
+			((offset += utils::deserializeFromBuffer(&data[offset], length - offset, args, valid)), ...);
+			return valid;});
+#ifdef USE_CONSTANT_TIME_DECODE
+		// The elements are copied also for invalid data, but not to the packet
+		tupletype discarded;
+		(valid ? packet.elements : discarded) = parsed_elements;
+#else
+		if (valid)
+		{
+			packet.elements = parsed_elements;
+		}
+#endif
+#endif
+		if constexpr (Policy::Enabled)
+		{
+			if (valid)
+			{
+				Policy::template Deserialized<BasicComPacket>(offset);
+			}
+			else
+			{
+				Policy::template InvalidDecode<BasicComPacket>();
+			}
+			if constexpr (instrumentation::times_decode<Policy>::value)
+			{
+				Policy::template DecodeTime<BasicComPacket>(Policy::Now() - decodeStart);
+			}
+		}
+		return make_tuple(offset, valid);
+	}
+
 	/**
 	 * @brief Deserialize data from the buffer.
 	 *
@@ -647,7 +1332,7 @@ public:
 	 * @return a tuple which holds the number of read bytes as a size_t, a boolean that marks if the deserialized data could be valid and an iterator past the packet.
 	 */
 	template<const size_t maxdatalength>
-	static auto Unserialize(std::array<uint8_t, maxdatalength> &data, size_t length, ComPacket<T...> &packet)
+	static auto Unserialize(std::array<uint8_t, maxdatalength> &data, size_t length, BasicComPacket &packet)
 	{
 		return Unserialize<maxdatalength>(data.begin(), data.end(), length, packet);
 	}
@@ -688,46 +1373,37 @@ protected:
 	 */
 	tupletype elements;
 
+private:
+#ifdef USE_TABLE_SERIALIZER
 	/**
-	 * @brief Check if the id data at the packet start matches with the provided id.
+	 * @brief Descriptors of the fields for the shared table serializer.
 	 *
-	 * @tparam arraylength
-	 * @param data
-	 * @param datalength
-	 * @param idbytes
-	 * @return tuple<bool, uint8_t*, size_t> If the packet start matches the id; The beginn of the data section; The remaining bytes in the packet.
 	 */
-	template<const size_t arraylength>
-	static tuple<bool, const uint8_t*, size_t> CheckIDMatch(const uint8_t *data, size_t datalength, const array<uint8_t, arraylength> &idbytes)
+	static constexpr std::array<utils::FieldDescriptor, sizeof...(T)> FieldTable = { { utils::describeField<T>()... } };
+
+	/**
+	 * @brief The serialized length if the packet has no strings, 0 otherwise.
+	 *
+	 */
+	static constexpr size_t CalculateFixedLength()
 	{
-		if (datalength < arraylength)
+		if constexpr ((utils::is_fixed_size<T>::value && ...))
 		{
-			return make_tuple(false, nullptr, 0);
+			return utils::max_byte_length<T...>::value;
 		}
-		bool ret = true;
-		// Check if data starts with idbytes
-		size_t i;
-		for (i = 0; i < arraylength; i++)
+		else
 		{
-			if (idbytes[i] != data[i])
-			{
-				ret = false;
-				break;
-			}
+			return 0;
 		}
-		return make_tuple(ret, &data[i], static_cast<size_t>(datalength - i));
 	}
+	static constexpr size_t FixedLength = CalculateFixedLength();
 
-private:
-	/**
-	 * @brief Set the Elements object.
-	 *
-	 * @param t
-	 */
-	void SetElements(tuple<const T&...> t)
+	std::array<const void*, sizeof...(T)> GetFieldPointers() const
 	{
-		elements = t;
+		return elements.Apply([](const auto &...args)
+		{	return std::array<const void*, sizeof...(T)> { { static_cast<const void*>(&args)... } };});
 	}
+#endif
 
 	/**
 	 * @brief Serialize the packet to the buffer starting at begin and ending on end
@@ -748,41 +1424,93 @@ private:
 			return 0;
 		}
 
+#ifdef USE_TABLE_SERIALIZER
+		if (packetLength == 0)
+		{
+			return 0;
+		}
+		const size_t written = utils::tableSerialize(FieldTable.data(), GetFieldPointers().data(), FieldCount, &(*begin));
+		const size_t ret = written <= packetLength ? written : 0; // Always true, tells the compiler the range of the result
+#else
 		iterator start = begin;
 
-		apply([&start, &end](auto &&...args)
-		{	((utils::serializeToBuffer(args, start, end)), ...);}, elements);
+		elements.Apply([&start, &end](auto &&...args)
+		{	((utils::serializeToBuffer(args, start, end)), ...);});
 
 		auto ret = distance(begin, start);
 		assert(ret >= 0);
+#endif
+		if constexpr (Policy::Enabled)
+		{
+			Policy::template Serialized<BasicComPacket>(ret);
+		}
 		return ret;
 	}
 };
 
-template<const size_t idLength, class ...T>
-class TagedComPacket: public ComPacket<T...>
+/**
+ * @brief Base class for packets without id, see BasicComPacket.
+ *
+ * This is the same type as the base of TagedComPacket, so a tagged packet could be passed as ComPacket with the same fields.
+ *
+ * @tparam T
+ */
+template<class ... T>
+using ComPacket = BasicComPacket<NoInstrumentation, T...>;
+
+/**
+ * @brief Packet with id bytes in front of the serialized data.
+ *
+ * @tparam Policy - Instrumentation policy, see BasicComPacket.
+ * @tparam idLength
+ * @tparam T
+ */
+template<class Policy, const size_t idLength, class ...T>
+class BasicTagedComPacket: public BasicComPacket<Policy, T...>
 {
 public:
+	/**
+	 * @brief The untagged packet type that holds the data fields.
+	 *
+	 */
+	using PacketBase = BasicComPacket<Policy, T...>;
 
-	TagedComPacket()
+	/**
+	 * @brief Number of id bytes in front of the serialized packet data.
+	 *
+	 */
+	static const size_t IDLength = idLength;
+
+	constexpr BasicTagedComPacket()
 	{
-		id.fill(0);
 	}
 
 	template<typename idlisttype>
-	TagedComPacket(std::initializer_list<idlisttype> &&id)
+	constexpr BasicTagedComPacket(std::initializer_list<idlisttype> &&id)
 	{
 		SetID(id);
 	}
 
 	template<typename idlisttype>
-	TagedComPacket(std::initializer_list<idlisttype> &id)
+	constexpr BasicTagedComPacket(std::initializer_list<idlisttype> &id)
 	{
 		SetID(id);
 	}
 
+	/**
+	 * @brief Construct a new Taged Com Packet object with the id and initialize the fields with the provided values.
+	 *
+	 * This constructor could be used in constant expressions, for example to build a PacketTemplate.
+	 *
+	 * @param id
+	 * @param values
+	 */
+	constexpr BasicTagedComPacket(const std::array<uint8_t, idLength> &id, T ... values) : PacketBase(values...), id(id)
+	{
+	}
+
 	template<typename idlisttype>
-	void SetID(idlisttype &id)
+	constexpr void SetID(idlisttype &id)
 	{
 		auto it = id.begin();
 		for (size_t i = 0; i < std::min<size_t>(id.size(), idLength); i++)
@@ -793,7 +1521,7 @@ public:
 	}
 
 	template<typename idlisttype>
-	void SetID(idlisttype &&id)
+	constexpr void SetID(idlisttype &&id)
 	{
 		auto it = id.begin();
 		for (size_t i = 0; i < std::min<size_t>(id.size(), idLength); i++)
@@ -805,13 +1533,35 @@ public:
 
 	static constexpr size_t GetMaxSize()
 	{
-		return ComPacket<T...>::GetMaxSize() + idLength;
+		return PacketBase::GetMaxSize() + idLength;
+	}
+
+	/**
+	 * @brief Get the id bytes that are serialized in front of the packet data.
+	 *
+	 * @return const std::array<uint8_t, idLength>&
+	 */
+	constexpr const std::array<uint8_t, idLength>& GetID() const
+	{
+		return id;
 	}
 
 	template<const size_t datalength>
 	auto CheckIDMatch(const std::array<uint8_t, datalength> &data, size_t length) const
 	{
-		return CheckIDMatch(data, length, id);
+		return PacketBase::CheckIDMatch(data, length, id);
+	}
+
+	/**
+	 * @brief Check if the raw data starts with the id of this packet.
+	 *
+	 * @param data
+	 * @param length
+	 * @return tuple<bool, const uint8_t*, size_t> If the packet start matches the id; The beginn of the data section; The remaining bytes in the packet.
+	 */
+	auto CheckIDMatch(const uint8_t *data, size_t length) const
+	{
+		return PacketBase::CheckIDMatch(data, length, id);
 	}
 
 	/**
@@ -826,18 +1576,43 @@ public:
 	template<const size_t datalength>
 	auto Serialize(array<uint8_t, datalength> &buffer) const
 	{
-		return ComPacket<T...>::template Serialize<datalength, idLength>(buffer, id);
+		return PacketBase::template Serialize<datalength, idLength>(buffer, id);
+	}
+
+	/**
+	 * @brief Serialize the packet with the id to a caller provided buffer.
+	 *
+	 * @param buffer
+	 * @param length - Length of the buffer.
+	 * @return size_t The number of written bytes or 0 if the packet doesn't fit into the buffer.
+	 */
+	size_t Serialize(uint8_t *buffer, size_t length) const
+	{
+		return PacketBase::template Serialize<idLength>(buffer, length, id);
 	}
 #ifdef USE_ETL
 	auto Serialize(etl::ivector<uint8_t> &buffer) const
 	{
-		return ComPacket<T...>::template Serialize<idLength>(buffer, id);
+		return PacketBase::template Serialize<idLength>(buffer, id);
 	}
 #endif
 
 private:
 
-	std::array<uint8_t, idLength> id;
+	std::array<uint8_t, idLength> id = {};
+};
+
+/**
+ * @brief Base class for packets with id, see BasicTagedComPacket.
+ *
+ * @tparam idLength
+ * @tparam T
+ */
+template<const size_t idLength, class ...T>
+class TagedComPacket: public BasicTagedComPacket<NoInstrumentation, idLength, T...>
+{
+public:
+	using BasicTagedComPacket<NoInstrumentation, idLength, T...>::BasicTagedComPacket;
 };
 }
 #endif
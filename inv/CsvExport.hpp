@@ -0,0 +1,358 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <tuple>
+#include <thread>
+#include <utility>
+#include <type_traits>
+#include "ComPacket.hpp"
+#include "Capture.hpp"
+#include "RawFilter.hpp"
+#include "TextFormat.hpp"
+
+#ifndef CSVEXPORT_HPP__
+#define CSVEXPORT_HPP__
+
+namespace translib
+{
+/**
+ * @brief Formats packets of a type as rows of a CSV or TSV file.
+ *
+ * The first column is the timestamp of the packet, followed by one column per field. Array fields have one column per element, bitfields
+ * that list their sub-fields in a static Members array (see BitfieldMember) one column per sub-field, other bitfields are written as
+ * hexadecimal bytes. Numbers are formatted with std::to_chars, floating point values with the shortest representation that reads back to
+ * the same value. Strings are quoted if they contain the separator, a quote or a line break.
+ *
+ * The writer has no state besides the column names and could be shared by several threads.
+ *
+ * @tparam Packet - ComPacket or TagedComPacket.
+ */
+template<class Packet>
+class CsvWriter
+{
+public:
+	static constexpr size_t FieldCount = std::tuple_size<typename Packet::ElementTypes>::value;
+
+	/**
+	 * @brief Construct a new CsvWriter object.
+	 *
+	 * @param names - Column names of the fields, by default the FieldNames of the packet type. Fields without a name are called field0,
+	 * field1, ...
+	 * @param separator - ',' for CSV, '\t' for TSV.
+	 */
+	explicit CsvWriter(const std::array<const char*, FieldCount> &names = utils::fieldNames<Packet, FieldCount>(), char separator = ',')
+		: names(names), separator(separator)
+	{
+	}
+
+	/**
+	 * @brief Write the header line with the column names.
+	 *
+	 * @param out
+	 * @param space
+	 * @return size_t The number of written bytes or 0 if the line doesn't fit.
+	 */
+	size_t WriteHeader(char *out, size_t space) const
+	{
+		utils::TextCursor cursor(out, space);
+		cursor.Put("timestamp");
+		WriteNames(cursor, std::make_index_sequence<FieldCount>());
+		cursor.Put('\n');
+		return cursor.GetLength();
+	}
+
+	/**
+	 * @brief Write a packet as line.
+	 *
+	 * @param out
+	 * @param space
+	 * @param timestamp
+	 * @param packet
+	 * @return size_t The number of written bytes or 0 if the line doesn't fit.
+	 */
+	size_t WriteRow(char *out, size_t space, uint64_t timestamp, const Packet &packet) const
+	{
+		utils::TextCursor cursor(out, space);
+		cursor.Number(timestamp);
+		packet.GetElements().Apply([this, &cursor](const auto &...fields)
+		{	(WriteValue(cursor, fields), ...);});
+		cursor.Put('\n');
+		return cursor.GetLength();
+	}
+
+private:
+	template<size_t ...I>
+	void WriteNames(utils::TextCursor &cursor, std::index_sequence<I...>) const
+	{
+		char name[16];
+		((WriteName<typename RawFields<Packet>::template Type<I>>(cursor, names[I] != nullptr ? names[I] : DefaultName(name, I))), ...);
+	}
+
+	static const char *DefaultName(char *name, size_t field)
+	{
+		snprintf(name, 16, "field%u", static_cast<unsigned>(field));
+		return name;
+	}
+
+	/**
+	 * @brief Write the column names of a field, every column starts with the separator.
+	 *
+	 */
+	template<typename T>
+	void WriteName(utils::TextCursor &cursor, const char *name) const
+	{
+		if constexpr (has_bitfield_members<T>::value)
+		{
+			for (const BitfieldMember &member : T::Members)
+			{
+				cursor.Put(separator);
+				cursor.Put(name);
+				cursor.Put('.');
+				cursor.Put(member.name);
+			}
+		}
+		else if constexpr (utils::is_std_array<T>::value)
+		{
+			for (size_t i = 0; i < std::tuple_size<T>::value; i++)
+			{
+				char element[128];
+				snprintf(element, sizeof(element), "%s[%u]", name, static_cast<unsigned>(i));
+				WriteName<typename T::value_type>(cursor, element);
+			}
+		}
+		else
+		{
+			cursor.Put(separator);
+			cursor.Put(name);
+		}
+	}
+
+	/**
+	 * @brief Write the columns of a field, every column starts with the separator.
+	 *
+	 */
+	template<typename T>
+	void WriteValue(utils::TextCursor &cursor, const T &value) const
+	{
+		if constexpr (std::is_same<T, bool>::value)
+		{
+			cursor.Put(separator);
+			cursor.Put(value ? '1' : '0');
+		}
+		else if constexpr (std::is_arithmetic<T>::value)
+		{
+			cursor.Put(separator);
+			cursor.Number(value);
+		}
+		else if constexpr (has_bitfield_members<T>::value)
+		{
+			for (const BitfieldMember &member : T::Members)
+			{
+				cursor.Put(separator);
+				cursor.Number(value.GetBits(member.offset, member.length));
+			}
+		}
+		else if constexpr (is_bitfield_v<T>)
+		{
+			uint8_t bytes[T::BYTE_LENGTH];
+			for (size_t i = 0; i < T::BYTE_LENGTH; i++)
+			{
+				bytes[i] = value.GetSerializedByte(i);
+			}
+			cursor.Put(separator);
+			cursor.Hex(bytes, T::BYTE_LENGTH);
+		}
+		else if constexpr (utils::is_std_array<T>::value)
+		{
+			for (const auto &element : value)
+			{
+				WriteValue(cursor, element);
+			}
+		}
+		else
+		{
+			cursor.Put(separator);
+			WriteText(cursor, value.data(), value.size());
+		}
+	}
+
+	void WriteText(utils::TextCursor &cursor, const char *text, size_t length) const
+	{
+		bool quote = false;
+		for (size_t i = 0; i < length; i++)
+		{
+			quote |= text[i] == separator || text[i] == '"' || text[i] == '\n' || text[i] == '\r';
+		}
+		if (!quote)
+		{
+			cursor.Put(text, length);
+			return;
+		}
+		cursor.Put('"');
+		for (size_t i = 0; i < length; i++)
+		{
+			if (text[i] == '"')
+			{
+				cursor.Put('"');
+			}
+			cursor.Put(text[i]);
+		}
+		cursor.Put('"');
+	}
+
+	std::array<const char*, FieldCount> names;
+	char separator;
+};
+
+/**
+ * @brief Exports the packets of a type from captures to CSV.
+ *
+ * The records of a capture are decoded into a packet and written as rows into a caller provided buffer, a full buffer is passed to a sink,
+ * for example fwrite to a file, and reused. Records with another id and records that can't be decoded are skipped. Independent segments,
+ * for example the archive files of a day or the parts of a capture split with SplitCapture, are exported on one thread per segment.
+ *
+ * @code
+ * CsvExport<HousekeepingPacket> csv(CsvWriter<HousekeepingPacket>({"time", "temperatures"}));
+ * csv.Export(segment, buffer, sizeof(buffer), [file](const char *text, size_t length) { fwrite(text, 1, length, file); });
+ * @endcode
+ *
+ * @tparam Packet - ComPacket or TagedComPacket with a default constructor that sets the id.
+ */
+template<class Packet>
+class CsvExport
+{
+public:
+	explicit CsvExport(const CsvWriter<Packet> &writer = CsvWriter<Packet>()) : writer(writer)
+	{
+	}
+
+	const CsvWriter<Packet> &GetWriter() const
+	{
+		return writer;
+	}
+
+	/**
+	 * @brief Export the packets of a capture.
+	 *
+	 * @tparam Sink - Callable with (const char *text, size_t length).
+	 * @param segment - The capture or a segment of it.
+	 * @param buffer - Buffer for the rows, large buffers reduce the number of sink calls.
+	 * @param bufferLength
+	 * @param sink - Called with the rows whenever the buffer is full and at the end.
+	 * @return size_t The number of exported packets.
+	 */
+	template<typename Sink>
+	size_t Export(const CaptureSegment &segment, char *buffer, size_t bufferLength, Sink &&sink) const
+	{
+		Packet packet;
+		CaptureReader reader(segment.data, segment.length);
+		PacketView view;
+		size_t used = 0;
+		size_t rows = 0;
+		while (reader.Next(view))
+		{
+			const uint8_t *data = view.data;
+			size_t length = view.length;
+			if constexpr (utils::id_length<Packet>::value > 0)
+			{
+				const auto [match, start, remaining] = packet.CheckIDMatch(view.data, view.length);
+				if (!match)
+				{
+					continue;
+				}
+				data = start;
+				length = remaining;
+			}
+			if (!std::get<1>(Packet::Unserialize(data, length, packet)))
+			{
+				continue;
+			}
+			size_t written = writer.WriteRow(&buffer[used], bufferLength - used, view.timestamp, packet);
+			if (written == 0 && used > 0)
+			{
+				sink(static_cast<const char*>(buffer), used);
+				used = 0;
+				written = writer.WriteRow(buffer, bufferLength, view.timestamp, packet);
+			}
+			if (written > 0) // A row longer than the whole buffer is skipped
+			{
+				used += written;
+				rows++;
+			}
+		}
+		if (used > 0)
+		{
+			sink(static_cast<const char*>(buffer), used);
+		}
+		return rows;
+	}
+
+	/**
+	 * @brief Export several segments at the same time on a fixed number of threads.
+	 *
+	 * Every thread takes the next segment that isn't exported yet, so a day of archive segments needs no more threads than cores.
+	 *
+	 * @tparam Sink - Callable with (size_t segment, const char *text, size_t length), is called by several threads at the same time but
+	 * never by two threads for the same segment.
+	 * @param segments
+	 * @param count - Number of segments.
+	 * @param buffers - One buffer per thread, threads * bufferLength bytes.
+	 * @param bufferLength - Length of the buffer of every thread.
+	 * @param threads - Number of threads including the calling thread, at most count threads are used.
+	 * @param sink
+	 * @return size_t The number of exported packets of all segments.
+	 */
+	template<typename Sink>
+	size_t ExportParallel(const CaptureSegment *segments, size_t count, char *buffers, size_t bufferLength, size_t threads, Sink &&sink) const
+	{
+		if (threads == 0)
+		{
+			return 0;
+		}
+		std::atomic<size_t> next(0);
+		std::atomic<size_t> rows(0);
+		auto worker = [&](size_t thread)
+		{
+			size_t exported = 0;
+			for (size_t segment = next.fetch_add(1, std::memory_order_relaxed); segment < count;
+					segment = next.fetch_add(1, std::memory_order_relaxed))
+			{
+				exported += Export(segments[segment], &buffers[thread * bufferLength], bufferLength, [segment, &sink](const char *text, size_t length)
+				{	sink(segment, text, length);});
+			}
+			rows.fetch_add(exported, std::memory_order_relaxed);
+		};
+		RunWorkers(0, std::min(threads, count), worker);
+		return rows.load(std::memory_order_relaxed);
+	}
+
+private:
+	/**
+	 * @brief Run the worker on a new thread and the remaining workers on this thread, recursively.
+	 *
+	 */
+	template<typename Worker>
+	static void RunWorkers(size_t first, size_t threads, Worker &worker)
+	{
+		if (threads <= 1)
+		{
+			if (threads == 1)
+			{
+				worker(first);
+			}
+			return;
+		}
+		std::thread other([&worker, first]()
+		{	worker(first);});
+		RunWorkers(first + 1, threads - 1, worker);
+		other.join();
+	}
+
+	CsvWriter<Packet> writer;
+};
+}
+#endif
@@ -0,0 +1,187 @@
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include "hash.hpp"
+
+#ifndef DEDUPLICATOR_HPP__
+#define DEDUPLICATOR_HPP__
+
+namespace translib
+{
+/**
+ * @brief Drops duplicated packets that arrive within a time window.
+ *
+ * Packets are identified by a 64 bit key, either a hash over the raw serialized bytes or a key built from the packet id and a sequence number.
+ * The keys are stored in a fixed size open addressing table, every key is searched in at most probeLength consecutive slots.
+ * Entries older than the window are treated as free. If all probed slots hold live entries the oldest one is overwritten, so a full table
+ * degrades to a shorter effective window instead of failing. GetEvictionCount reports how often that happened.
+ *
+ * The timestamps are opaque ticks supplied by the caller, the window must use the same unit. A copy with a timestamp before the stored one,
+ * for example from a ground station with a skewed clock, is still treated as duplicate.
+ * One instance must only be used by one thread. To deduplicate on several ingest threads distribute the packets by key over one instance per thread.
+ *
+ * @tparam slots - Number of entries in the table, must be a power of two.
+ * @tparam probeLength - Number of slots searched for a key.
+ */
+template<const size_t slots, const size_t probeLength = 8>
+class PacketDeduplicator
+{
+	static_assert(slots > 0 && (slots & (slots - 1)) == 0, "The number of slots must be a power of two");
+	static_assert(probeLength > 0 && probeLength <= slots, "The probe length must be between 1 and the number of slots");
+
+	struct Entry
+	{
+		uint64_t key;
+		uint64_t timestamp;
+	};
+
+public:
+	/**
+	 * @brief Construct a new Packet Deduplicator object.
+	 *
+	 * @param window - Packets with the same key are considered duplicates if they arrive within this number of ticks.
+	 */
+	explicit PacketDeduplicator(uint64_t window) : window(window)
+	{
+		Clear();
+	}
+
+	/**
+	 * @brief Remove all stored keys.
+	 *
+	 */
+	void Clear()
+	{
+		for (auto &entry : table)
+		{
+			entry = Entry { emptyKey, 0 };
+		}
+		duplicates = 0;
+		evictions = 0;
+	}
+
+	/**
+	 * @brief Check if the serialized packet is seen for the first time within the window and remember it.
+	 *
+	 * @param data - The serialized packet.
+	 * @param length - The length of the packet.
+	 * @param now - The current time in ticks.
+	 * @return true if the packet should be processed, false if it is a duplicate.
+	 */
+	bool IsFirst(const uint8_t *data, size_t length, uint64_t now)
+	{
+		return IsFirstKey(utils::hashBytes(data, length), now);
+	}
+
+	/**
+	 * @brief Check if the serialized packet is seen for the first time within the window and remember it.
+	 *
+	 * @tparam datalength
+	 * @param data - The array holding the serialized packet.
+	 * @param length - The length of the packet.
+	 * @param now - The current time in ticks.
+	 * @return true if the packet should be processed, false if it is a duplicate.
+	 */
+	template<const size_t datalength>
+	bool IsFirst(const std::array<uint8_t, datalength> &data, size_t length, uint64_t now)
+	{
+		assert(length <= datalength);
+		return IsFirst(data.data(), std::min<size_t>(length, datalength), now);
+	}
+
+	/**
+	 * @brief Check if the key is seen for the first time within the window and remember it.
+	 *
+	 * @param key - A key identifying the packet, for example the result of MakeKey.
+	 * @param now - The current time in ticks.
+	 * @return true if the packet should be processed, false if it is a duplicate.
+	 */
+	bool IsFirstKey(uint64_t key, uint64_t now)
+	{
+		if (key == emptyKey)
+		{
+			key = 1;
+		}
+		const size_t start = static_cast<size_t>(key) & (slots - 1);
+		Entry *free = nullptr;
+		Entry *oldest = &table[start];
+		for (size_t i = 0; i < probeLength; i++)
+		{
+			Entry &entry = table[(start + i) & (slots - 1)];
+			// A timestamp before the stored one comes from a skewed clock, the entry is still live
+			const bool expired = entry.key == emptyKey || (now >= entry.timestamp && now - entry.timestamp > window);
+			if (!expired)
+			{
+				if (entry.key == key)
+				{
+					duplicates++;
+					return false;
+				}
+				if (entry.timestamp < oldest->timestamp)
+				{
+					oldest = &entry;
+				}
+			}
+			else if (free == nullptr)
+			{
+				free = &entry;
+			}
+		}
+		if (free == nullptr)
+		{
+			evictions++;
+			free = oldest;
+		}
+		*free = Entry { key, now };
+		return true;
+	}
+
+	/**
+	 * @brief Build a key from the packet id and a sequence number.
+	 *
+	 * @tparam idlength
+	 * @param idbytes
+	 * @param sequence
+	 * @return uint64_t
+	 */
+	template<const size_t idlength>
+	static uint64_t MakeKey(const std::array<uint8_t, idlength> &idbytes, uint64_t sequence)
+	{
+		return utils::hashBytes(idbytes.data(), idlength, utils::hashMix(sequence));
+	}
+
+	/**
+	 * @brief Get the number of dropped duplicates since the last call to Clear.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetDuplicateCount() const
+	{
+		return duplicates;
+	}
+
+	/**
+	 * @brief Get the number of live entries that had to be overwritten since the last call to Clear.
+	 *
+	 * A growing value means that the table is too small for the packet rate and the window.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetEvictionCount() const
+	{
+		return evictions;
+	}
+
+private:
+	static const uint64_t emptyKey = 0;
+
+	uint64_t window;
+	std::array<Entry, slots> table;
+	uint64_t duplicates = 0;
+	uint64_t evictions = 0;
+};
+}
+#endif
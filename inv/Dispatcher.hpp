@@ -0,0 +1,227 @@
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <cassert>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include "ComPacket.hpp"
+#include "hash.hpp"
+
+#ifndef DISPATCHER_HPP__
+#define DISPATCHER_HPP__
+
+namespace translib
+{
+/**
+ * @brief Decodes received data to the TagedComPacket type with the matching id and passes the packet to a handler.
+ *
+ * The dispatcher holds one instance of every packet type, the ids are taken from these instances. The packet type is found with a
+ * lookup in a hash table of the ids, so the cost of a dispatch doesn't grow with the number of packet types.
+ * All packet types must use the same id length of at most 8 bytes.
+ *
+ * PacketDispatcher<StatusPacket, EventPacket> dispatcher;
+ * dispatcher.Dispatch(data, length, [](auto &packet) { ... });
+ *
+ * @tparam Packets - Types derived from TagedComPacket with a default constructor that sets the id.
+ */
+template<typename ... Packets>
+class PacketDispatcher
+{
+	static_assert(sizeof...(Packets) > 0, "At least one packet type is needed");
+	using FirstPacket = std::tuple_element_t<0, std::tuple<Packets...>>;
+	static constexpr size_t idLength = FirstPacket::IDLength;
+	static_assert(((Packets::IDLength == idLength) && ...), "All packet types must have the same id length");
+	static_assert(idLength > 0 && idLength <= sizeof(uint64_t), "The id length must be between 1 and 8 bytes");
+
+	static constexpr size_t CalculateTableSize()
+	{
+		size_t size = 1;
+		while (size < 2 * sizeof...(Packets))
+		{
+			size *= 2;
+		}
+		return size;
+	}
+	static constexpr size_t tableSize = CalculateTableSize();
+	static constexpr uint8_t emptySlot = 0xFF;
+	static_assert(sizeof...(Packets) < emptySlot, "Too many packet types for one dispatcher");
+
+public:
+	/**
+	 * @brief Number of packet types handled by the dispatcher.
+	 *
+	 */
+	static const size_t PacketCount = sizeof...(Packets);
+
+	PacketDispatcher()
+	{
+		slots.fill(emptySlot);
+		BuildTable(std::index_sequence_for<Packets...>());
+	}
+
+	/**
+	 * @brief Find the index of the packet type for the id at the start of the data.
+	 *
+	 * @param data
+	 * @param length
+	 * @return size_t The index of the packet type in Packets or PacketCount if the id is unknown.
+	 */
+	size_t Lookup(const uint8_t *data, size_t length) const
+	{
+		if (length < idLength)
+		{
+			return PacketCount;
+		}
+		const uint64_t key = ReadKey(data);
+		size_t slot = static_cast<size_t>(utils::hashMix(key)) & (tableSize - 1);
+		while (slots[slot] != emptySlot)
+		{
+			if (keys[slot] == key)
+			{
+				return slots[slot];
+			}
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		return PacketCount;
+	}
+
+	/**
+	 * @brief Decode the data and pass the packet to the handler.
+	 *
+	 * @tparam Handler - Callable with every packet type, for example a generic lambda taking auto &packet.
+	 * @param data - The serialized packet including the id.
+	 * @param length
+	 * @param handler
+	 * @return true if the id was known and the decoded data could be valid.
+	 */
+	template<typename Handler>
+	bool Dispatch(const uint8_t *data, size_t length, Handler &&handler)
+	{
+		return DispatchIndex(Lookup(data, length), data, length, handler);
+	}
+
+	/**
+	 * @brief Decode the data and pass the packet to the handler.
+	 *
+	 * @tparam datalength
+	 * @tparam Handler
+	 * @param data
+	 * @param length
+	 * @param handler
+	 * @return true if the id was known and the decoded data could be valid.
+	 */
+	template<const size_t datalength, typename Handler>
+	bool Dispatch(const std::array<uint8_t, datalength> &data, size_t length, Handler &&handler)
+	{
+		assert(length <= datalength);
+		return Dispatch(data.data(), std::min<size_t>(length, datalength), handler);
+	}
+
+	/**
+	 * @brief Get the instance of a packet type that is used for decoding.
+	 *
+	 * @tparam Packet
+	 * @return Packet&
+	 */
+	template<typename Packet>
+	Packet& Get()
+	{
+		return std::get<Packet>(packets);
+	}
+
+	/**
+	 * @brief Get the number of packets with an unknown id.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetUnknownCount() const
+	{
+		return unknownCount;
+	}
+
+	/**
+	 * @brief Get the number of packets with a known id that could not be decoded.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetInvalidCount() const
+	{
+		return invalidCount;
+	}
+
+private:
+	static uint64_t ReadKey(const uint8_t *data)
+	{
+		uint64_t key = 0;
+		memcpy(&key, data, idLength);
+		return key;
+	}
+
+	template<size_t ... I>
+	void BuildTable(std::index_sequence<I...>)
+	{
+		(Insert(I, std::get<I>(packets).GetID().data()), ...);
+	}
+
+	void Insert(size_t index, const uint8_t *id)
+	{
+		const uint64_t key = ReadKey(id);
+		size_t slot = static_cast<size_t>(utils::hashMix(key)) & (tableSize - 1);
+		while (slots[slot] != emptySlot)
+		{
+			assert(keys[slot] != key && "Two packet types use the same id");
+			if (keys[slot] == key)
+			{
+				return;
+			}
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		keys[slot] = key;
+		slots[slot] = static_cast<uint8_t>(index);
+	}
+
+	template<typename Handler>
+	bool DispatchIndex(size_t index, const uint8_t *data, size_t length, Handler &handler)
+	{
+		if (index >= PacketCount)
+		{
+			unknownCount++;
+			return false;
+		}
+		static constexpr auto table = DispatchTable<Handler>(std::index_sequence_for<Packets...>());
+		return table[index](*this, data, length, handler);
+	}
+
+	template<typename Handler, size_t ... I>
+	static constexpr std::array<bool (*)(PacketDispatcher&, const uint8_t*, size_t, Handler&), sizeof...(I)> DispatchTable(std::index_sequence<I...>)
+	{
+		return { { &PacketDispatcher::template DecodeAndHandle<I, Handler>... } };
+	}
+
+	template<size_t index, typename Handler>
+	static bool DecodeAndHandle(PacketDispatcher &dispatcher, const uint8_t *data, size_t length, Handler &handler)
+	{
+		auto &packet = std::get<index>(dispatcher.packets);
+		using Packet = std::remove_reference_t<decltype(packet)>;
+		auto [readbytes, valid] = Packet::PacketBase::Unserialize(data + idLength, length - idLength, packet);
+		(void) readbytes;
+		if (!valid)
+		{
+			dispatcher.invalidCount++;
+			return false;
+		}
+		instrumentation::Dispatched(packet);
+		handler(packet);
+		return true;
+	}
+
+	std::tuple<Packets...> packets;
+	std::array<uint64_t, tableSize> keys = {};
+	std::array<uint8_t, tableSize> slots;
+	uint64_t unknownCount = 0;
+	uint64_t invalidCount = 0;
+};
+}
+#endif
@@ -0,0 +1,324 @@
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include "helper.hpp"
+#include "NumericFields.hpp"
+
+#ifndef FIELDHISTORY_HPP__
+#define FIELDHISTORY_HPP__
+
+namespace translib
+{
+/**
+ * @brief History of the last samples of every numeric value of a packet type, for example for live plots.
+ *
+ * The samples are kept in ring buffers with one ring per value (structure of arrays), so the history of a value is read without touching
+ * the other values. Besides the raw samples there are pyramid levels of downsampled minimum and maximum values, level l holds one bucket
+ * per factor^l samples and covers the same time span as the raw samples, about 2 / (factor - 1) of the memory of the raw samples.
+ * A zoomed-out plot reads a level with about as many buckets as it has pixels instead of all samples.
+ *
+ * One thread appends, any number of threads read at the same time without locks. Every ring has two counters like a sequence lock: the
+ * writer announces the sample it overwrites before it writes and publishes it afterwards. A reader copies the samples and checks the
+ * announced counter afterwards, samples that were overwritten while they were copied are dropped from the result, so the result is always
+ * consistent but may be shorter than requested. The samples are stored in relaxed atomics, which are plain loads and stores on the common
+ * 64 bit targets.
+ *
+ * The memory is fixed and large for long histories, keep the object in static memory.
+ *
+ * @tparam Packet - ComPacket or TagedComPacket with at least one numeric field.
+ * @tparam capacity - Number of raw samples per value, a power of two.
+ * @tparam levels - Number of pyramid levels.
+ * @tparam factor - Downsampling factor between two levels, a power of two.
+ */
+template<class Packet, const size_t capacity, const size_t levels = 2, const size_t factor = 16>
+class FieldHistory
+{
+public:
+	using Layout = NumericLayout<Packet>;
+	static_assert(Layout::ValueCount > 0, "The packet must contain at least one numeric field");
+	static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "The capacity must be a power of two");
+	static_assert(factor > 1 && (factor & (factor - 1)) == 0, "The factor must be a power of two");
+
+	/**
+	 * @brief Get the number of buckets of a level, level 0 are the raw samples.
+	 *
+	 * @param level
+	 * @return constexpr size_t
+	 */
+	static constexpr size_t LevelLength(size_t level)
+	{
+		size_t length = capacity;
+		for (size_t i = 0; i < level && length > 1; i++)
+		{
+			length /= factor;
+		}
+		return length;
+	}
+
+	/**
+	 * @brief Get the number of raw samples per bucket of a level.
+	 *
+	 * @param level
+	 * @return constexpr uint64_t
+	 */
+	static constexpr uint64_t LevelFactor(size_t level)
+	{
+		uint64_t samples = 1;
+		for (size_t i = 0; i < level; i++)
+		{
+			samples *= factor;
+		}
+		return samples;
+	}
+
+	static_assert(levels == 0 || LevelFactor(levels) <= capacity, "The capacity must hold at least one bucket of the highest level");
+
+	FieldHistory()
+	{
+		for (size_t level = 0; level < levels; level++)
+		{
+			partialMin[level].fill(std::numeric_limits<double>::infinity());
+			partialMax[level].fill(-std::numeric_limits<double>::infinity());
+		}
+	}
+
+	/**
+	 * @brief Append the values of a packet, must only be called by one thread.
+	 *
+	 * @param packet
+	 * @param time - Timestamp of the packet.
+	 */
+	void Append(const Packet &packet, uint64_t time)
+	{
+		std::array<double, Layout::ValueCount> values;
+		Layout::Gather(packet, values.data());
+
+		const uint64_t index = samples;
+		Announce(0, index);
+		const size_t slot = static_cast<size_t>(index & (capacity - 1));
+		rawTimes[slot].store(time, std::memory_order_relaxed);
+		for (size_t value = 0; value < Layout::ValueCount; value++)
+		{
+			rawValues[value * capacity + slot].store(values[value], std::memory_order_relaxed);
+		}
+		Publish(0, index);
+		samples++;
+
+		// Fold the sample into the pyramid, a completed bucket of one level is folded into the next
+		for (size_t level = 0; level < levels; level++)
+		{
+			if (partialCount[level] == 0)
+			{
+				partialTime[level] = level == 0 ? time : partialTime[level - 1];
+			}
+			for (size_t value = 0; value < Layout::ValueCount; value++)
+			{
+				partialMin[level][value] = std::min(partialMin[level][value], level == 0 ? values[value] : partialMin[level - 1][value]);
+				partialMax[level][value] = std::max(partialMax[level][value], level == 0 ? values[value] : partialMax[level - 1][value]);
+			}
+			if (++partialCount[level] < factor)
+			{
+				break;
+			}
+			PublishBucket(level);
+		}
+		if (levels > 0)
+		{
+			// Levels above the highest completed one keep their partial buckets, the completed ones start over
+			for (size_t level = 0; level < levels && partialCount[level] == factor; level++)
+			{
+				partialCount[level] = 0;
+				partialMin[level].fill(std::numeric_limits<double>::infinity());
+				partialMax[level].fill(-std::numeric_limits<double>::infinity());
+			}
+		}
+	}
+
+	/**
+	 * @brief Get the number of samples appended so far.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetCount() const
+	{
+		return counters[0].published.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Copy the latest raw samples of a value, oldest first.
+	 *
+	 * @param field - Index of the field in the packet.
+	 * @param element - Index within an array field.
+	 * @param count - Maximum number of samples.
+	 * @param times - Output for the timestamps, space for count values.
+	 * @param values - Output for the values, space for count values.
+	 * @return size_t The number of copied samples.
+	 */
+	size_t Read(size_t field, size_t element, size_t count, uint64_t *times, double *values) const
+	{
+		if (element >= Layout::FieldWidth(field))
+		{
+			return 0;
+		}
+		const size_t value = Layout::FieldOffset(field) + element;
+		return ReadRing(0, count, times, [&](size_t i, size_t slot)
+		{
+			values[i] = rawValues[value * capacity + slot].load(std::memory_order_relaxed);
+		}, [&](size_t from, size_t to, size_t length)
+		{
+			std::copy(values + from, values + from + length, values + to);
+		});
+	}
+
+	/**
+	 * @brief Copy the latest completed buckets of a pyramid level, oldest first.
+	 *
+	 * The timestamp of a bucket is the one of its first sample. Level 0 returns the raw samples as minimum and maximum.
+	 *
+	 * @param level - 0 to levels.
+	 * @param field - Index of the field in the packet.
+	 * @param element - Index within an array field.
+	 * @param count - Maximum number of buckets.
+	 * @param times - Output for the timestamps, space for count values.
+	 * @param min - Output for the minimum of every bucket, space for count values.
+	 * @param max - Output for the maximum of every bucket, space for count values.
+	 * @return size_t The number of copied buckets.
+	 */
+	size_t ReadLevel(size_t level, size_t field, size_t element, size_t count, uint64_t *times, double *min, double *max) const
+	{
+		if (level == 0)
+		{
+			const size_t length = Read(field, element, count, times, min);
+			std::copy(min, min + length, max);
+			return length;
+		}
+		if (level > levels || element >= Layout::FieldWidth(field))
+		{
+			return 0;
+		}
+		const size_t base = (Layout::FieldOffset(field) + element) * PyramidLength + LevelOffset(level);
+		return ReadRing(level, count, times, [&](size_t i, size_t slot)
+		{
+			min[i] = pyramidMin[base + slot].load(std::memory_order_relaxed);
+			max[i] = pyramidMax[base + slot].load(std::memory_order_relaxed);
+		}, [&](size_t from, size_t to, size_t length)
+		{
+			std::copy(min + from, min + from + length, min + to);
+			std::copy(max + from, max + from + length, max + to);
+		});
+	}
+
+private:
+	/**
+	 * @brief Offset of a level in the pyramid arrays of a value.
+	 *
+	 * @param level - 1 to levels.
+	 * @return constexpr size_t
+	 */
+	static constexpr size_t LevelOffset(size_t level)
+	{
+		size_t offset = 0;
+		for (size_t i = 1; i < level; i++)
+		{
+			offset += LevelLength(i);
+		}
+		return offset;
+	}
+
+	static constexpr size_t PyramidLength = LevelOffset(levels + 1);
+
+	struct alignas(CACHE_LINE_SIZE) Counters
+	{
+		std::atomic<uint64_t> announced{0}; // Index + 1 of the sample that is written
+		std::atomic<uint64_t> published{0}; // Number of samples that are completely written
+	};
+
+	void Announce(size_t level, uint64_t index)
+	{
+		counters[level].announced.store(index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	void Publish(size_t level, uint64_t index)
+	{
+		counters[level].published.store(index + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Write the partial bucket of a level to the next pyramid level.
+	 *
+	 * @param level - Index of the partial bucket, the bucket is written to level + 1.
+	 */
+	void PublishBucket(size_t level)
+	{
+		const uint64_t index = buckets[level]++;
+		const size_t length = LevelLength(level + 1);
+		const size_t slot = static_cast<size_t>(index & (length - 1));
+		const size_t offset = LevelOffset(level + 1);
+		Announce(level + 1, index);
+		pyramidTimes[offset + slot].store(partialTime[level], std::memory_order_relaxed);
+		for (size_t value = 0; value < Layout::ValueCount; value++)
+		{
+			pyramidMin[value * PyramidLength + offset + slot].store(partialMin[level][value], std::memory_order_relaxed);
+			pyramidMax[value * PyramidLength + offset + slot].store(partialMax[level][value], std::memory_order_relaxed);
+		}
+		Publish(level + 1, index);
+	}
+
+	/**
+	 * @brief Copy the latest entries of a ring and drop the ones that were overwritten while they were copied.
+	 *
+	 * @param level
+	 * @param count
+	 * @param times
+	 * @param copy - Called with (output index, slot) for every entry.
+	 * @param move - Called with (from, to, length) to move the valid entries to the start of the outputs.
+	 * @return size_t The number of valid entries.
+	 */
+	template<typename Copy, typename Move>
+	size_t ReadRing(size_t level, size_t count, uint64_t *times, Copy &&copy, Move &&move) const
+	{
+		const size_t length = LevelLength(level);
+		const std::atomic<uint64_t> *ringTimes = level == 0 ? rawTimes.data() : &pyramidTimes[LevelOffset(level)];
+		const uint64_t end = counters[level].published.load(std::memory_order_acquire);
+		const size_t n = static_cast<size_t>(std::min<uint64_t>({end, length, count}));
+		const uint64_t start = end - n;
+		for (size_t i = 0; i < n; i++)
+		{
+			const size_t slot = static_cast<size_t>((start + i) & (length - 1));
+			times[i] = ringTimes[slot].load(std::memory_order_relaxed);
+			copy(i, slot);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t announced = counters[level].announced.load(std::memory_order_relaxed);
+		const uint64_t firstValid = announced > length ? announced - length : 0;
+		if (start >= firstValid)
+		{
+			return n;
+		}
+		const size_t dropped = static_cast<size_t>(std::min<uint64_t>(firstValid - start, n));
+		std::copy(times + dropped, times + n, times);
+		move(dropped, 0, n - dropped);
+		return n - dropped;
+	}
+
+	std::array<Counters, levels + 1> counters;
+	std::array<std::atomic<uint64_t>, capacity> rawTimes;
+	std::array<std::atomic<double>, Layout::ValueCount * capacity> rawValues;
+	std::array<std::atomic<uint64_t>, PyramidLength> pyramidTimes;
+	std::array<std::atomic<double>, Layout::ValueCount * PyramidLength> pyramidMin;
+	std::array<std::atomic<double>, Layout::ValueCount * PyramidLength> pyramidMax;
+
+	// Only used by the writer
+	uint64_t samples = 0;
+	std::array<uint64_t, levels> buckets = {};
+	std::array<size_t, levels> partialCount = {};
+	std::array<uint64_t, levels> partialTime = {};
+	std::array<std::array<double, Layout::ValueCount>, levels> partialMin;
+	std::array<std::array<double, Layout::ValueCount>, levels> partialMax;
+};
+}
+#endif
@@ -0,0 +1,369 @@
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <array>
+#include <tuple>
+#include <limits>
+#include <algorithm>
+#include "helper.hpp"
+#include "NumericFields.hpp"
+#include "simd.hpp"
+
+#ifndef FIELDSTATISTICS_HPP__
+#define FIELDSTATISTICS_HPP__
+
+namespace translib
+{
+/**
+ * @brief Statistics of a numeric value over a window.
+ *
+ */
+struct FieldSummary
+{
+	uint64_t count = 0;
+	double min = 0;
+	double max = 0;
+	double mean = 0;
+	double stddev = 0; // Population standard deviation
+};
+
+/**
+ * @brief Running min, max, mean and standard deviation of all numeric values of a packet type over a sliding time window.
+ *
+ * The window is divided into a fixed number of buckets. Every bucket holds the count, minimum, maximum, mean and sum of squared deviations
+ * of all values of the packets that arrived within its time span, the oldest bucket is cleared when the window moves on. A summary merges
+ * the buckets within the window, so the window moves in steps of a bucket and the memory is fixed. The means are updated with the
+ * algorithm of Welford and merged with the one of Chan et al., which stay accurate for values with a large offset, like timestamps.
+ *
+ * Packets are added one by one or as PacketColumns batch, both updates use the vector backends. NaN values are ignored by minimum and
+ * maximum but make the mean of the bucket NaN.
+ *
+ * @tparam Packet - ComPacket or TagedComPacket with at least one numeric field.
+ * @tparam buckets - Number of buckets of the window.
+ * @tparam Backend - simd::Native or simd::Scalar.
+ */
+template<class Packet, const size_t buckets = 10, class Backend = simd::Native>
+class FieldStatistics
+{
+public:
+	using Layout = NumericLayout<Packet>;
+	static_assert(Layout::ValueCount > 0, "The packet must contain at least one numeric field");
+	static_assert(buckets > 0, "The window needs at least one bucket");
+
+	/**
+	 * @brief Number of values rounded up to a multiple of 4, the width of the widest backend.
+	 *
+	 */
+	static constexpr size_t PaddedCount = (Layout::ValueCount + 3) & ~size_t(3);
+
+	/**
+	 * @brief Construct a new FieldStatistics object.
+	 *
+	 * @param window - Length of the window in the unit of the timestamps, for example nanoseconds.
+	 */
+	explicit FieldStatistics(uint64_t window) : bucketLength(std::max<uint64_t>(1, window / buckets))
+	{
+		Clear();
+	}
+
+	/**
+	 * @brief Add the values of a packet.
+	 *
+	 * @param packet
+	 * @param now - Timestamp of the packet.
+	 * @return true
+	 * @return false The packet is older than the bucket it belongs to and was ignored.
+	 */
+	bool Update(const Packet &packet, uint64_t now)
+	{
+		Bucket *bucket = Select(now);
+		if (bucket == nullptr)
+		{
+			return false;
+		}
+		std::array<double, PaddedCount> values = {};
+		Layout::Gather(packet, values.data());
+		bucket->count++;
+		const auto inverse = Backend::Broadcast(1.0 / static_cast<double>(bucket->count));
+		for (size_t i = 0; i < PaddedCount; i += Backend::Width)
+		{
+			const auto value = Backend::Load(&values[i]);
+			const auto delta = Backend::Subtract(value, Backend::Load(&bucket->mean[i]));
+			const auto mean = Backend::Add(Backend::Load(&bucket->mean[i]), Backend::Multiply(delta, inverse));
+			Backend::Store(&bucket->mean[i], mean);
+			Backend::Store(&bucket->m2[i], Backend::Add(Backend::Load(&bucket->m2[i]), Backend::Multiply(delta, Backend::Subtract(value, mean))));
+			Backend::Store(&bucket->min[i], Backend::Min(value, Backend::Load(&bucket->min[i])));
+			Backend::Store(&bucket->max[i], Backend::Max(value, Backend::Load(&bucket->max[i])));
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Add the values of a batch of packets that arrived at the same time.
+	 *
+	 * @tparam capacity
+	 * @param columns
+	 * @param now
+	 * @return true
+	 * @return false The batch is older than the bucket it belongs to and was ignored.
+	 */
+	template<const size_t capacity>
+	bool Update(const PacketColumns<Packet, capacity> &columns, uint64_t now)
+	{
+		const size_t count = columns.GetCount();
+		Bucket *bucket = Select(now);
+		if (bucket == nullptr || count == 0)
+		{
+			return bucket != nullptr;
+		}
+		for (size_t value = 0; value < Layout::ValueCount; value++)
+		{
+			double min;
+			double max;
+			double mean;
+			double m2;
+			Reduce(columns.Column(value), count, min, max, mean, m2);
+			bucket->min[value] = std::min(min, bucket->min[value]);
+			bucket->max[value] = std::max(max, bucket->max[value]);
+			Merge(bucket->count, bucket->mean[value], bucket->m2[value], count, mean, m2);
+		}
+		bucket->count += count;
+		return true;
+	}
+
+	/**
+	 * @brief Get the statistics of a value over the window.
+	 *
+	 * @param field - Index of the field in the packet.
+	 * @param element - Index within an array field.
+	 * @param now - Current time, buckets that are older than the window are ignored.
+	 * @return FieldSummary The count is 0 if the value doesn't exist or wasn't updated within the window.
+	 */
+	FieldSummary Summary(size_t field, size_t element, uint64_t now) const
+	{
+		if (element >= Layout::FieldWidth(field))
+		{
+			return FieldSummary();
+		}
+		return ValueSummary(Layout::FieldOffset(field) + element, now);
+	}
+
+	/**
+	 * @brief Call function with (field, element, FieldSummary) of every value that was updated within the window.
+	 *
+	 * @tparam Function
+	 * @param now
+	 * @param function
+	 */
+	template<typename Function>
+	void ForEachValue(uint64_t now, Function &&function) const
+	{
+		for (size_t value = 0; value < Layout::ValueCount; value++)
+		{
+			const FieldSummary summary = ValueSummary(value, now);
+			if (summary.count != 0)
+			{
+				function(Layout::FieldOfValue(value), Layout::ElementOfValue(value), summary);
+			}
+		}
+	}
+
+	void Clear()
+	{
+		for (Bucket &bucket : window)
+		{
+			Reset(bucket, 0);
+		}
+	}
+
+private:
+	struct Bucket
+	{
+		uint64_t epoch; // Timestamp divided by the bucket length
+		uint64_t count;
+		std::array<double, PaddedCount> min;
+		std::array<double, PaddedCount> max;
+		std::array<double, PaddedCount> mean;
+		std::array<double, PaddedCount> m2;
+	};
+
+	static void Reset(Bucket &bucket, uint64_t epoch)
+	{
+		bucket.epoch = epoch;
+		bucket.count = 0;
+		bucket.min.fill(std::numeric_limits<double>::infinity());
+		bucket.max.fill(-std::numeric_limits<double>::infinity());
+		bucket.mean.fill(0);
+		bucket.m2.fill(0);
+	}
+
+	/**
+	 * @brief Get the bucket of a timestamp, the bucket is cleared if it still holds an older time span.
+	 *
+	 * @param now
+	 * @return Bucket* nullptr if the bucket already holds a newer time span.
+	 */
+	Bucket *Select(uint64_t now)
+	{
+		const uint64_t epoch = now / bucketLength;
+		Bucket &bucket = window[epoch % buckets];
+		if (bucket.epoch != epoch)
+		{
+			if (epoch < bucket.epoch && bucket.count != 0)
+			{
+				return nullptr;
+			}
+			Reset(bucket, epoch);
+		}
+		return &bucket;
+	}
+
+	/**
+	 * @brief Combine the mean and the sum of squared deviations of two sets, Chan et al.
+	 *
+	 */
+	static void Merge(uint64_t count, double &mean, double &m2, uint64_t otherCount, double otherMean, double otherM2)
+	{
+		const double total = static_cast<double>(count + otherCount);
+		const double delta = otherMean - mean;
+		mean += delta * static_cast<double>(otherCount) / total;
+		m2 += otherM2 + delta * delta * static_cast<double>(count) * static_cast<double>(otherCount) / total;
+	}
+
+	/**
+	 * @brief Minimum, maximum, mean and sum of squared deviations of a column, in two passes.
+	 *
+	 */
+	static void Reduce(const double *column, size_t count, double &min, double &max, double &mean, double &m2)
+	{
+		auto minimum = Backend::Broadcast(std::numeric_limits<double>::infinity());
+		auto maximum = Backend::Broadcast(-std::numeric_limits<double>::infinity());
+		auto sum = Backend::Broadcast(0);
+		size_t i = 0;
+		for (; i + Backend::Width <= count; i += Backend::Width)
+		{
+			const auto value = Backend::Load(&column[i]);
+			minimum = Backend::Min(value, minimum);
+			maximum = Backend::Max(value, maximum);
+			sum = Backend::Add(sum, value);
+		}
+		double lanes[3][Backend::Width];
+		Backend::Store(lanes[0], minimum);
+		Backend::Store(lanes[1], maximum);
+		Backend::Store(lanes[2], sum);
+		min = std::numeric_limits<double>::infinity();
+		max = -std::numeric_limits<double>::infinity();
+		double total = 0;
+		for (size_t lane = 0; lane < Backend::Width; lane++)
+		{
+			min = simd::Scalar::Min(lanes[0][lane], min);
+			max = simd::Scalar::Max(lanes[1][lane], max);
+			total += lanes[2][lane];
+		}
+		for (size_t j = i; j < count; j++)
+		{
+			min = simd::Scalar::Min(column[j], min);
+			max = simd::Scalar::Max(column[j], max);
+			total += column[j];
+		}
+		mean = total / static_cast<double>(count);
+
+		const auto center = Backend::Broadcast(mean);
+		auto squares = Backend::Broadcast(0);
+		for (i = 0; i + Backend::Width <= count; i += Backend::Width)
+		{
+			const auto delta = Backend::Subtract(Backend::Load(&column[i]), center);
+			squares = Backend::Add(squares, Backend::Multiply(delta, delta));
+		}
+		Backend::Store(lanes[0], squares);
+		m2 = 0;
+		for (size_t lane = 0; lane < Backend::Width; lane++)
+		{
+			m2 += lanes[0][lane];
+		}
+		for (size_t j = i; j < count; j++)
+		{
+			m2 += (column[j] - mean) * (column[j] - mean);
+		}
+	}
+
+	FieldSummary ValueSummary(size_t value, uint64_t now) const
+	{
+		const uint64_t epoch = now / bucketLength;
+		FieldSummary summary;
+		double m2 = 0;
+		summary.min = std::numeric_limits<double>::infinity();
+		summary.max = -std::numeric_limits<double>::infinity();
+		for (const Bucket &bucket : window)
+		{
+			if (bucket.count == 0 || bucket.epoch > epoch || bucket.epoch + buckets <= epoch)
+			{
+				continue;
+			}
+			summary.min = simd::Scalar::Min(bucket.min[value], summary.min);
+			summary.max = simd::Scalar::Max(bucket.max[value], summary.max);
+			Merge(summary.count, summary.mean, m2, bucket.count, bucket.mean[value], bucket.m2[value]);
+			summary.count += bucket.count;
+		}
+		if (summary.count == 0)
+		{
+			return FieldSummary();
+		}
+		summary.stddev = std::sqrt(std::max(0.0, m2 / static_cast<double>(summary.count)));
+		return summary;
+	}
+
+	uint64_t bucketLength;
+	std::array<Bucket, buckets> window;
+};
+
+/**
+ * @brief FieldStatistics of several packet types, the statistics of a packet are selected by its type.
+ *
+ * The Update overloads could be called from the handler of a PacketDispatcher with the same packet types.
+ *
+ * @tparam buckets
+ * @tparam Packets
+ */
+template<const size_t buckets, class ...Packets>
+class PacketStatistics
+{
+public:
+	/**
+	 * @brief Construct a new PacketStatistics object.
+	 *
+	 * @param window - Length of the window of all packet types.
+	 */
+	explicit PacketStatistics(uint64_t window) : statistics(FieldStatistics<Packets, buckets>(window)...)
+	{
+	}
+
+	template<class Packet>
+	FieldStatistics<Packet, buckets> &Get()
+	{
+		return std::get<tuple_helper::type_index<Packet, Packets...>()>(statistics);
+	}
+
+	template<class Packet>
+	const FieldStatistics<Packet, buckets> &Get() const
+	{
+		return std::get<tuple_helper::type_index<Packet, Packets...>()>(statistics);
+	}
+
+	template<class Packet>
+	bool Update(const Packet &packet, uint64_t now)
+	{
+		return Get<Packet>().Update(packet, now);
+	}
+
+	template<class Packet, const size_t capacity>
+	bool Update(const PacketColumns<Packet, capacity> &columns, uint64_t now)
+	{
+		return Get<Packet>().Update(columns, now);
+	}
+
+private:
+	std::tuple<FieldStatistics<Packets, buckets>...> statistics;
+};
+}
+#endif
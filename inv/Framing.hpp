@@ -0,0 +1,242 @@
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <array>
+#include <algorithm>
+
+#ifndef FRAMING_HPP__
+#define FRAMING_HPP__
+
+namespace translib
+{
+namespace utils
+{
+/**
+ * @brief Build the lookup table of the CRC-16/CCITT polynomial 0x1021.
+ *
+ * @return constexpr std::array<uint16_t, 256>
+ */
+constexpr std::array<uint16_t, 256> makeCrc16Table()
+{
+	std::array<uint16_t, 256> table = {};
+	for (size_t i = 0; i < 256; i++)
+	{
+		uint16_t crc = static_cast<uint16_t>(i << 8);
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = static_cast<uint16_t>((crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1));
+		}
+		table[i] = crc;
+	}
+	return table;
+}
+
+/**
+ * @brief CRC-16/CCITT-FALSE checksum (polynomial 0x1021, initial value 0xFFFF).
+ *
+ * @param data
+ * @param length
+ * @param crc - Initial value or the result of a previous call to continue the calculation.
+ * @return uint16_t
+ */
+static inline uint16_t crc16(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF)
+{
+	static constexpr std::array<uint16_t, 256> table = makeCrc16Table();
+	for (size_t i = 0; i < length; i++)
+	{
+		crc = static_cast<uint16_t>((crc << 8) ^ table[((crc >> 8) ^ data[i]) & 0xFF]);
+	}
+	return crc;
+}
+}
+
+/**
+ * @brief Framing of serialized packets on a byte stream, for example a serial link, pipe or TCP connection.
+ *
+ * Every frame consists of the sync marker 0xEB 0x90, the payload length as little endian uint16, the payload and a CRC-16/CCITT
+ * over the length and the payload as little endian uint16.
+ *
+ */
+namespace framing
+{
+static const uint8_t SYNC0 = 0xEB;
+static const uint8_t SYNC1 = 0x90;
+static const size_t HEADER_LENGTH = 4;
+static const size_t OVERHEAD = HEADER_LENGTH + 2;
+static const size_t MAX_PAYLOAD_LENGTH = 0xFFFF;
+
+/**
+ * @brief Write a frame around the payload.
+ *
+ * @param out - Output buffer.
+ * @param space - Size of the output buffer.
+ * @param payload
+ * @param length - Length of the payload.
+ * @return size_t The length of the frame or 0 if it doesn't fit into the output buffer.
+ */
+static inline size_t WriteFrame(uint8_t *out, size_t space, const uint8_t *payload, size_t length)
+{
+	if (length > MAX_PAYLOAD_LENGTH || space < length + OVERHEAD)
+	{
+		return 0;
+	}
+	out[0] = SYNC0;
+	out[1] = SYNC1;
+	out[2] = static_cast<uint8_t>(length & 0xFF);
+	out[3] = static_cast<uint8_t>(length >> 8);
+	memcpy(&out[HEADER_LENGTH], payload, length);
+	const uint16_t crc = utils::crc16(&out[2], length + 2);
+	out[HEADER_LENGTH + length] = static_cast<uint8_t>(crc & 0xFF);
+	out[HEADER_LENGTH + length + 1] = static_cast<uint8_t>(crc >> 8);
+	return length + OVERHEAD;
+}
+}
+
+/**
+ * @brief Extracts frames written by framing::WriteFrame from a byte stream.
+ *
+ * The stream could be pushed in chunks of any size. Bytes that don't belong to a valid frame are skipped, after a corrupted frame
+ * the search for the next sync marker starts at the byte after the corrupted sync marker, so no valid frame behind it is lost.
+ * No memory is allocated, the deframer holds a buffer for one frame with the maximum payload length.
+ *
+ * @tparam maxPayloadLength - Frames with a longer payload are treated as corrupted.
+ */
+template<const size_t maxPayloadLength>
+class StreamDeframer
+{
+	static_assert(maxPayloadLength <= framing::MAX_PAYLOAD_LENGTH, "The payload length is limited to 65535 bytes");
+
+public:
+	/**
+	 * @brief Process received bytes.
+	 *
+	 * @tparam Handler - Callable with the signature void(const uint8_t *payload, size_t length). The payload is only valid during the call.
+	 * @param data
+	 * @param length
+	 * @param handler
+	 * @return size_t The number of complete frames.
+	 */
+	template<typename Handler>
+	size_t Push(const uint8_t *data, size_t length, Handler &&handler)
+	{
+		size_t frames = 0;
+		while (length > 0)
+		{
+			const size_t chunk = std::min<size_t>(length, buffer.size() - fill);
+			memcpy(&buffer[fill], data, chunk);
+			fill += chunk;
+			data += chunk;
+			length -= chunk;
+			frames += Parse(handler);
+		}
+		return frames;
+	}
+
+	/**
+	 * @brief Drop all buffered bytes, for example after the connection was reset.
+	 *
+	 */
+	void Reset()
+	{
+		fill = 0;
+	}
+
+	/**
+	 * @brief Get the number of valid frames.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetFrameCount() const
+	{
+		return frameCount;
+	}
+
+	/**
+	 * @brief Get the number of frames with a wrong checksum or an invalid length.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetErrorCount() const
+	{
+		return errorCount;
+	}
+
+	/**
+	 * @brief Get the number of bytes that were skipped while searching for a frame.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t GetSkippedBytes() const
+	{
+		return skippedBytes;
+	}
+
+private:
+	template<typename Handler>
+	size_t Parse(Handler &handler)
+	{
+		size_t frames = 0;
+		size_t position = 0;
+		while (position < fill)
+		{
+			// Search the first sync byte
+			const uint8_t *sync = static_cast<const uint8_t*>(memchr(&buffer[position], framing::SYNC0, fill - position));
+			if (sync == nullptr)
+			{
+				skippedBytes += fill - position;
+				position = fill;
+				break;
+			}
+			const size_t start = static_cast<size_t>(sync - buffer.data());
+			skippedBytes += start - position;
+			position = start;
+			if (fill - position < framing::HEADER_LENGTH)
+			{
+				break;
+			}
+			const size_t length = buffer[position + 2] | (static_cast<size_t>(buffer[position + 3]) << 8);
+			if (buffer[position + 1] != framing::SYNC1 || length > maxPayloadLength)
+			{
+				if (buffer[position + 1] == framing::SYNC1)
+				{
+					errorCount++;
+				}
+				skippedBytes++;
+				position++;
+				continue;
+			}
+			if (fill - position < length + framing::OVERHEAD)
+			{
+				break;
+			}
+			const uint8_t *frame = &buffer[position];
+			const uint16_t crc = frame[framing::HEADER_LENGTH + length] | (frame[framing::HEADER_LENGTH + length + 1] << 8);
+			if (utils::crc16(&frame[2], length + 2) != crc)
+			{
+				errorCount++;
+				skippedBytes++;
+				position++;
+				continue;
+			}
+			frameCount++;
+			frames++;
+			handler(&frame[framing::HEADER_LENGTH], length);
+			position += length + framing::OVERHEAD;
+		}
+		// Keep the incomplete frame at the start of the buffer
+		if (position > 0)
+		{
+			memmove(buffer.data(), &buffer[position], fill - position);
+			fill -= position;
+		}
+		return frames;
+	}
+
+	std::array<uint8_t, maxPayloadLength + framing::OVERHEAD> buffer;
+	size_t fill = 0;
+	uint64_t frameCount = 0;
+	uint64_t errorCount = 0;
+	uint64_t skippedBytes = 0;
+};
+}
+#endif
@@ -0,0 +1,318 @@
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <algorithm>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#ifndef HISTOGRAM_HPP__
+#define HISTOGRAM_HPP__
+
+namespace translib
+{
+namespace utils
+{
+/**
+ * @brief Index of the highest set bit, value must not be 0.
+ *
+ * @param value
+ * @return size_t
+ */
+static inline size_t highestBit(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return 63 - static_cast<size_t>(__builtin_clzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return index;
+#else
+	size_t index = 0;
+	while (value >>= 1)
+	{
+		index++;
+	}
+	return index;
+#endif
+}
+}
+
+/**
+ * @brief Bucket layout of a histogram with logarithmic buckets that are linearly divided.
+ *
+ * Values below 2^precisionBits have their own bucket. Above, every power of two is divided into 2^precisionBits buckets, so the relative
+ * error of a recorded value is below 2^-precisionBits, about 3 % for the default of 5 bits. Values of maxBits bits and more are counted
+ * in the last bucket.
+ *
+ * @tparam precisionBits
+ * @tparam maxBits
+ */
+template<const size_t precisionBits, const size_t maxBits>
+struct HistogramLayout
+{
+	static_assert(precisionBits > 0 && precisionBits < maxBits && maxBits <= 64, "Invalid histogram layout");
+
+	/**
+	 * @brief Number of buckets.
+	 *
+	 */
+	static constexpr size_t BucketCount = (maxBits - precisionBits + 1) << precisionBits;
+
+	/**
+	 * @brief Get the bucket of a value.
+	 *
+	 * @param value
+	 * @return size_t
+	 */
+	static size_t BucketIndex(uint64_t value)
+	{
+		if (value < (uint64_t(1) << precisionBits))
+		{
+			return static_cast<size_t>(value);
+		}
+		const size_t bit = utils::highestBit(value);
+		if (bit >= maxBits)
+		{
+			return BucketCount - 1;
+		}
+		const size_t shift = bit - precisionBits;
+		return ((shift + 1) << precisionBits) + static_cast<size_t>((value >> shift) - (uint64_t(1) << precisionBits));
+	}
+
+	/**
+	 * @brief Smallest value that is counted in the bucket.
+	 *
+	 * @param index
+	 * @return uint64_t
+	 */
+	static constexpr uint64_t LowestValue(size_t index)
+	{
+		if (index < (size_t(1) << precisionBits))
+		{
+			return index;
+		}
+		const size_t shift = (index >> precisionBits) - 1;
+		const uint64_t sub = index & ((size_t(1) << precisionBits) - 1);
+		return ((uint64_t(1) << precisionBits) + sub) << shift;
+	}
+
+	/**
+	 * @brief Largest value that is counted in the bucket, the last bucket also counts all larger values.
+	 *
+	 * @param index
+	 * @return uint64_t
+	 */
+	static constexpr uint64_t HighestValue(size_t index)
+	{
+		if (index < (size_t(1) << precisionBits))
+		{
+			return index;
+		}
+		return LowestValue(index) + (uint64_t(1) << ((index >> precisionBits) - 1)) - 1;
+	}
+};
+
+/**
+ * @brief Copy of the buckets of a Histogram for reading, merging and exporting.
+ *
+ * @tparam precisionBits
+ * @tparam maxBits
+ */
+template<const size_t precisionBits = 5, const size_t maxBits = 40>
+class HistogramSnapshot
+{
+public:
+	using Layout = HistogramLayout<precisionBits, maxBits>;
+
+	/**
+	 * @brief Add the counts of another snapshot, for example of the same value measured on another thread or channel.
+	 *
+	 * @param other
+	 */
+	void Merge(const HistogramSnapshot &other)
+	{
+		for (size_t i = 0; i < Layout::BucketCount; i++)
+		{
+			buckets[i] += other.buckets[i];
+		}
+		count += other.count;
+	}
+
+	/**
+	 * @brief Remove the counts of an earlier snapshot of the same histogram, the result holds the values recorded in between.
+	 *
+	 * @param earlier
+	 */
+	void Subtract(const HistogramSnapshot &earlier)
+	{
+		for (size_t i = 0; i < Layout::BucketCount; i++)
+		{
+			buckets[i] -= std::min(buckets[i], earlier.buckets[i]);
+		}
+		count -= std::min(count, earlier.count);
+	}
+
+	/**
+	 * @brief Get the value below or at which the percentage of the recorded values lie.
+	 *
+	 * The result is the highest value of the bucket, so it is never lower than the exact percentile.
+	 *
+	 * @param percentile - 0 to 100.
+	 * @return uint64_t The value or 0 if no values were recorded.
+	 */
+	uint64_t Percentile(double percentile) const
+	{
+		if (count == 0)
+		{
+			return 0;
+		}
+		const double clamped = std::min(100.0, std::max(0.0, percentile));
+		const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100.0 * count + 0.5));
+		uint64_t seen = 0;
+		for (size_t i = 0; i < Layout::BucketCount; i++)
+		{
+			seen += buckets[i];
+			if (seen >= rank)
+			{
+				return Layout::HighestValue(i);
+			}
+		}
+		return Layout::HighestValue(Layout::BucketCount - 1);
+	}
+
+	/**
+	 * @brief Lowest value of the lowest used bucket, 0 if no values were recorded.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t Min() const
+	{
+		for (size_t i = 0; i < Layout::BucketCount; i++)
+		{
+			if (buckets[i] != 0)
+			{
+				return Layout::LowestValue(i);
+			}
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief Highest value of the highest used bucket, 0 if no values were recorded.
+	 *
+	 * @return uint64_t
+	 */
+	uint64_t Max() const
+	{
+		for (size_t i = Layout::BucketCount; i > 0; i--)
+		{
+			if (buckets[i - 1] != 0)
+			{
+				return Layout::HighestValue(i - 1);
+			}
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief Mean of the recorded values, calculated from the middle of the buckets.
+	 *
+	 * @return double
+	 */
+	double Mean() const
+	{
+		if (count == 0)
+		{
+			return 0.0;
+		}
+		double sum = 0;
+		ForEachBucket([&sum](uint64_t lowest, uint64_t highest, uint64_t bucketCount)
+		{
+			sum += (static_cast<double>(lowest) + static_cast<double>(highest)) / 2 * bucketCount;
+		});
+		return sum / count;
+	}
+
+	uint64_t GetCount() const
+	{
+		return count;
+	}
+
+	/**
+	 * @brief Call function with (lowest value, highest value, count) of every bucket that isn't empty.
+	 *
+	 * @tparam Function
+	 * @param function
+	 */
+	template<typename Function>
+	void ForEachBucket(Function &&function) const
+	{
+		for (size_t i = 0; i < Layout::BucketCount; i++)
+		{
+			if (buckets[i] != 0)
+			{
+				function(Layout::LowestValue(i), Layout::HighestValue(i), buckets[i]);
+			}
+		}
+	}
+
+private:
+	template<const size_t, const size_t>
+	friend class Histogram;
+
+	std::array<uint64_t, Layout::BucketCount> buckets = {};
+	uint64_t count = 0;
+};
+
+/**
+ * @brief Fixed size histogram that could be recorded to from several threads without locks.
+ *
+ * Recording a value is one bucket calculation and one relaxed atomic addition. The memory is fixed, 8 bytes per bucket, about 9 kB for the
+ * defaults, which cover values up to 2^40 (18 minutes in nanoseconds) with a relative error of 3 %.
+ * The histogram is read with Snapshot, the snapshots are merged and exported.
+ *
+ * @tparam precisionBits - The relative error of the recorded values is below 2^-precisionBits.
+ * @tparam maxBits - Values of maxBits bits and more are counted in the last bucket.
+ */
+template<const size_t precisionBits = 5, const size_t maxBits = 40>
+class Histogram
+{
+public:
+	using Layout = HistogramLayout<precisionBits, maxBits>;
+	using SnapshotType = HistogramSnapshot<precisionBits, maxBits>;
+
+	/**
+	 * @brief Record a value.
+	 *
+	 * @param value
+	 */
+	void Record(uint64_t value)
+	{
+		buckets[Layout::BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Copy the buckets.
+	 *
+	 * Values recorded while the snapshot is taken are either counted or not, the count is the sum of the copied buckets.
+	 *
+	 * @return SnapshotType
+	 */
+	SnapshotType Snapshot() const
+	{
+		SnapshotType snapshot;
+		for (size_t i = 0; i < Layout::BucketCount; i++)
+		{
+			snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+			snapshot.count += snapshot.buckets[i];
+		}
+		return snapshot;
+	}
+
+private:
+	std::array<std::atomic<uint64_t>, Layout::BucketCount> buckets = {};
+};
+}
+#endif
@@ -0,0 +1,464 @@
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <type_traits>
+#include <algorithm>
+#include <chrono>
+#include "helper.hpp"
+#include "Histogram.hpp"
+
+#ifndef INSTRUMENTATION_HPP__
+#define INSTRUMENTATION_HPP__
+
+/**
+ * @brief Number of counter slots of every packet type.
+ *
+ * Every thread gets its own slot on the first update, the last slot is shared by all further threads. A thread updates its own slot without
+ * atomic read-modify-write instructions, the shared slot is updated with them. The slots of terminated threads are not reused.
+ * Every slot takes one cache line per packet type.
+ */
+#ifndef BASECOM_COUNTER_SLOTS
+#define BASECOM_COUNTER_SLOTS 8
+#endif
+
+namespace translib
+{
+/**
+ * @brief Instrumentation policy that doesn't record anything, the default of ComPacket and TagedComPacket.
+ *
+ * The hooks of the packets are only compiled if Enabled is true, so this policy adds no code and no data.
+ */
+struct NoInstrumentation
+{
+	static constexpr bool Enabled = false;
+};
+
+namespace instrumentation
+{
+/**
+ * @brief Snapshot of the counters of a packet type.
+ *
+ * The counters only increase, an exporter calculates the rates from the difference of two snapshots.
+ * The byte counters don't include the id of a TagedComPacket.
+ */
+struct PacketCounters
+{
+	uint64_t packetsSerialized = 0;
+	uint64_t bytesSerialized = 0;
+	uint64_t packetsDeserialized = 0;
+	uint64_t bytesDeserialized = 0;
+	uint64_t invalidDecodes = 0;
+	uint64_t idMismatches = 0;
+};
+
+/**
+ * @brief Counters of a packet type that are updated by the threads mapped to this slot.
+ *
+ */
+struct alignas(CACHE_LINE_SIZE) CounterSlot
+{
+	std::atomic<uint64_t> packetsSerialized { 0 };
+	std::atomic<uint64_t> bytesSerialized { 0 };
+	std::atomic<uint64_t> packetsDeserialized { 0 };
+	std::atomic<uint64_t> bytesDeserialized { 0 };
+	std::atomic<uint64_t> invalidDecodes { 0 };
+	std::atomic<uint64_t> idMismatches { 0 };
+};
+
+/**
+ * @brief The counters of a single packet type, an entry in the list of all counted packet types.
+ *
+ */
+class CounterSet
+{
+public:
+	explicit CounterSet(const char *name);
+
+	CounterSet(const CounterSet&) = delete;
+	CounterSet& operator=(const CounterSet&) = delete;
+
+	/**
+	 * @brief Add value to a counter in the slot of the calling thread.
+	 *
+	 * @param counter - The member of the slot, for example &CounterSlot::invalidDecodes.
+	 * @param value
+	 */
+	void Add(std::atomic<uint64_t> CounterSlot::*counter, uint64_t value)
+	{
+		const size_t index = ThreadSlot();
+		std::atomic<uint64_t> &target = slots[index].*counter;
+		if (index < sharedSlot)
+		{
+			// Only this thread writes to the slot, readers see either the old or the new value
+			target.store(target.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+		else
+		{
+			target.fetch_add(value, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * @brief Sum the counters of all slots.
+	 *
+	 * The counters are read one by one while other threads may update them, so the counters of a snapshot could be from slightly different points in time.
+	 *
+	 * @return PacketCounters
+	 */
+	PacketCounters Snapshot() const
+	{
+		PacketCounters counters;
+		for (const CounterSlot &slot : slots)
+		{
+			counters.packetsSerialized += slot.packetsSerialized.load(std::memory_order_relaxed);
+			counters.bytesSerialized += slot.bytesSerialized.load(std::memory_order_relaxed);
+			counters.packetsDeserialized += slot.packetsDeserialized.load(std::memory_order_relaxed);
+			counters.bytesDeserialized += slot.bytesDeserialized.load(std::memory_order_relaxed);
+			counters.invalidDecodes += slot.invalidDecodes.load(std::memory_order_relaxed);
+			counters.idMismatches += slot.idMismatches.load(std::memory_order_relaxed);
+		}
+		return counters;
+	}
+
+	/**
+	 * @brief Name of the packet type or nullptr if the tag of the policy has no name.
+	 *
+	 * @return const char*
+	 */
+	const char* GetName() const
+	{
+		return name;
+	}
+
+	/**
+	 * @brief The next entry in the list of all counted packet types.
+	 *
+	 * @return const CounterSet*
+	 */
+	const CounterSet* GetNext() const
+	{
+		return next;
+	}
+
+	/**
+	 * @brief Index of the slot of the calling thread, assigned on the first call of a thread.
+	 *
+	 * The index is the same for all packet types.
+	 *
+	 * @return size_t
+	 */
+	static size_t ThreadSlot()
+	{
+		static std::atomic<size_t> nextSlot { 0 };
+		static thread_local const size_t slot = std::min<size_t>(nextSlot.fetch_add(1, std::memory_order_relaxed), sharedSlot);
+		return slot;
+	}
+
+private:
+	static_assert(BASECOM_COUNTER_SLOTS > 0, "At least one counter slot is needed");
+	static constexpr size_t sharedSlot = BASECOM_COUNTER_SLOTS - 1;
+
+	std::array<CounterSlot, BASECOM_COUNTER_SLOTS> slots;
+	const char *name;
+	const CounterSet *next = nullptr;
+};
+
+/**
+ * @brief Head of the list of all counted packet types.
+ *
+ * The list is only prepended, a registered entry is never removed.
+ */
+inline std::atomic<const CounterSet*> registryHead { nullptr };
+
+inline CounterSet::CounterSet(const char *name) : name(name)
+{
+	const CounterSet *head = registryHead.load(std::memory_order_relaxed);
+	do
+	{
+		next = head;
+	} while (!registryHead.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+/**
+ * @brief Call function with the name and a snapshot of the counters of every packet type that was used so far.
+ *
+ * The list could be read while other threads register new packet types, these are visible in the next call.
+ *
+ * @tparam Function - Callable with (const char *name, const PacketCounters &counters), the name could be nullptr.
+ * @param function
+ */
+template<typename Function>
+void ForEachCounters(Function &&function)
+{
+	for (const CounterSet *set = registryHead.load(std::memory_order_acquire); set != nullptr; set = set->GetNext())
+	{
+		function(set->GetName(), set->Snapshot());
+	}
+}
+
+/**
+ * @brief Latency histograms of a packet type, an entry in the list of all timed packet types.
+ *
+ */
+class LatencySet
+{
+public:
+	explicit LatencySet(const char *name);
+
+	LatencySet(const LatencySet&) = delete;
+	LatencySet& operator=(const LatencySet&) = delete;
+
+	/**
+	 * @brief Time of the Unserialize calls, valid or not.
+	 *
+	 */
+	Histogram<> decode;
+
+	/**
+	 * @brief Difference of the dispatch time and the send time in the packet.
+	 *
+	 */
+	Histogram<> link;
+
+	const char* GetName() const
+	{
+		return name;
+	}
+
+	const LatencySet* GetNext() const
+	{
+		return next;
+	}
+
+private:
+	const char *name;
+	const LatencySet *next = nullptr;
+};
+
+/**
+ * @brief Head of the list of all timed packet types.
+ *
+ */
+inline std::atomic<const LatencySet*> latencyRegistryHead { nullptr };
+
+inline LatencySet::LatencySet(const char *name) : name(name)
+{
+	const LatencySet *head = latencyRegistryHead.load(std::memory_order_relaxed);
+	do
+	{
+		next = head;
+	} while (!latencyRegistryHead.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+/**
+ * @brief Call function with the name and snapshots of the decode and link histograms of every packet type that was timed so far.
+ *
+ * @tparam Function - Callable with (const char *name, const HistogramSnapshot<> &decode, const HistogramSnapshot<> &link).
+ * @param function
+ */
+template<typename Function>
+void ForEachLatencies(Function &&function)
+{
+	for (const LatencySet *set = latencyRegistryHead.load(std::memory_order_acquire); set != nullptr; set = set->GetNext())
+	{
+		function(set->GetName(), set->decode.Snapshot(), set->link.Snapshot());
+	}
+}
+
+/**
+ * @brief Monotonic clock in nanoseconds, the default clock of LatencyInstrumentation.
+ *
+ */
+struct SteadyClock
+{
+	static uint64_t Now()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+};
+
+/**
+ * @brief True if the policy measures the time of Unserialize.
+ *
+ */
+template<typename Policy, typename = void>
+struct times_decode : std::false_type
+{
+};
+
+template<typename Policy>
+struct times_decode<Policy, std::enable_if_t<Policy::TimesDecode>> : std::true_type
+{
+};
+
+/**
+ * @brief True if the policy has a hook for dispatched packets.
+ *
+ */
+template<typename Policy, typename = void>
+struct records_dispatch : std::false_type
+{
+};
+
+template<typename Policy>
+struct records_dispatch<Policy, std::enable_if_t<Policy::RecordsDispatch>> : std::true_type
+{
+};
+
+/**
+ * @brief True if the packet has a member function GetSendTime.
+ *
+ */
+template<typename Packet, typename = void>
+struct has_send_time : std::false_type
+{
+};
+
+template<typename Packet>
+struct has_send_time<Packet, std::void_t<decltype(std::declval<const Packet&>().GetSendTime())>> : std::true_type
+{
+};
+
+/**
+ * @brief Call the dispatch hook of the instrumentation policy of the packet, called by the PacketDispatcher for every decoded packet.
+ *
+ * @tparam Packet
+ * @param packet
+ */
+template<typename Packet>
+void Dispatched(const Packet &packet)
+{
+	using Policy = typename Packet::InstrumentationPolicy;
+	if constexpr (records_dispatch<Policy>::value)
+	{
+		Policy::template Dispatched<typename Packet::PacketBase>(packet);
+	}
+}
+
+template<typename Tag, typename = void>
+struct tag_name
+{
+	static constexpr const char *value = nullptr;
+};
+
+template<typename Tag>
+struct tag_name<Tag, std::void_t<decltype(Tag::Name)>>
+{
+	static constexpr const char *value = Tag::Name;
+};
+}
+
+/**
+ * @brief Instrumentation policy that counts the packets and bytes of a packet type.
+ *
+ * Every packet type gets its own counters, with one slot per thread on a separate cache line (see BASECOM_COUNTER_SLOTS). The counters are
+ * read with GetCounters of the packet or for all packet types with instrumentation::ForEachCounters.
+ *
+ * The counters are keyed by the BasicComPacket base of the packet (policy and fields), the hooks are called from its member
+ * functions and don't see the derived type. Packet types with the same fields share their counters even if their ids differ, give every
+ * packet type its own tag to separate them. A tag with a member static constexpr const char *Name names the packet type in ForEachCounters.
+ *
+ * @tparam Tag
+ */
+template<typename Tag = void>
+struct CountingInstrumentation
+{
+	static constexpr bool Enabled = true;
+
+	/**
+	 * @brief The counters of a packet type, created and registered on the first use.
+	 *
+	 * @tparam Packet
+	 * @return instrumentation::CounterSet&
+	 */
+	template<typename Packet>
+	static instrumentation::CounterSet& Counters()
+	{
+		static instrumentation::CounterSet counters(instrumentation::tag_name<Tag>::value);
+		return counters;
+	}
+
+	template<typename Packet>
+	static void Serialized(size_t bytes)
+	{
+		instrumentation::CounterSet &counters = Counters<Packet>();
+		counters.Add(&instrumentation::CounterSlot::packetsSerialized, 1);
+		counters.Add(&instrumentation::CounterSlot::bytesSerialized, bytes);
+	}
+
+	template<typename Packet>
+	static void Deserialized(size_t bytes)
+	{
+		instrumentation::CounterSet &counters = Counters<Packet>();
+		counters.Add(&instrumentation::CounterSlot::packetsDeserialized, 1);
+		counters.Add(&instrumentation::CounterSlot::bytesDeserialized, bytes);
+	}
+
+	template<typename Packet>
+	static void InvalidDecode()
+	{
+		Counters<Packet>().Add(&instrumentation::CounterSlot::invalidDecodes, 1);
+	}
+
+	template<typename Packet>
+	static void IDMismatch()
+	{
+		Counters<Packet>().Add(&instrumentation::CounterSlot::idMismatches, 1);
+	}
+};
+
+/**
+ * @brief Instrumentation policy that counts like CountingInstrumentation and records latency histograms of a packet type.
+ *
+ * The decode histogram holds the time of every Unserialize call. The link histogram holds the delay between sending and dispatching of
+ * the packets that were decoded by a PacketDispatcher, if the packet type has a member function GetSendTime that returns the send time in the
+ * unit and epoch of the clock. A send time in the future counts as a delay of 0.
+ * The histograms are read with GetLatencies of the packet or for all packet types with instrumentation::ForEachLatencies.
+ *
+ * @tparam Tag - See CountingInstrumentation.
+ * @tparam Clock - Type with a static function Now that returns the time as uint64_t.
+ */
+template<typename Tag = void, typename Clock = instrumentation::SteadyClock>
+struct LatencyInstrumentation: public CountingInstrumentation<Tag>
+{
+	static constexpr bool TimesDecode = true;
+	static constexpr bool RecordsDispatch = true;
+
+	static uint64_t Now()
+	{
+		return Clock::Now();
+	}
+
+	/**
+	 * @brief The histograms of a packet type, created and registered on the first use.
+	 *
+	 * @tparam Packet
+	 * @return instrumentation::LatencySet&
+	 */
+	template<typename Packet>
+	static instrumentation::LatencySet& Latencies()
+	{
+		static instrumentation::LatencySet latencies(instrumentation::tag_name<Tag>::value);
+		return latencies;
+	}
+
+	template<typename Packet>
+	static void DecodeTime(uint64_t time)
+	{
+		Latencies<Packet>().decode.Record(time);
+	}
+
+	template<typename PacketBase, typename Packet>
+	static void Dispatched(const Packet &packet)
+	{
+		if constexpr (instrumentation::has_send_time<Packet>::value)
+		{
+			const uint64_t now = Clock::Now();
+			const uint64_t sent = static_cast<uint64_t>(packet.GetSendTime());
+			Latencies<PacketBase>().link.Record(now > sent ? now - sent : 0);
+		}
+	}
+};
+}
+#endif
@@ -0,0 +1,289 @@
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include "ComPacket.hpp"
+#include "RawFilter.hpp"
+#include "TextFormat.hpp"
+
+#ifndef JSONEXPORT_HPP__
+#define JSONEXPORT_HPP__
+
+namespace translib
+{
+/**
+ * @brief Writes packets of a type as JSON objects, for example for a dashboard gateway.
+ *
+ * The keys are the FieldNames of the packet type, types without names use field0, field1, ... The key fragments ,"name": of all fields
+ * are built at compile time, so writing a packet only copies the fragments and formats the values. Numbers are formatted with
+ * std::to_chars, floating point values with the shortest representation that reads back to the same value, NaN and infinity as null.
+ * Arrays are JSON arrays, bitfields that list their sub-fields in a static Members array are objects, other bitfields hexadecimal strings.
+ * The names must not contain characters that need escaping.
+ *
+ * dispatcher.Dispatch(data, length, [&](auto &packet) { size_t length = WriteJson(buffer, sizeof(buffer), packet); ... });
+ *
+ * @tparam Packet - ComPacket or TagedComPacket.
+ */
+template<class Packet>
+class JsonWriter
+{
+public:
+	static constexpr size_t FieldCount = std::tuple_size<typename Packet::ElementTypes>::value;
+
+	/**
+	 * @brief Write a packet as JSON object.
+	 *
+	 * @param out
+	 * @param space
+	 * @param packet
+	 * @return size_t The number of written bytes or 0 if the object doesn't fit.
+	 */
+	static size_t Write(char *out, size_t space, const Packet &packet)
+	{
+		utils::TextCursor cursor(out, space);
+		cursor.Put('{');
+		WriteFields(cursor, packet, 1, std::make_index_sequence<FieldCount>());
+		cursor.Put('}');
+		return cursor.GetLength();
+	}
+
+	/**
+	 * @brief Write a packet as JSON object with the timestamp as first member "timestamp".
+	 *
+	 * @param out
+	 * @param space
+	 * @param timestamp
+	 * @param packet
+	 * @return size_t The number of written bytes or 0 if the object doesn't fit.
+	 */
+	static size_t Write(char *out, size_t space, uint64_t timestamp, const Packet &packet)
+	{
+		utils::TextCursor cursor(out, space);
+		cursor.Put("{\"timestamp\":", 13);
+		cursor.Number(timestamp);
+		WriteFields(cursor, packet, 0, std::make_index_sequence<FieldCount>());
+		cursor.Put('}');
+		return cursor.GetLength();
+	}
+
+private:
+	static constexpr std::array<const char*, FieldCount> Names = utils::fieldNames<Packet, FieldCount>();
+
+	static constexpr size_t Digits(size_t value)
+	{
+		size_t digits = 1;
+		for (; value >= 10; value /= 10)
+		{
+			digits++;
+		}
+		return digits;
+	}
+
+	static constexpr size_t NameLength(size_t field)
+	{
+		if (Names[field] == nullptr)
+		{
+			return 5 + Digits(field);
+		}
+		size_t length = 0;
+		while (Names[field][length] != 0)
+		{
+			length++;
+		}
+		return length;
+	}
+
+	static constexpr char NameCharacter(size_t field, size_t i)
+	{
+		if (Names[field] != nullptr)
+		{
+			return Names[field][i];
+		}
+		if (i < 5)
+		{
+			return "field"[i];
+		}
+		size_t value = field;
+		for (size_t digit = Digits(field) - 1; digit > i - 5; digit--)
+		{
+			value /= 10;
+		}
+		return static_cast<char>('0' + value % 10);
+	}
+
+	static constexpr size_t CalculateKeysLength()
+	{
+		size_t length = 0;
+		for (size_t field = 0; field < FieldCount; field++)
+		{
+			length += NameLength(field) + 4;
+		}
+		return length;
+	}
+
+	static constexpr size_t KeysLength = CalculateKeysLength();
+
+	/**
+	 * @brief The fragments ,"name": of all fields one after the other and the offset of every fragment.
+	 *
+	 */
+	struct Keys
+	{
+		std::array<char, KeysLength + 1> text;
+		std::array<size_t, FieldCount + 1> offsets;
+	};
+
+	static constexpr Keys BuildKeys()
+	{
+		Keys keys = {};
+		size_t offset = 0;
+		for (size_t field = 0; field < FieldCount; field++)
+		{
+			keys.offsets[field] = offset;
+			keys.text[offset++] = ',';
+			keys.text[offset++] = '"';
+			for (size_t i = 0; i < NameLength(field); i++)
+			{
+				keys.text[offset++] = NameCharacter(field, i);
+			}
+			keys.text[offset++] = '"';
+			keys.text[offset++] = ':';
+		}
+		keys.offsets[FieldCount] = offset;
+		return keys;
+	}
+
+	static constexpr Keys keys = BuildKeys();
+
+	/**
+	 * @brief Write the key fragments and values of all fields.
+	 *
+	 * @param skip - 1 to skip the comma in front of the first field.
+	 */
+	template<size_t ...I>
+	static void WriteFields(utils::TextCursor &cursor, const Packet &packet, size_t skip, std::index_sequence<I...>)
+	{
+		const auto &elements = packet.GetElements();
+		((cursor.Put(&keys.text[keys.offsets[I] + (I == 0 ? skip : 0)], keys.offsets[I + 1] - keys.offsets[I] - (I == 0 ? skip : 0)),
+		  WriteValue(cursor, get<I>(elements))), ...);
+	}
+
+	template<typename T>
+	static void WriteValue(utils::TextCursor &cursor, const T &value)
+	{
+		if constexpr (std::is_same<T, bool>::value)
+		{
+			cursor.Put(value ? "true" : "false", value ? 4 : 5);
+		}
+		else if constexpr (std::is_floating_point<T>::value)
+		{
+			if (std::isfinite(value))
+			{
+				cursor.Number(value);
+			}
+			else
+			{
+				cursor.Put("null", 4);
+			}
+		}
+		else if constexpr (std::is_arithmetic<T>::value)
+		{
+			cursor.Number(value);
+		}
+		else if constexpr (has_bitfield_members<T>::value)
+		{
+			char separator = '{';
+			for (const BitfieldMember &member : T::Members)
+			{
+				cursor.Put(separator);
+				cursor.Put('"');
+				cursor.Put(member.name);
+				cursor.Put("\":", 2);
+				cursor.Number(value.GetBits(member.offset, member.length));
+				separator = ',';
+			}
+			cursor.Put('}');
+		}
+		else if constexpr (is_bitfield_v<T>)
+		{
+			uint8_t bytes[T::BYTE_LENGTH];
+			for (size_t i = 0; i < T::BYTE_LENGTH; i++)
+			{
+				bytes[i] = value.GetSerializedByte(i);
+			}
+			cursor.Put('"');
+			cursor.Hex(bytes, T::BYTE_LENGTH);
+			cursor.Put('"');
+		}
+		else if constexpr (utils::is_std_array<T>::value)
+		{
+			cursor.Put('[');
+			for (size_t i = 0; i < value.size(); i++)
+			{
+				if (i > 0)
+				{
+					cursor.Put(',');
+				}
+				WriteValue(cursor, value[i]);
+			}
+			cursor.Put(']');
+		}
+		else
+		{
+			WriteString(cursor, value.data(), value.size());
+		}
+	}
+
+	static void WriteString(utils::TextCursor &cursor, const char *text, size_t length)
+	{
+		static const char digits[] = "0123456789abcdef";
+		cursor.Put('"');
+		size_t start = 0;
+		for (size_t i = 0; i < length; i++)
+		{
+			const unsigned char character = static_cast<unsigned char>(text[i]);
+			if (character >= 0x20 && character != '"' && character != '\\')
+			{
+				continue;
+			}
+			// Copy the characters in front at once and escape the character
+			cursor.Put(&text[start], i - start);
+			start = i + 1;
+			if (character == '"' || character == '\\')
+			{
+				const char escaped[2] = { '\\', static_cast<char>(character) };
+				cursor.Put(escaped, 2);
+			}
+			else if (character == '\n')
+			{
+				cursor.Put("\\n", 2);
+			}
+			else
+			{
+				const char escaped[6] = { '\\', 'u', '0', '0', digits[character >> 4], digits[character & 0x0F] };
+				cursor.Put(escaped, 6);
+			}
+		}
+		cursor.Put(&text[start], length - start);
+		cursor.Put('"');
+	}
+};
+
+/**
+ * @brief Write a packet as JSON object, see JsonWriter.
+ *
+ * @tparam Packet
+ * @param out
+ * @param space
+ * @param packet
+ * @return size_t The number of written bytes or 0 if the object doesn't fit.
+ */
+template<class Packet>
+size_t WriteJson(char *out, size_t space, const Packet &packet)
+{
+	return JsonWriter<Packet>::Write(out, space, packet);
+}
+}
+#endif
@@ -0,0 +1,213 @@
+#include <cstddef>
+#include <cstdint>
+#include "Framing.hpp"
+#include "CanTransport.hpp"
+
+#ifndef LINKBUDGET_HPP__
+#define LINKBUDGET_HPP__
+
+namespace translib
+{
+namespace utils
+{
+/**
+ * @brief Capacity of a link that is left when a percentage is kept free, without overflow for large capacities.
+ *
+ * @param capacityBitsPerSecond
+ * @param headroomPercent - 0 to 100.
+ * @return constexpr uint64_t
+ */
+constexpr uint64_t usableCapacity(uint64_t capacityBitsPerSecond, uint64_t headroomPercent)
+{
+	return capacityBitsPerSecond / 100 * (100 - headroomPercent) + capacityBitsPerSecond % 100 * (100 - headroomPercent) / 100;
+}
+
+/**
+ * @brief Fails to compile if the required bits per second exceed the usable bits per second, the compiler shows both values in the error.
+ *
+ * @tparam requiredBitsPerSecond
+ * @tparam usableBitsPerSecond
+ */
+template<const uint64_t requiredBitsPerSecond, const uint64_t usableBitsPerSecond>
+struct LinkBudgetCheck
+{
+	static_assert(requiredBitsPerSecond <= usableBitsPerSecond, "The link is over-subscribed by the schedule");
+	static constexpr bool value = true;
+};
+}
+
+/**
+ * @brief Packets are sent without framing, every byte takes 8 bits on the link.
+ *
+ */
+struct NoFraming
+{
+	static constexpr size_t MaxPayloadLength = SIZE_MAX;
+
+	static constexpr uint64_t FrameBits(size_t length)
+	{
+		return uint64_t(length) * 8;
+	}
+};
+
+/**
+ * @brief Packets are framed with Framing.hpp on a byte stream.
+ *
+ * @tparam bitsPerByte - Bits on the link per byte, 10 for an asynchronous serial link with one start and one stop bit (8N1).
+ */
+template<const uint64_t bitsPerByte = 8>
+struct StreamFraming
+{
+	static constexpr size_t MaxPayloadLength = framing::MAX_PAYLOAD_LENGTH;
+
+	static constexpr uint64_t FrameBits(size_t length)
+	{
+		return uint64_t(length + framing::OVERHEAD) * bitsPerByte;
+	}
+};
+
+/**
+ * @brief Packets are segmented with the IsoTpSegmenter and sent as classic CAN frames.
+ *
+ * Every frame is counted with 8 data bytes and the worst case number of stuff bits, including the interframe space.
+ *
+ * @tparam extended - true if the packets are sent with 29 bit identifiers.
+ */
+template<const bool extended = false>
+struct CanFraming
+{
+	static constexpr size_t MaxPayloadLength = IsoTpSegmenter<8>::MaxPacketLength;
+
+	/**
+	 * @brief Worst case length of a frame with 8 data bytes in bits, from Davis et al., "Controller Area Network (CAN) schedulability analysis".
+	 *
+	 */
+	static constexpr uint64_t BitsPerFrame = (extended ? 54 : 34) + 64 + 13 + ((extended ? 54 : 34) + 64 - 1) / 4;
+
+	static constexpr uint64_t FrameBits(size_t length)
+	{
+		return IsoTpSegmenter<8>::FrameCount(length) * BitsPerFrame;
+	}
+};
+
+/**
+ * @brief Entry of a LinkSchedule, count packets of type Packet are sent every periodMilliseconds.
+ *
+ * The packet is counted with its maximum size, so it must not contain fields of variable length. Use ScheduledLength for those packets.
+ *
+ * @tparam Packet
+ * @tparam count
+ * @tparam periodMilliseconds
+ */
+template<class Packet, const uint64_t count, const uint64_t periodMilliseconds = 1000>
+struct Scheduled
+{
+	static_assert(Packet::SupportsMaxSize, "Only packets with a maximum size could be scheduled, use ScheduledLength for packets with strings");
+	static_assert(count > 0 && periodMilliseconds > 0, "The rate of a scheduled packet must not be 0");
+
+	static constexpr size_t Length = Packet::GetMaxSize();
+	static constexpr uint64_t Count = count;
+	static constexpr uint64_t PeriodMilliseconds = periodMilliseconds;
+};
+
+/**
+ * @brief Entry of a LinkSchedule, count packets of at most length bytes are sent every periodMilliseconds.
+ *
+ * @tparam length
+ * @tparam count
+ * @tparam periodMilliseconds
+ */
+template<const size_t length, const uint64_t count, const uint64_t periodMilliseconds = 1000>
+struct ScheduledLength
+{
+	static_assert(count > 0 && periodMilliseconds > 0, "The rate of a scheduled packet must not be 0");
+
+	static constexpr size_t Length = length;
+	static constexpr uint64_t Count = count;
+	static constexpr uint64_t PeriodMilliseconds = periodMilliseconds;
+};
+
+/**
+ * @brief Worst case load of a link that sends the scheduled packets, calculated at compile time.
+ *
+ * The rates are averages over the period of every entry, packets that are sent as burst within a period are not spread over the period.
+ * All values are rounded up.
+ *
+ * @code
+ * using Downlink = LinkSchedule<StreamFraming<10>, Scheduled<StatusPacket, 10>, Scheduled<EventPacket, 1, 2000>>;
+ * static_assert(AssertLinkBudget<Downlink, 115200, 20>()); // 115200 baud, keep 20 % free
+ * @endcode
+ *
+ * @tparam Framing - NoFraming, StreamFraming, CanFraming or a type with the same members.
+ * @tparam Entries - Scheduled or ScheduledLength entries.
+ */
+template<class Framing, class ...Entries>
+struct LinkSchedule
+{
+	static_assert(((Entries::Length <= Framing::MaxPayloadLength) && ...), "A scheduled packet is too long for the framing");
+
+	/**
+	 * @brief Bits per second of an entry on the link.
+	 *
+	 * @tparam Entry
+	 * @return constexpr uint64_t
+	 */
+	template<class Entry>
+	static constexpr uint64_t EntryBitsPerSecond()
+	{
+		const uint64_t bitsPerPeriod = Framing::FrameBits(Entry::Length) * Entry::Count * 1000;
+		return (bitsPerPeriod + Entry::PeriodMilliseconds - 1) / Entry::PeriodMilliseconds;
+	}
+
+	/**
+	 * @brief Worst case bits per second of all entries on the link, including the framing.
+	 *
+	 */
+	static constexpr uint64_t BitsPerSecond = (EntryBitsPerSecond<Entries>() + ... + 0);
+
+	/**
+	 * @brief Worst case bytes per second of all entries on the link, including the framing.
+	 *
+	 */
+	static constexpr uint64_t BytesPerSecond = (BitsPerSecond + 7) / 8;
+
+	/**
+	 * @brief Get the share of the link capacity that is used by the schedule.
+	 *
+	 * @param capacityBitsPerSecond
+	 * @return constexpr double Above 1 if the link is over-subscribed.
+	 */
+	static constexpr double Utilization(uint64_t capacityBitsPerSecond)
+	{
+		return static_cast<double>(BitsPerSecond) / static_cast<double>(capacityBitsPerSecond);
+	}
+
+	/**
+	 * @brief Check if the schedule fits into the link capacity.
+	 *
+	 * @param capacityBitsPerSecond
+	 * @param headroomPercent - Percentage of the capacity that must stay free, for example for retransmissions.
+	 * @return constexpr bool
+	 */
+	static constexpr bool Fits(uint64_t capacityBitsPerSecond, uint64_t headroomPercent = 0)
+	{
+		return headroomPercent <= 100 && BitsPerSecond <= utils::usableCapacity(capacityBitsPerSecond, headroomPercent);
+	}
+};
+
+/**
+ * @brief Assert at compile time that the schedule fits into the link capacity.
+ *
+ * @tparam Schedule - LinkSchedule.
+ * @tparam capacityBitsPerSecond
+ * @tparam headroomPercent - Percentage of the capacity that must stay free.
+ * @return constexpr bool Always true, an over-subscribed link fails to compile.
+ */
+template<class Schedule, const uint64_t capacityBitsPerSecond, const uint64_t headroomPercent = 0>
+constexpr bool AssertLinkBudget()
+{
+	static_assert(headroomPercent <= 100, "The headroom must not be larger than 100 %");
+	return utils::LinkBudgetCheck<Schedule::BitsPerSecond, utils::usableCapacity(capacityBitsPerSecond, headroomPercent)>::value;
+}
+}
+#endif
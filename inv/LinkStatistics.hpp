@@ -0,0 +1,382 @@
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <cmath>
+#include <atomic>
+#include <array>
+#include <algorithm>
+#include "helper.hpp"
+#include "Histogram.hpp"
+
+#ifndef LINKSTATISTICS_HPP__
+#define LINKSTATISTICS_HPP__
+
+namespace translib
+{
+/**
+ * @brief Direction of the traffic of a LinkStatistics entry.
+ *
+ */
+enum class LinkDirection : uint8_t
+{
+	Transmit = 0,
+	Receive = 1
+};
+
+/**
+ * @brief Statistics of a packet type on a channel at the time of the snapshot.
+ *
+ */
+struct LinkCounters
+{
+	/**
+	 * @brief Number of size buckets, bucket i counts the packets of 2^i to 2^(i+1)-1 bytes, the last bucket all larger packets.
+	 *
+	 */
+	static constexpr size_t SizeBuckets = 16;
+
+	uint64_t packets = 0;
+	uint64_t bytes = 0;
+	uint32_t minSize = 0;
+	uint32_t maxSize = 0;
+	std::array<uint32_t, SizeBuckets> sizes = {};
+	double packetsPerSecond = 0;
+	double bytesPerSecond = 0;
+
+	/**
+	 * @brief Add the counters of another entry, the rates are added as well.
+	 *
+	 * @param other
+	 */
+	void Merge(const LinkCounters &other)
+	{
+		if (other.packets == 0)
+		{
+			return;
+		}
+		minSize = packets == 0 ? other.minSize : std::min(minSize, other.minSize);
+		maxSize = std::max(maxSize, other.maxSize);
+		packets += other.packets;
+		bytes += other.bytes;
+		for (size_t i = 0; i < SizeBuckets; i++)
+		{
+			sizes[i] += other.sizes[i];
+		}
+		packetsPerSecond += other.packetsPerSecond;
+		bytesPerSecond += other.bytesPerSecond;
+	}
+
+	/**
+	 * @brief Mean serialized size of the packets.
+	 *
+	 * @return double
+	 */
+	double MeanSize() const
+	{
+		return packets > 0 ? static_cast<double>(bytes) / packets : 0.0;
+	}
+};
+
+/**
+ * @brief Live traffic statistics per packet type, channel and direction.
+ *
+ * For every packet type on every channel and direction the number of packets and bytes, the distribution of the serialized size and
+ * exponentially decaying estimates of the packet and byte rate are maintained. Packets are recorded with their type or with the index
+ * of the type, which is the same as PacketDispatcher<Packets...>::Lookup returns, an unknown index is counted as an extra type.
+ *
+ * Recording is O(1) and doesn't allocate. The rates are updated once per interval: the packets of the finished interval are folded into the
+ * rate with the weight 1 - exp(-interval / timeConstant), idle intervals decay the rate. The transmit and the receive direction of a channel may
+ * each be recorded by one thread, while any other thread takes snapshots.
+ *
+ * LinkStatistics<2, StatusPacket, EventPacket> statistics(1000000000, 100000000); // 1 s time constant, 100 ms interval
+ * statistics.Record<StatusPacket>(LinkDirection::Transmit, channel, length, now);
+ *
+ * @tparam channels - Number of channels, for example virtual channels of a downlink.
+ * @tparam Packets - The packet types.
+ */
+template<const size_t channels, typename ... Packets>
+class LinkStatistics
+{
+	static_assert(channels > 0, "At least one channel is needed");
+
+public:
+	/**
+	 * @brief Number of packet types, the index PacketCount counts unknown packets.
+	 *
+	 */
+	static constexpr size_t PacketCount = sizeof...(Packets);
+
+	/**
+	 * @brief Construct a new Link Statistics object.
+	 *
+	 * @param timeConstant - Time constant of the rate estimators in nanoseconds.
+	 * @param interval - Interval in nanoseconds after which the rates are updated, should be a fraction of the time constant.
+	 */
+	LinkStatistics(uint64_t timeConstant, uint64_t interval) : interval(std::max<uint64_t>(1, interval)),
+			decay(std::exp(-static_cast<double>(this->interval) / std::max<uint64_t>(1, timeConstant)))
+	{
+		capacities.fill(0);
+	}
+
+	/**
+	 * @brief Get the index of a packet type.
+	 *
+	 * @tparam Packet
+	 * @return constexpr size_t
+	 */
+	template<typename Packet>
+	static constexpr size_t TypeIndex()
+	{
+		constexpr size_t index = tuple_helper::type_index<Packet, Packets...>();
+		static_assert(index < PacketCount, "The packet type isn't part of the statistics");
+		return index;
+	}
+
+	/**
+	 * @brief Record a packet of a known type.
+	 *
+	 * @tparam Packet
+	 * @param direction
+	 * @param channel
+	 * @param bytes - The serialized size of the packet.
+	 * @param now - Time in nanoseconds, must not decrease for a direction of a channel.
+	 */
+	template<typename Packet>
+	void Record(LinkDirection direction, size_t channel, size_t bytes, uint64_t now)
+	{
+		Record(direction, channel, TypeIndex<Packet>(), bytes, now);
+	}
+
+	/**
+	 * @brief Record a packet by the index of its type.
+	 *
+	 * @param direction
+	 * @param channel
+	 * @param type - Index of the packet type, indices of PacketCount and above are counted as unknown packets.
+	 * @param bytes - The serialized size of the packet.
+	 * @param now - Time in nanoseconds, must not decrease for a direction of a channel.
+	 */
+	void Record(LinkDirection direction, size_t channel, size_t type, size_t bytes, uint64_t now)
+	{
+		assert(channel < channels);
+		if (channel >= channels)
+		{
+			return;
+		}
+		Entry &entry = entries[EntryIndex(direction, channel, std::min(type, PacketCount))];
+		const uint32_t size = static_cast<uint32_t>(std::min<size_t>(bytes, UINT32_MAX));
+		const uint64_t packets = Load(entry.packets);
+		if (packets == 0)
+		{
+			entry.intervalStart.store(now, std::memory_order_relaxed);
+			entry.minSize.store(size, std::memory_order_relaxed);
+		}
+		else
+		{
+			if (now - Load(entry.intervalStart) >= interval)
+			{
+				Fold(entry, now);
+			}
+			if (size < Load(entry.minSize))
+			{
+				entry.minSize.store(size, std::memory_order_relaxed);
+			}
+		}
+		if (size > Load(entry.maxSize))
+		{
+			entry.maxSize.store(size, std::memory_order_relaxed);
+		}
+		// Only one thread writes to an entry, so a relaxed load and store is enough
+		entry.packets.store(packets + 1, std::memory_order_relaxed);
+		entry.bytes.store(Load(entry.bytes) + bytes, std::memory_order_relaxed);
+		std::atomic<uint32_t> &bucket = entry.sizes[std::min(LinkCounters::SizeBuckets - 1, size > 0 ? utils::highestBit(size) : 0)];
+		bucket.store(Load(bucket) + 1, std::memory_order_relaxed);
+		entry.intervalPackets.store(Load(entry.intervalPackets) + 1, std::memory_order_relaxed);
+		entry.intervalBytes.store(Load(entry.intervalBytes) + bytes, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Set the capacity of a channel for the utilization in ChannelUtilization.
+	 *
+	 * @param direction
+	 * @param channel
+	 * @param bytesPerSecond
+	 */
+	void SetCapacity(LinkDirection direction, size_t channel, double bytesPerSecond)
+	{
+		assert(channel < channels);
+		if (channel < channels)
+		{
+			capacities[static_cast<size_t>(direction) * channels + channel] = bytesPerSecond;
+		}
+	}
+
+	/**
+	 * @brief Get the statistics of a packet type on a channel.
+	 *
+	 * The rates include the last finished interval and are decayed for the idle intervals until now.
+	 *
+	 * @param direction
+	 * @param channel
+	 * @param type - Index of the packet type, PacketCount for the unknown packets.
+	 * @param now - Time in nanoseconds.
+	 * @return LinkCounters
+	 */
+	LinkCounters Snapshot(LinkDirection direction, size_t channel, size_t type, uint64_t now) const
+	{
+		LinkCounters counters;
+		if (channel >= channels)
+		{
+			return counters;
+		}
+		const Entry &entry = entries[EntryIndex(direction, channel, std::min(type, PacketCount))];
+		counters.packets = Load(entry.packets);
+		counters.bytes = Load(entry.bytes);
+		counters.minSize = Load(entry.minSize);
+		counters.maxSize = Load(entry.maxSize);
+		for (size_t i = 0; i < LinkCounters::SizeBuckets; i++)
+		{
+			counters.sizes[i] = Load(entry.sizes[i]);
+		}
+		CalculateRates(entry, now, counters.packetsPerSecond, counters.bytesPerSecond);
+		return counters;
+	}
+
+	/**
+	 * @brief Get the statistics of all packet types of a channel added up.
+	 *
+	 * @param direction
+	 * @param channel
+	 * @param now
+	 * @return LinkCounters
+	 */
+	LinkCounters ChannelSnapshot(LinkDirection direction, size_t channel, uint64_t now) const
+	{
+		LinkCounters counters;
+		for (size_t type = 0; type <= PacketCount; type++)
+		{
+			counters.Merge(Snapshot(direction, channel, type, now));
+		}
+		return counters;
+	}
+
+	/**
+	 * @brief Byte rate of a channel relative to the capacity set with SetCapacity, 0 if no capacity was set.
+	 *
+	 * @param direction
+	 * @param channel
+	 * @param now
+	 * @return double
+	 */
+	double ChannelUtilization(LinkDirection direction, size_t channel, uint64_t now) const
+	{
+		if (channel >= channels)
+		{
+			return 0.0;
+		}
+		const double capacity = capacities[static_cast<size_t>(direction) * channels + channel];
+		return capacity > 0 ? ChannelSnapshot(direction, channel, now).bytesPerSecond / capacity : 0.0;
+	}
+
+	/**
+	 * @brief Call function for every entry with traffic, a compact export of the statistics.
+	 *
+	 * @tparam Function - Callable with (LinkDirection direction, size_t channel, size_t type, const LinkCounters &counters).
+	 * @param now
+	 * @param function
+	 */
+	template<typename Function>
+	void ForEachActive(uint64_t now, Function &&function) const
+	{
+		for (size_t direction = 0; direction < 2; direction++)
+		{
+			for (size_t channel = 0; channel < channels; channel++)
+			{
+				for (size_t type = 0; type <= PacketCount; type++)
+				{
+					const LinkDirection linkDirection = static_cast<LinkDirection>(direction);
+					if (Load(entries[EntryIndex(linkDirection, channel, type)].packets) != 0)
+					{
+						function(linkDirection, channel, type, Snapshot(linkDirection, channel, type, now));
+					}
+				}
+			}
+		}
+	}
+
+private:
+	struct Entry
+	{
+		std::atomic<uint64_t> packets { 0 };
+		std::atomic<uint64_t> bytes { 0 };
+		std::atomic<uint32_t> minSize { 0 };
+		std::atomic<uint32_t> maxSize { 0 };
+		std::array<std::atomic<uint32_t>, LinkCounters::SizeBuckets> sizes = {};
+		std::atomic<double> packetRate { 0 };
+		std::atomic<double> byteRate { 0 };
+		std::atomic<uint64_t> intervalStart { 0 };
+		std::atomic<uint64_t> intervalPackets { 0 };
+		std::atomic<uint64_t> intervalBytes { 0 };
+	};
+
+	template<typename T>
+	static T Load(const std::atomic<T> &value)
+	{
+		return value.load(std::memory_order_relaxed);
+	}
+
+	static constexpr size_t EntryIndex(LinkDirection direction, size_t channel, size_t type)
+	{
+		return (static_cast<size_t>(direction) * channels + channel) * (PacketCount + 1) + type;
+	}
+
+	/**
+	 * @brief Calculate the rates at now.
+	 *
+	 * If the current interval is finished its packets are folded into the rates and the rates are decayed for the idle intervals after it.
+	 *
+	 * @param entry
+	 * @param now
+	 * @param packetRate
+	 * @param byteRate
+	 */
+	void CalculateRates(const Entry &entry, uint64_t now, double &packetRate, double &byteRate) const
+	{
+		packetRate = Load(entry.packetRate);
+		byteRate = Load(entry.byteRate);
+		const uint64_t start = Load(entry.intervalStart);
+		const uint64_t elapsed = now > start ? (now - start) / interval : 0;
+		if (elapsed > 0)
+		{
+			const double seconds = interval * 1e-9;
+			packetRate = packetRate * decay + (1.0 - decay) * Load(entry.intervalPackets) / seconds;
+			byteRate = byteRate * decay + (1.0 - decay) * Load(entry.intervalBytes) / seconds;
+			if (elapsed > 1)
+			{
+				const double idle = std::pow(decay, static_cast<double>(elapsed - 1));
+				packetRate *= idle;
+				byteRate *= idle;
+			}
+		}
+	}
+
+	void Fold(Entry &entry, uint64_t now)
+	{
+		double packetRate;
+		double byteRate;
+		CalculateRates(entry, now, packetRate, byteRate);
+		entry.packetRate.store(packetRate, std::memory_order_relaxed);
+		entry.byteRate.store(byteRate, std::memory_order_relaxed);
+		const uint64_t start = Load(entry.intervalStart);
+		entry.intervalStart.store(start + (now - start) / interval * interval, std::memory_order_relaxed);
+		entry.intervalPackets.store(0, std::memory_order_relaxed);
+		entry.intervalBytes.store(0, std::memory_order_relaxed);
+	}
+
+	const uint64_t interval;
+	const double decay;
+	std::array<double, 2 * channels> capacities;
+	std::array<Entry, 2 * channels * (PacketCount + 1)> entries;
+};
+}
+#endif
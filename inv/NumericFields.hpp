@@ -0,0 +1,240 @@
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <type_traits>
+#include "helper.hpp"
+
+#ifndef NUMERICFIELDS_HPP__
+#define NUMERICFIELDS_HPP__
+
+namespace translib
+{
+namespace utils
+{
+/**
+ * @brief Number of numeric values of a field, 1 for arithmetic types, the size for arrays of arithmetic types and 0 for all other fields.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct numeric_width : std::integral_constant<size_t, std::is_arithmetic<T>::value ? 1 : 0>
+{
+};
+
+template<typename T, size_t N>
+struct numeric_width<std::array<T, N>> : std::integral_constant<size_t, std::is_arithmetic<T>::value ? N : 0>
+{
+};
+
+template<typename Tuple>
+struct numeric_layout;
+
+template<typename ...T>
+struct numeric_layout<FieldTuple<T...>>
+{
+	static constexpr size_t FieldCount = sizeof...(T);
+	static constexpr size_t ValueCount = (numeric_width<T>::value + ... + 0);
+	static constexpr std::array<size_t, sizeof...(T)> Widths = { numeric_width<T>::value... };
+
+	template<typename Field>
+	static void Gather(const Field &field, double *values, size_t &index, size_t stride)
+	{
+		if constexpr (std::is_arithmetic<Field>::value)
+		{
+			values[index++ * stride] = static_cast<double>(field);
+		}
+		else if constexpr (numeric_width<Field>::value > 0)
+		{
+			for (const auto &value : field)
+			{
+				values[index++ * stride] = static_cast<double>(value);
+			}
+		}
+	}
+};
+}
+
+/**
+ * @brief The numeric values of a packet as flat array of doubles.
+ *
+ * Every arithmetic field is one value, every std::array of an arithmetic type one value per element, all other fields like strings and
+ * bitfields are skipped. The values are numbered in the order of the fields, the mapping between the value index and the field index
+ * is calculated at compile time.
+ *
+ * @tparam Packet - ComPacket or TagedComPacket.
+ */
+template<class Packet>
+struct NumericLayout
+{
+	using Layout = utils::numeric_layout<typename Packet::ElementTypes>;
+
+	/**
+	 * @brief Number of numeric values of the packet.
+	 *
+	 */
+	static constexpr size_t ValueCount = Layout::ValueCount;
+
+	/**
+	 * @brief Number of fields of the packet, including the ones that aren't numeric.
+	 *
+	 */
+	static constexpr size_t FieldCount = Layout::FieldCount;
+
+	/**
+	 * @brief Get the number of numeric values of a field, 0 if the field isn't numeric or doesn't exist.
+	 *
+	 * @param field
+	 * @return constexpr size_t
+	 */
+	static constexpr size_t FieldWidth(size_t field)
+	{
+		return field < FieldCount ? Layout::Widths[field] : 0;
+	}
+
+	/**
+	 * @brief Get the index of the first value of a field.
+	 *
+	 * @param field
+	 * @return constexpr size_t
+	 */
+	static constexpr size_t FieldOffset(size_t field)
+	{
+		size_t offset = 0;
+		for (size_t i = 0; i < field && i < FieldCount; i++)
+		{
+			offset += Layout::Widths[i];
+		}
+		return offset;
+	}
+
+	/**
+	 * @brief Get the field of a value.
+	 *
+	 * @param value - Index of the value, must be below ValueCount.
+	 * @return constexpr size_t
+	 */
+	static constexpr size_t FieldOfValue(size_t value)
+	{
+		return ValueFields[value];
+	}
+
+	/**
+	 * @brief Get the element within its field of a value, 0 for fields that aren't arrays.
+	 *
+	 * @param value - Index of the value, must be below ValueCount.
+	 * @return constexpr size_t
+	 */
+	static constexpr size_t ElementOfValue(size_t value)
+	{
+		return value - FieldOffset(ValueFields[value]);
+	}
+
+	/**
+	 * @brief Copy the numeric values of the packet to values.
+	 *
+	 * @param packet
+	 * @param values - Output with space for ValueCount values.
+	 * @param stride - Distance of two consecutive values in the output, for example the length of the columns of a PacketColumns.
+	 */
+	static void Gather(const Packet &packet, double *values, size_t stride = 1)
+	{
+		size_t index = 0;
+		packet.GetElements().Apply([values, &index, stride](const auto &...fields)
+		{
+			(Layout::Gather(fields, values, index, stride), ...);
+		});
+	}
+
+private:
+	static constexpr std::array<uint16_t, ValueCount> MakeValueFields()
+	{
+		std::array<uint16_t, ValueCount> fields = {};
+		size_t value = 0;
+		for (size_t field = 0; field < FieldCount; field++)
+		{
+			for (size_t i = 0; i < Layout::Widths[field]; i++)
+			{
+				fields[value++] = static_cast<uint16_t>(field);
+			}
+		}
+		return fields;
+	}
+
+	static constexpr std::array<uint16_t, ValueCount> ValueFields = MakeValueFields();
+};
+
+/**
+ * @brief Numeric values of a batch of packets in columnar form, one column of capacity doubles per value of the NumericLayout.
+ *
+ * The columns are filled with Append or written directly, for example by a decoder that produces columns, followed by SetCount.
+ *
+ * @tparam Packet
+ * @tparam capacity - Maximum number of packets in the batch.
+ */
+template<class Packet, const size_t capacity>
+class PacketColumns
+{
+public:
+	using Layout = NumericLayout<Packet>;
+	static constexpr size_t Capacity = capacity;
+
+	/**
+	 * @brief Add the values of a packet to the columns.
+	 *
+	 * @param packet
+	 * @return true The packet was added.
+	 * @return false The batch is full.
+	 */
+	bool Append(const Packet &packet)
+	{
+		if (count >= capacity)
+		{
+			return false;
+		}
+		Layout::Gather(packet, &values[count], capacity);
+		count++;
+		return true;
+	}
+
+	/**
+	 * @brief Get the column of a value.
+	 *
+	 * @param value - Index of the value in the NumericLayout.
+	 * @return const double* Array of capacity values, the first GetCount are valid.
+	 */
+	const double *Column(size_t value) const
+	{
+		return &values[value * capacity];
+	}
+
+	double *Column(size_t value)
+	{
+		return &values[value * capacity];
+	}
+
+	size_t GetCount() const
+	{
+		return count;
+	}
+
+	/**
+	 * @brief Set the number of valid packets after the columns were written directly.
+	 *
+	 * @param newCount - Limited to the capacity.
+	 */
+	void SetCount(size_t newCount)
+	{
+		count = newCount < capacity ? newCount : capacity;
+	}
+
+	void Clear()
+	{
+		count = 0;
+	}
+
+private:
+	std::array<double, Layout::ValueCount * capacity> values = {};
+	size_t count = 0;
+};
+}
+#endif
@@ -0,0 +1,116 @@
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <tuple>
+#include "ComPacket.hpp"
+
+#ifndef PACKETTEMPLATE_HPP__
+#define PACKETTEMPLATE_HPP__
+
+namespace translib
+{
+/**
+ * @brief A TagedComPacket serialized at compile time.
+ *
+ * Constant packets, for example predefined commands, are serialized once into a byte array when the template is constructed in a constant expression.
+ * Sending the packet only copies the bytes, fields that change on every send are overwritten in the copy with Patch.
+ * Only fields with a fixed serialized length are supported, so every field has a constant offset in the packet.
+ *
+ * constexpr TagedComPacket<2, uint8_t, uint32_t> ResetValues({0x20, 0x01}, 3, 0);
+ * constexpr PacketTemplate ResetCommand(ResetValues);
+ *
+ * @tparam idLength
+ * @tparam T
+ */
+template<const size_t idLength, class ... T>
+class PacketTemplate
+{
+	static_assert((utils::is_fixed_size<T>::value && ...), "Packet templates only support fields with a fixed serialized length");
+
+public:
+	using Packet = TagedComPacket<idLength, T...>;
+
+	/**
+	 * @brief Length of the serialized packet including the id.
+	 *
+	 */
+	static const size_t Length = Packet::GetMaxSize();
+
+	/**
+	 * @brief Serialize the packet into the template.
+	 *
+	 * @param packet
+	 */
+	constexpr PacketTemplate(const Packet &packet) : bytes()
+	{
+		for (size_t i = 0; i < idLength; i++)
+		{
+			bytes[i] = packet.GetID()[i];
+		}
+		size_t offset = idLength;
+		packet.GetElements().Apply([this, &offset](const auto &...fields)
+		{	((offset += utils::encodeToBuffer(fields, &bytes[offset])), ...);});
+	}
+
+	/**
+	 * @brief Get the serialized bytes of the template.
+	 *
+	 * @return constexpr const std::array<uint8_t, Length>&
+	 */
+	constexpr const std::array<uint8_t, Length>& GetBytes() const
+	{
+		return bytes;
+	}
+
+	/**
+	 * @brief Get the offset of a field in the serialized packet.
+	 *
+	 * @tparam index - Index of the field in the packet.
+	 * @return constexpr size_t
+	 */
+	template<const size_t index>
+	static constexpr size_t GetFieldOffset()
+	{
+		return idLength + utils::fixed_field_offset<index, T...>::value;
+	}
+
+	/**
+	 * @brief Copy the serialized template to the buffer.
+	 *
+	 * @tparam datalength
+	 * @param buffer
+	 * @return size_t The length of the packet.
+	 */
+	template<const size_t datalength>
+	size_t Emit(std::array<uint8_t, datalength> &buffer) const
+	{
+		static_assert(datalength >= Length, "The output buffer must be large enough to contain the whole packet");
+		memcpy(buffer.data(), bytes.data(), Length);
+		return Length;
+	}
+
+	/**
+	 * @brief Overwrite a field in a buffer that holds a copy of the template.
+	 *
+	 * @tparam index - Index of the field in the packet.
+	 * @tparam datalength
+	 * @param buffer - A buffer filled by Emit.
+	 * @param value - The new value of the field.
+	 */
+	template<const size_t index, const size_t datalength>
+	static void Patch(std::array<uint8_t, datalength> &buffer, const std::tuple_element_t<index, std::tuple<T...>> &value)
+	{
+		static_assert(datalength >= Length, "The buffer must be large enough to contain the whole packet");
+		uint8_t *it = &buffer[GetFieldOffset<index>()];
+		uint8_t *end = buffer.data() + Length;
+		utils::serializeToBuffer(value, it, end);
+	}
+
+private:
+	std::array<uint8_t, Length> bytes;
+};
+
+template<const size_t idLength, class ... T>
+PacketTemplate(const TagedComPacket<idLength, T...>&) -> PacketTemplate<idLength, T...>;
+}
+#endif
@@ -0,0 +1,536 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <array>
+#include <bitset>
+#include <tuple>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include "ComPacket.hpp"
+#include "simd.hpp"
+
+#ifndef RAWFILTER_HPP__
+#define RAWFILTER_HPP__
+
+namespace translib
+{
+namespace utils
+{
+/**
+ * @brief id_length<Packet>::value is the IDLength of a TagedComPacket and 0 for a ComPacket.
+ *
+ * @tparam Packet
+ */
+template<class Packet, typename = void>
+struct id_length : std::integral_constant<size_t, 0>
+{
+};
+
+template<class Packet>
+struct id_length<Packet, std::void_t<decltype(Packet::IDLength)>> : std::integral_constant<size_t, Packet::IDLength>
+{
+};
+
+/**
+ * @brief Number of bytes a serialized field uses in the buffer, without decoding it.
+ *
+ * Returns the same length as deserializeFromBuffer. valid is set to false if the buffer is too short for a field with a fixed length.
+ *
+ * @tparam T
+ * @param data
+ * @param length
+ * @param valid
+ * @return size_t
+ */
+template<typename T>
+static inline size_t skipSerialized(const uint8_t *data, size_t length, const T *, bool &valid)
+{
+	static_assert(is_fixed_size<T>::value, "The field type can't be skipped");
+	(void) data;
+	constexpr size_t fieldLength = fixedSerializedLength<T>();
+	if (length < fieldLength)
+	{
+		valid = false;
+		return length;
+	}
+	return fieldLength;
+}
+
+static inline size_t skipSerialized(const uint8_t *data, size_t length, const string *, bool &valid)
+{
+	(void) valid;
+	const size_t stringlength = scanString(reinterpret_cast<const char*>(data), length);
+	return stringlength < length ? stringlength + 1 : stringlength;
+}
+
+#ifdef USE_ETL
+template<const size_t MAX_SIZE_>
+static inline size_t skipSerialized(const uint8_t *data, size_t length, const etl::string<MAX_SIZE_> *, bool &valid)
+{
+	(void) valid;
+	const size_t window = min<size_t>(length, MAX_SIZE_ + 1);
+	const size_t stringlength = min<size_t>(scanString(reinterpret_cast<const char*>(data), window), MAX_SIZE_);
+	return stringlength < length ? stringlength + 1 : stringlength;
+}
+#endif
+
+template<typename T, size_t arraylength>
+static inline size_t skipSerialized(const uint8_t *data, size_t length, const std::array<T, arraylength> *, bool &valid)
+{
+	size_t readbytes = 0;
+	for (size_t i = 0; i < arraylength; i++)
+	{
+		readbytes += skipSerialized(&data[readbytes], length - readbytes, static_cast<const T*>(nullptr), valid);
+	}
+	return readbytes;
+}
+
+/**
+ * @brief The value type a predicate compares, the field type itself or the element type of an array.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct raw_value
+{
+	using type = T;
+	static constexpr size_t Count = 1;
+};
+
+template<typename T, size_t length>
+struct raw_value<std::array<T, length>>
+{
+	using type = T;
+	static constexpr size_t Count = length;
+};
+
+template<typename Tuple>
+struct raw_layout;
+
+template<typename ...T>
+struct raw_layout<FieldTuple<T...>>
+{
+	static constexpr size_t FieldCount = sizeof...(T);
+
+	template<const size_t index>
+	using Type = std::tuple_element_t<index, std::tuple<T...>>;
+
+	template<const size_t index>
+	static constexpr bool HasFixedOffset()
+	{
+		constexpr bool fixed[] = { is_fixed_size<T>::value... };
+		for (size_t i = 0; i < index; i++)
+		{
+			if (!fixed[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+}
+
+/**
+ * @brief Byte offsets of the fields of a packet type in its serialized form, including the id of a TagedComPacket.
+ *
+ * The offset of a field behind fields with a fixed length is a compile time constant, behind strings the strings are scanned for their
+ * terminator, but no field is decoded.
+ *
+ * @tparam Packet - ComPacket or TagedComPacket.
+ */
+template<class Packet>
+struct RawFields
+{
+	using Layout = utils::raw_layout<typename Packet::ElementTypes>;
+
+	static constexpr size_t IDLength = utils::id_length<Packet>::value;
+	static constexpr size_t FieldCount = Layout::FieldCount;
+
+	template<const size_t index>
+	using Type = typename Layout::template Type<index>;
+
+	/**
+	 * @brief True if all fields in front of the field have a fixed length.
+	 *
+	 * @tparam index - Index of the field in the packet.
+	 * @return constexpr bool
+	 */
+	template<const size_t index>
+	static constexpr bool HasFixedOffset()
+	{
+		return Layout::template HasFixedOffset<index>();
+	}
+
+	/**
+	 * @brief Get the offset of a field behind fields with a fixed length.
+	 *
+	 * @tparam index - Index of the field in the packet.
+	 * @return constexpr size_t
+	 */
+	template<const size_t index>
+	static constexpr size_t FixedOffset()
+	{
+		return IDLength + FixedOffset<index>(std::make_index_sequence<FieldCount>());
+	}
+
+	/**
+	 * @brief Find the offset of a field in a serialized packet.
+	 *
+	 * @tparam index - Index of the field in the packet.
+	 * @param data - The serialized packet including the id.
+	 * @param length
+	 * @param offset - Set to the offset of the field.
+	 * @return true
+	 * @return false The packet ends in front of the field.
+	 */
+	template<const size_t index>
+	static bool Locate(const uint8_t *data, size_t length, size_t &offset)
+	{
+		static_assert(index < FieldCount, "The field index is out of range");
+		if constexpr (HasFixedOffset<index>())
+		{
+			(void) data;
+			offset = FixedOffset<index>();
+			return offset <= length;
+		}
+		else
+		{
+			if (length < IDLength)
+			{
+				return false;
+			}
+			bool valid = true;
+			offset = IDLength;
+			Skip(data, length, offset, valid, std::make_index_sequence<index>());
+			return valid;
+		}
+	}
+
+private:
+	template<const size_t index, size_t ...I>
+	static constexpr size_t FixedOffset(std::index_sequence<I...>)
+	{
+		static_assert(index < FieldCount, "The field index is out of range");
+		static_assert(HasFixedOffset<index>(), "All fields in front of the field must have a fixed size");
+		return ((I < index ? utils::fixedSerializedLength<Type<I>>() : 0) + ... + 0);
+	}
+
+	template<size_t ...I>
+	static void Skip(const uint8_t *data, size_t length, size_t &offset, bool &valid, std::index_sequence<I...>)
+	{
+		((offset += utils::skipSerialized(&data[offset], length - offset, static_cast<const Type<I>*>(nullptr), valid)), ...);
+	}
+};
+
+/**
+ * @brief How a FieldPredicate compares the field with its reference values.
+ *
+ */
+enum class RawCompare : uint8_t
+{
+	Equal,
+	NotEqual,
+	Less,
+	LessEqual,
+	Greater,
+	GreaterEqual,
+	InRange // low <= value <= high
+};
+
+/**
+ * @brief Condition on an arithmetic field, or an element of an arithmetic array field, evaluated on the serialized packet.
+ *
+ * The value is read with a single load at the offset of the field, so packets that don't match are dropped without calling Unserialize.
+ * A single packet is checked with operator(), batches of packets with a fixed length are checked with Evaluate, which compares the
+ * values of 64 packets at a time with the vector backend. 64 bit integers are compared without the backend, because they can't be
+ * converted to double without loss. NaN values match only NotEqual.
+ *
+ * The data must be a packet of the type, for a TagedComPacket the id is only skipped, not compared.
+ *
+ * @code
+ * FieldPredicate<ModePacket, 1> safe(RawCompare::Equal, MODE_SAFE);
+ * if (safe(data, length)) { packet.Unserialize(...); }
+ * @endcode
+ *
+ * @tparam Packet - ComPacket or TagedComPacket.
+ * @tparam index - Index of the field in the packet.
+ * @tparam Backend - simd::Native or simd::Scalar.
+ */
+template<class Packet, const size_t index, class Backend = simd::Native>
+class FieldPredicate
+{
+public:
+	using Fields = RawFields<Packet>;
+	using FieldType = typename Fields::template Type<index>;
+	using ValueType = typename utils::raw_value<FieldType>::type;
+	static_assert(std::is_arithmetic<ValueType>::value, "Only arithmetic fields and arrays of arithmetic types could be filtered");
+
+	/**
+	 * @brief Number of packets Evaluate compares at a time, the number of bits of a word of the result.
+	 *
+	 */
+	static constexpr size_t BlockLength = 64;
+
+	/**
+	 * @brief Construct a predicate that compares the field with a reference value.
+	 *
+	 * @param compare - Any comparison but InRange.
+	 * @param reference
+	 * @param element - Index within an array field.
+	 */
+	FieldPredicate(RawCompare compare, ValueType reference, size_t element = 0)
+		: compare(compare), low(reference), high(reference), element(element)
+	{
+		assert(compare != RawCompare::InRange && "Use the range constructor");
+		assert(element < utils::raw_value<FieldType>::Count);
+	}
+
+	/**
+	 * @brief Construct a predicate that checks if the field is within [low, high].
+	 *
+	 * @param low
+	 * @param high
+	 * @param element - Index within an array field.
+	 */
+	FieldPredicate(ValueType low, ValueType high, size_t element = 0)
+		: compare(RawCompare::InRange), low(low), high(high), element(element)
+	{
+		assert(element < utils::raw_value<FieldType>::Count);
+	}
+
+	/**
+	 * @brief Check a single serialized packet.
+	 *
+	 * @param data - The serialized packet including the id.
+	 * @param length
+	 * @return true
+	 * @return false The packet doesn't match or is too short.
+	 */
+	bool operator()(const uint8_t *data, size_t length) const
+	{
+		size_t offset;
+		if (!Fields::template Locate<index>(data, length, offset))
+		{
+			return false;
+		}
+		offset += element * sizeof(ValueType);
+		if (length < offset || length - offset < sizeof(ValueType))
+		{
+			return false;
+		}
+		ValueType value;
+		memcpy(&value, &data[offset], sizeof(ValueType));
+		return Matches(value);
+	}
+
+	/**
+	 * @brief Check up to BlockLength packets that are stored one after the other.
+	 *
+	 * @param packets - The first serialized packet.
+	 * @param stride - Length of every packet, at least the end of the field.
+	 * @param count - Number of packets, at most BlockLength.
+	 * @return uint64_t Bit i is set if packet i matches.
+	 */
+	uint64_t EvaluateBlock(const uint8_t *packets, size_t stride, size_t count) const
+	{
+		static_assert(Fields::template HasFixedOffset<index>(), "Batches could only be filtered by fields with a fixed offset");
+		assert(count <= BlockLength);
+		assert(stride >= Fields::template FixedOffset<index>() + (element + 1) * sizeof(ValueType));
+		const uint8_t *field = &packets[Fields::template FixedOffset<index>() + element * sizeof(ValueType)];
+		// A full block has a constant length, so the compiler unrolls the loops
+		return count == BlockLength ? CompareBlock<true>(field, stride, count) : CompareBlock<false>(field, stride, count);
+	}
+
+	/**
+	 * @brief Check a batch of packets that are stored one after the other, for example fixed length records of a capture.
+	 *
+	 * @param packets - The first serialized packet.
+	 * @param stride - Length of every packet, at least the end of the field.
+	 * @param count - Number of packets.
+	 * @param matches - Output with one bit per packet, space for (count + 63) / 64 words.
+	 * @return size_t The number of matching packets.
+	 */
+	size_t Evaluate(const uint8_t *packets, size_t stride, size_t count, uint64_t *matches) const
+	{
+		size_t total = 0;
+		for (size_t first = 0; first < count; first += BlockLength)
+		{
+			const uint64_t word = EvaluateBlock(&packets[first * stride], stride, std::min(BlockLength, count - first));
+			matches[first / BlockLength] = word;
+			total += std::bitset<BlockLength>(word).count();
+		}
+		return total;
+	}
+
+private:
+	/**
+	 * @brief Compare the values of a block of packets.
+	 *
+	 * @tparam full - The block has BlockLength packets.
+	 * @param field - The field in the first packet.
+	 * @param stride
+	 * @param count
+	 * @return uint64_t
+	 */
+	template<const bool full>
+	uint64_t CompareBlock(const uint8_t *field, size_t stride, size_t count) const
+	{
+		const size_t length = full ? BlockLength : count;
+		uint64_t matches = 0;
+		if constexpr (std::is_integral<ValueType>::value && sizeof(ValueType) > sizeof(uint32_t))
+		{
+			for (size_t i = 0; i < length; i++)
+			{
+				ValueType value;
+				memcpy(&value, &field[i * stride], sizeof(ValueType));
+				matches |= static_cast<uint64_t>(Matches(value)) << i;
+			}
+		}
+		else
+		{
+			const auto lower = Backend::Broadcast(static_cast<double>(low));
+			const auto upper = Backend::Broadcast(static_cast<double>(high));
+			uint64_t notGreaterEqual = 0;
+			uint64_t notLessEqual = 0;
+			for (size_t i = 0; i < length; i += Backend::Width)
+			{
+				alignas(32) double values[Backend::Width] = {};
+				for (size_t lane = 0; lane < Backend::Width && i + lane < length; lane++)
+				{
+					ValueType value;
+					memcpy(&value, &field[(i + lane) * stride], sizeof(ValueType));
+					values[lane] = static_cast<double>(value);
+				}
+				const auto vector = Backend::Load(values);
+				notGreaterEqual |= static_cast<uint64_t>(Backend::NotGreaterEqual(vector, lower)) << i;
+				notLessEqual |= static_cast<uint64_t>(Backend::NotLessEqual(vector, upper)) << i;
+			}
+			const uint64_t valid = length < BlockLength ? (uint64_t(1) << length) - 1 : ~uint64_t(0);
+			// value >= low and value <= high are both false for NaN, because NaN fails all comparisons
+			matches = Combine(~notGreaterEqual, ~notLessEqual) & valid;
+		}
+		return matches;
+	}
+
+	bool Matches(ValueType value) const
+	{
+		switch (compare)
+		{
+		case RawCompare::Equal:
+			return value == low;
+		case RawCompare::NotEqual:
+			return !(value == low);
+		case RawCompare::Less:
+			return value < low;
+		case RawCompare::LessEqual:
+			return value <= low;
+		case RawCompare::Greater:
+			return value > low;
+		case RawCompare::GreaterEqual:
+			return value >= low;
+		default:
+			return value >= low && value <= high;
+		}
+	}
+
+	/**
+	 * @brief Derive the comparison from value >= low and value <= high, low and high are the same for all but InRange.
+	 *
+	 */
+	uint64_t Combine(uint64_t greaterEqual, uint64_t lessEqual) const
+	{
+		switch (compare)
+		{
+		case RawCompare::Equal:
+			return greaterEqual & lessEqual;
+		case RawCompare::NotEqual:
+			return ~(greaterEqual & lessEqual);
+		case RawCompare::Less:
+			return lessEqual & ~greaterEqual;
+		case RawCompare::LessEqual:
+			return lessEqual;
+		case RawCompare::Greater:
+			return greaterEqual & ~lessEqual;
+		case RawCompare::GreaterEqual:
+			return greaterEqual;
+		default:
+			return greaterEqual & lessEqual;
+		}
+	}
+
+	RawCompare compare;
+	ValueType low;
+	ValueType high;
+	size_t element;
+};
+
+/**
+ * @brief All of several FieldPredicate on the same packet type.
+ *
+ * The predicates are evaluated in order and the evaluation stops at the first one that fails, so the most selective predicate should
+ * be the first one.
+ *
+ * @code
+ * RawFilter filter(FieldPredicate<StatusPacket, 1>(RawCompare::Equal, MODE_SAFE), FieldPredicate<StatusPacket, 3>(-40.0f, 85.0f));
+ * @endcode
+ *
+ * @tparam Predicates
+ */
+template<class ...Predicates>
+class RawFilter
+{
+	static_assert(sizeof...(Predicates) > 0, "At least one predicate is needed");
+
+public:
+	static constexpr size_t BlockLength = 64;
+
+	RawFilter(const Predicates &...predicates) : predicates(predicates...)
+	{
+	}
+
+	/**
+	 * @brief Check a single serialized packet.
+	 *
+	 * @param data - The serialized packet including the id.
+	 * @param length
+	 * @return true if all predicates match.
+	 */
+	bool operator()(const uint8_t *data, size_t length) const
+	{
+		return std::apply([data, length](const auto &...predicate)
+		{	return (predicate(data, length) && ...);}, predicates);
+	}
+
+	/**
+	 * @brief Check a batch of packets that are stored one after the other, see FieldPredicate::Evaluate.
+	 *
+	 * @param packets
+	 * @param stride
+	 * @param count
+	 * @param matches - Output with one bit per packet, space for (count + 63) / 64 words.
+	 * @return size_t The number of packets that match all predicates.
+	 */
+	size_t Evaluate(const uint8_t *packets, size_t stride, size_t count, uint64_t *matches) const
+	{
+		size_t total = 0;
+		for (size_t first = 0; first < count; first += BlockLength)
+		{
+			const size_t length = std::min(BlockLength, count - first);
+			uint64_t word = ~uint64_t(0);
+			std::apply([&](const auto &...predicate)
+			{	((word = word != 0 ? word & predicate.EvaluateBlock(&packets[first * stride], stride, length) : 0), ...);}, predicates);
+			matches[first / BlockLength] = word;
+			total += std::bitset<BlockLength>(word).count();
+		}
+		return total;
+	}
+
+private:
+	std::tuple<Predicates...> predicates;
+};
+}
+#endif
@@ -0,0 +1,309 @@
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <array>
+#include <tuple>
+#include <algorithm>
+#include <type_traits>
+#include <limits>
+#include "ComPacket.hpp"
+
+#ifndef RPC_HPP__
+#define RPC_HPP__
+
+namespace translib
+{
+/**
+ * @brief Namespace for the request/response helper functions.
+ *
+ */
+namespace rpc
+{
+/**
+ * @brief Serialize a TagedComPacket with a correlation id between the packet id and the packet data.
+ *
+ * The resulting layout is [packet id][correlation id][packet data], the correlation id is stored in host byte order.
+ *
+ * @tparam Packet - A type derived from TagedComPacket.
+ * @tparam correlationtype
+ * @tparam datalength
+ * @param packet
+ * @param correlation
+ * @param buffer
+ * @return size_t The number of serialized bytes.
+ */
+template<typename Packet, typename correlationtype, const size_t datalength>
+size_t SerializeWithCorrelation(const Packet &packet, correlationtype correlation, std::array<uint8_t, datalength> &buffer)
+{
+	static_assert(std::is_integral_v<correlationtype>, "The correlation id must be an integral type");
+	const size_t prefixlength = Packet::IDLength + sizeof(correlationtype);
+	std::array<uint8_t, prefixlength> prefix;
+	const auto &id = packet.GetID();
+	std::copy(id.begin(), id.end(), prefix.begin());
+	memcpy(&prefix[Packet::IDLength], &correlation, sizeof(correlation));
+	return static_cast<const typename Packet::PacketBase&>(packet).template Serialize<datalength, prefixlength>(buffer, prefix);
+}
+
+/**
+ * @brief Deserialize a packet that was serialized with SerializeWithCorrelation.
+ *
+ * The id of the supplied packet instance is used to check if the data belongs to this packet type.
+ *
+ * @tparam Packet - A type derived from TagedComPacket.
+ * @tparam correlationtype
+ * @param data
+ * @param length
+ * @param packet - The packet the data is deserialized to.
+ * @param correlation - Is set to the correlation id of the data.
+ * @return true if the id matched and the packet data could be valid.
+ */
+template<typename Packet, typename correlationtype>
+bool UnserializeWithCorrelation(const uint8_t *data, size_t length, Packet &packet, correlationtype &correlation)
+{
+	auto [match, payload, remaining] = packet.CheckIDMatch(data, length);
+	if (!match || remaining < sizeof(correlationtype))
+	{
+		return false;
+	}
+	memcpy(&correlation, payload, sizeof(correlation));
+	auto [readbytes, valid] = Packet::PacketBase::Unserialize(payload + sizeof(correlation), remaining - sizeof(correlation), packet);
+	(void) readbytes;
+	return valid;
+}
+}
+
+/**
+ * @brief Result of a remote procedure call.
+ *
+ */
+enum class RpcStatus
+{
+	Completed,
+	Timeout,
+	Cancelled
+};
+
+/**
+ * @brief Client side of a request/response protocol over TagedComPackets.
+ *
+ * The command type declares its response with a member type ResponseType, for example
+ * using ResponseType = PingResponse;
+ * Both types must be derived from TagedComPacket and must set their id in the default constructor.
+ *
+ * Every sent command gets a new correlation id, that the server copies into the response. The pending commands are stored in a
+ * fixed size open addressing table indexed by the correlation id, so the lookup on a response is O(1) and no memory is allocated.
+ * Callbacks are plain function pointers with a context pointer and are called from HandleResponse, Poll and CancelAll.
+ *
+ * @tparam Command - The command packet type.
+ * @tparam capacity - Maximum number of pending commands, must be a power of two.
+ * @tparam correlationtype - Integral type of the correlation id on the wire.
+ */
+template<typename Command, const size_t capacity, typename correlationtype = uint16_t>
+class RpcClient
+{
+	static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "The capacity must be a power of two");
+	static_assert(std::is_integral_v<correlationtype> && std::is_unsigned_v<correlationtype>, "The correlation id must be an unsigned integral type");
+	static_assert(capacity - 1 <= std::numeric_limits<correlationtype>::max(), "The correlation id type is too small for the capacity");
+
+public:
+	using Response = typename Command::ResponseType;
+	using Callback = void (*)(void *context, RpcStatus status, const Response *response);
+
+	/**
+	 * @brief Serialize the command to the buffer and register the callback for the response.
+	 *
+	 * @tparam datalength
+	 * @param command
+	 * @param buffer - The buffer that is sent to the server.
+	 * @param deadline - Time after which the command times out, in the same unit as the time passed to Poll.
+	 * @param callback
+	 * @param context - Pointer passed to the callback.
+	 * @return size_t The number of serialized bytes, 0 if the table is full or the command couldn't be serialized.
+	 */
+	template<const size_t datalength>
+	size_t Send(const Command &command, std::array<uint8_t, datalength> &buffer, uint64_t deadline, Callback callback, void *context)
+	{
+		if (pending >= capacity)
+		{
+			return 0;
+		}
+		correlationtype correlation = nextCorrelation++;
+		while (Find(correlation) != capacity)
+		{
+			correlation = nextCorrelation++;
+		}
+		const size_t length = rpc::SerializeWithCorrelation(command, correlation, buffer);
+		if (length == 0)
+		{
+			return 0;
+		}
+		size_t index = Home(correlation);
+		while (slots[index].used)
+		{
+			index = (index + 1) & (capacity - 1);
+		}
+		slots[index] = Slot { true, correlation, deadline, callback, context };
+		pending++;
+		return length;
+	}
+
+	/**
+	 * @brief Deserialize a received response and complete the matching command.
+	 *
+	 * @param data
+	 * @param length
+	 * @return true if the data was a valid response to a pending command.
+	 */
+	bool HandleResponse(const uint8_t *data, size_t length)
+	{
+		Response response;
+		correlationtype correlation;
+		if (!rpc::UnserializeWithCorrelation(data, length, response, correlation))
+		{
+			return false;
+		}
+		const size_t index = Find(correlation);
+		if (index == capacity)
+		{
+			return false;
+		}
+		const Slot slot = slots[index];
+		Remove(index);
+		slot.callback(slot.context, RpcStatus::Completed, &response);
+		return true;
+	}
+
+	/**
+	 * @brief Deserialize a received response and complete the matching command.
+	 *
+	 * @tparam datalength
+	 * @param data
+	 * @param length
+	 * @return true if the data was a valid response to a pending command.
+	 */
+	template<const size_t datalength>
+	bool HandleResponse(const std::array<uint8_t, datalength> &data, size_t length)
+	{
+		assert(length <= datalength);
+		return HandleResponse(data.data(), std::min<size_t>(length, datalength));
+	}
+
+	/**
+	 * @brief Time out all commands whose deadline has passed.
+	 *
+	 * @param now
+	 * @return size_t The number of timed out commands.
+	 */
+	size_t Poll(uint64_t now)
+	{
+		size_t expired = 0;
+		size_t index = 0;
+		while (index < capacity)
+		{
+			if (slots[index].used && slots[index].deadline <= now)
+			{
+				const Slot slot = slots[index];
+				Remove(index); // Moves a later entry into this slot, so check the same index again
+				slot.callback(slot.context, RpcStatus::Timeout, nullptr);
+				expired++;
+			}
+			else
+			{
+				index++;
+			}
+		}
+		return expired;
+	}
+
+	/**
+	 * @brief Cancel all pending commands.
+	 *
+	 */
+	void CancelAll()
+	{
+		for (auto &slot : slots)
+		{
+			if (slot.used)
+			{
+				slot.used = false;
+				pending--;
+				slot.callback(slot.context, RpcStatus::Cancelled, nullptr);
+			}
+		}
+	}
+
+	/**
+	 * @brief Get the number of commands waiting for a response.
+	 *
+	 * @return size_t
+	 */
+	size_t GetPendingCount() const
+	{
+		return pending;
+	}
+
+private:
+	struct Slot
+	{
+		bool used;
+		correlationtype correlation;
+		uint64_t deadline;
+		Callback callback;
+		void *context;
+	};
+
+	static size_t Home(correlationtype correlation)
+	{
+		return static_cast<size_t>(correlation) & (capacity - 1);
+	}
+
+	/**
+	 * @brief Search the slot of a correlation id.
+	 *
+	 * @param correlation
+	 * @return size_t The index of the slot or capacity if the id isn't pending.
+	 */
+	size_t Find(correlationtype correlation) const
+	{
+		size_t index = Home(correlation);
+		for (size_t i = 0; i < capacity && slots[index].used; i++)
+		{
+			if (slots[index].correlation == correlation)
+			{
+				return index;
+			}
+			index = (index + 1) & (capacity - 1);
+		}
+		return capacity;
+	}
+
+	/**
+	 * @brief Remove the entry of a slot and shift the following entries of the probe sequence back, so no tombstones are needed.
+	 *
+	 * @param index
+	 */
+	void Remove(size_t index)
+	{
+		slots[index].used = false;
+		pending--;
+		size_t next = (index + 1) & (capacity - 1);
+		while (slots[next].used)
+		{
+			const size_t home = Home(slots[next].correlation);
+			// The entry can be moved to the free slot if the free slot lies cyclically between its home slot and its current slot
+			if (((next - home) & (capacity - 1)) >= ((next - index) & (capacity - 1)))
+			{
+				slots[index] = slots[next];
+				slots[next].used = false;
+				index = next;
+			}
+			next = (next + 1) & (capacity - 1);
+		}
+	}
+
+	std::array<Slot, capacity> slots = {};
+	size_t pending = 0;
+	correlationtype nextCorrelation = 0;
+};
+}
+#endif
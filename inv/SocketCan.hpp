@@ -0,0 +1,185 @@
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <array>
+#include <algorithm>
+#include "CanTransport.hpp"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#endif
+
+#ifndef SOCKETCAN_HPP__
+#define SOCKETCAN_HPP__
+
+#ifdef __linux__
+namespace translib
+{
+/**
+ * @brief CAN bus on Linux using a SocketCAN raw socket.
+ *
+ * Frames are sent and received in batches with sendmmsg and recvmmsg, so a burst of segmented packets needs a single system call.
+ * The bus could be tested without hardware on a virtual interface:
+ * ip link add dev vcan0 type vcan && ip link set up vcan0
+ *
+ * @tparam batchSize - Maximum number of frames per system call.
+ */
+template<const size_t batchSize = 32>
+class SocketCanBus
+{
+public:
+	SocketCanBus() = default;
+	SocketCanBus(const SocketCanBus&) = delete;
+	SocketCanBus& operator=(const SocketCanBus&) = delete;
+
+	~SocketCanBus()
+	{
+		Close();
+	}
+
+	/**
+	 * @brief Open a raw CAN socket on the interface.
+	 *
+	 * @param interface - Name of the interface, for example "can0" or "vcan0".
+	 * @param canfd - Enable CAN FD frames.
+	 * @return true on success, false otherwise. errno holds the reason of the failure.
+	 */
+	bool Open(const char *interface, bool canfd = false)
+	{
+		Close();
+		fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+		if (fd < 0)
+		{
+			return false;
+		}
+		const int enable = canfd ? 1 : 0;
+		if (canfd && setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) != 0)
+		{
+			Close();
+			return false;
+		}
+		struct ifreq ifr = {};
+		strncpy(ifr.ifr_name, interface, IFNAMSIZ - 1);
+		if (ioctl(fd, SIOCGIFINDEX, &ifr) != 0)
+		{
+			Close();
+			return false;
+		}
+		struct sockaddr_can address = {};
+		address.can_family = AF_CAN;
+		address.can_ifindex = ifr.ifr_ifindex;
+		if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0)
+		{
+			Close();
+			return false;
+		}
+		fdFrames = canfd;
+		return true;
+	}
+
+	void Close()
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+
+	/**
+	 * @brief Get the file descriptor of the socket, for example to wait for frames with poll.
+	 *
+	 * @return int
+	 */
+	int GetFileDescriptor() const
+	{
+		return fd;
+	}
+
+	/**
+	 * @brief Send frames.
+	 *
+	 * @param frames
+	 * @param count
+	 * @return size_t The number of sent frames.
+	 */
+	size_t Send(const CanFrame *frames, size_t count)
+	{
+		size_t sent = 0;
+		while (sent < count)
+		{
+			const size_t batch = std::min<size_t>(count - sent, batchSize);
+			for (size_t i = 0; i < batch; i++)
+			{
+				const CanFrame &frame = frames[sent + i];
+				canfd_frame &raw = rawFrames[i];
+				raw.can_id = frame.id;
+				raw.len = frame.length;
+				raw.flags = 0;
+				memcpy(raw.data, frame.data.data(), std::min<size_t>(frame.length, sizeof(raw.data)));
+				PrepareMessage(i, frame.length > CAN_MAX_DLEN ? CANFD_MTU : CAN_MTU);
+			}
+			const int result = sendmmsg(fd, messages.data(), static_cast<unsigned int>(batch), 0);
+			if (result <= 0)
+			{
+				break;
+			}
+			sent += static_cast<size_t>(result);
+		}
+		return sent;
+	}
+
+	/**
+	 * @brief Receive the frames that are available without blocking.
+	 *
+	 * @param frames
+	 * @param maxcount
+	 * @return size_t The number of received frames.
+	 */
+	size_t Receive(CanFrame *frames, size_t maxcount)
+	{
+		const size_t batch = std::min<size_t>(maxcount, batchSize);
+		for (size_t i = 0; i < batch; i++)
+		{
+			PrepareMessage(i, fdFrames ? CANFD_MTU : CAN_MTU);
+		}
+		const int result = recvmmsg(fd, messages.data(), static_cast<unsigned int>(batch), MSG_DONTWAIT, nullptr);
+		if (result <= 0)
+		{
+			return 0;
+		}
+		for (int i = 0; i < result; i++)
+		{
+			const canfd_frame &raw = rawFrames[i];
+			CanFrame &frame = frames[i];
+			frame.id = raw.can_id;
+			frame.length = std::min<uint8_t>(raw.len, static_cast<uint8_t>(frame.data.size()));
+			memcpy(frame.data.data(), raw.data, frame.length);
+		}
+		return static_cast<size_t>(result);
+	}
+
+private:
+	void PrepareMessage(size_t index, size_t mtu)
+	{
+		vectors[index].iov_base = &rawFrames[index];
+		vectors[index].iov_len = mtu;
+		messages[index] = {};
+		messages[index].msg_hdr.msg_iov = &vectors[index];
+		messages[index].msg_hdr.msg_iovlen = 1;
+	}
+
+	int fd = -1;
+	bool fdFrames = false;
+	std::array<canfd_frame, batchSize> rawFrames;
+	std::array<struct iovec, batchSize> vectors;
+	std::array<struct mmsghdr, batchSize> messages;
+};
+}
+#endif
+#endif
@@ -0,0 +1,138 @@
+#include <cstddef>
+#include <atomic>
+#include <array>
+#include "helper.hpp"
+
+#ifndef SPSCQUEUE_HPP__
+#define SPSCQUEUE_HPP__
+
+namespace translib
+{
+/**
+ * @brief Lock free bounded queue for exactly one producer and one consumer thread.
+ *
+ * The elements are stored in a fixed array, no memory is allocated. The read and write indices live on separate cache lines and every side
+ * caches the index of the other side, so the shared cache lines are only touched when the queue seems to be full or empty.
+ *
+ * @tparam T - Element type, must be copy assignable.
+ * @tparam capacity - Number of elements, must be a power of two.
+ */
+template<typename T, const size_t capacity>
+class SpscQueue
+{
+	static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "The capacity must be a power of two");
+
+public:
+	/**
+	 * @brief Append an element, must only be called by the producer thread.
+	 *
+	 * @param element
+	 * @return true if the element was queued, false if the queue is full.
+	 */
+	bool TryPush(const T &element)
+	{
+		T *slot = BeginPush();
+		if (slot == nullptr)
+		{
+			return false;
+		}
+		*slot = element;
+		CommitPush();
+		return true;
+	}
+
+	/**
+	 * @brief Get the slot for the next element to fill it in place, must only be called by the producer thread.
+	 *
+	 * The element is published with CommitPush.
+	 *
+	 * @return T* The free slot or nullptr if the queue is full.
+	 */
+	T *BeginPush()
+	{
+		const size_t write = writeIndex.load(std::memory_order_relaxed);
+		if (write - cachedReadIndex >= capacity)
+		{
+			cachedReadIndex = readIndex.load(std::memory_order_acquire);
+			if (write - cachedReadIndex >= capacity)
+			{
+				return nullptr;
+			}
+		}
+		return &elements[write & (capacity - 1)];
+	}
+
+	/**
+	 * @brief Publish the element filled after BeginPush.
+	 *
+	 */
+	void CommitPush()
+	{
+		writeIndex.store(writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Take the oldest element, must only be called by the consumer thread.
+	 *
+	 * @param element
+	 * @return true if an element was taken, false if the queue is empty.
+	 */
+	bool TryPop(T &element)
+	{
+		const T *front = Front();
+		if (front == nullptr)
+		{
+			return false;
+		}
+		element = *front;
+		Pop();
+		return true;
+	}
+
+	/**
+	 * @brief Get the oldest element without removing it, must only be called by the consumer thread.
+	 *
+	 * @return const T* The element or nullptr if the queue is empty.
+	 */
+	const T *Front()
+	{
+		const size_t read = readIndex.load(std::memory_order_relaxed);
+		if (read == cachedWriteIndex)
+		{
+			cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+			if (read == cachedWriteIndex)
+			{
+				return nullptr;
+			}
+		}
+		return &elements[read & (capacity - 1)];
+	}
+
+	/**
+	 * @brief Remove the element returned by Front.
+	 *
+	 */
+	void Pop()
+	{
+		readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Get the number of queued elements. The result is only a snapshot if the other thread is active.
+	 *
+	 * @return size_t
+	 */
+	size_t Size() const
+	{
+		return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+	}
+
+private:
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> writeIndex { 0 };
+	size_t cachedReadIndex = 0;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> readIndex { 0 };
+	size_t cachedWriteIndex = 0;
+	alignas(CACHE_LINE_SIZE) std::array<T, capacity> elements;
+};
+}
+#endif
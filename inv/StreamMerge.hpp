@@ -0,0 +1,234 @@
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include "Capture.hpp"
+
+#ifndef STREAMMERGE_HPP__
+#define STREAMMERGE_HPP__
+
+namespace translib
+{
+/**
+ * @brief Merges several timestamped packet streams into a single stream ordered by timestamp.
+ *
+ * Each input must deliver its packets in timestamp order. The inputs are any objects that provide
+ * size_t Pull(PacketView *views, size_t maxcount), returning the number of packets written to views and 0 when the input is exhausted,
+ * like the CaptureReader for memory mapped archives. A live link should block in Pull until data is available,
+ * otherwise the merger can't know if a later packet would still be older than the packets of the other inputs.
+ *
+ * The inputs are pulled in batches of batchSize packets and the next packet is selected with a loser tournament tree,
+ * so every packet costs log2(inputs) comparisons. Packets with equal timestamps are delivered in the order of the inputs.
+ * Packet data is never copied, a returned view stays valid until the next call to Next.
+ *
+ * @tparam Source - The type of the inputs.
+ * @tparam maxInputs - Maximum number of inputs.
+ * @tparam batchSize - Number of packets pulled from an input at once.
+ */
+template<typename Source, const size_t maxInputs, const size_t batchSize = 32>
+class StreamMerger
+{
+	static_assert(maxInputs > 0, "At least one input is needed");
+	static_assert(batchSize > 0, "The batch size must not be zero");
+
+	/**
+	 * @brief Number of leaves in the tournament tree, the number of inputs rounded up to the next power of two.
+	 *
+	 * @return constexpr size_t
+	 */
+	static constexpr size_t CalculateLeafCount()
+	{
+		size_t leaves = 1;
+		while (leaves < maxInputs)
+		{
+			leaves *= 2;
+		}
+		return leaves;
+	}
+	static const size_t leafCount = CalculateLeafCount();
+
+	struct Input
+	{
+		Source *source = nullptr;
+		std::array<PacketView, batchSize> batch;
+		size_t position = 0;
+		size_t fill = 0;
+	};
+
+public:
+	/**
+	 * @brief Construct a new Stream Merger object.
+	 *
+	 * @param sources - Array of pointers to the inputs. The inputs must outlive the merger.
+	 * @param count - Number of inputs, must not be greater than maxInputs.
+	 */
+	StreamMerger(Source *const *sources, size_t count)
+	{
+		assert(count <= maxInputs);
+		inputCount = std::min<size_t>(count, maxInputs);
+		exhausted.fill(true);
+		for (size_t i = 0; i < inputCount; i++)
+		{
+			inputs[i].source = sources[i];
+			Refill(i);
+		}
+		Build();
+	}
+
+	/**
+	 * @brief Get the oldest packet of all inputs.
+	 *
+	 * @param view - Is set to the packet.
+	 * @return true if a packet was returned, false if all inputs are exhausted.
+	 */
+	bool Next(PacketView &view)
+	{
+		if (pending)
+		{
+			Advance(tree[0]);
+			pending = false;
+		}
+		const size_t winner = tree[0];
+		if (IsExhausted(winner))
+		{
+			return false;
+		}
+		const Input &input = inputs[winner];
+		view = input.batch[input.position];
+		pending = true;
+		return true;
+	}
+
+	/**
+	 * @brief Deliver all remaining packets in timestamp order to the consumer.
+	 *
+	 * @tparam Consumer - Callable with the signature void(const PacketView &).
+	 * @param consumer
+	 * @return size_t The number of delivered packets.
+	 */
+	template<typename Consumer>
+	size_t Drain(Consumer &&consumer)
+	{
+		size_t count = 0;
+		PacketView view;
+		while (Next(view))
+		{
+			consumer(view);
+			count++;
+		}
+		return count;
+	}
+
+private:
+	bool IsExhausted(size_t index) const
+	{
+		return exhausted[index];
+	}
+
+	/**
+	 * @brief Compare two inputs by the timestamp of their current packet.
+	 *
+	 * Exhausted inputs are greater than every other input, ties are broken by the input index.
+	 *
+	 * @param a
+	 * @param b
+	 * @return true if a must be delivered before b
+	 */
+	bool Before(size_t a, size_t b) const
+	{
+		const bool aexhausted = IsExhausted(a);
+		const bool bexhausted = IsExhausted(b);
+		if (aexhausted || bexhausted)
+		{
+			return !aexhausted || (bexhausted && a < b);
+		}
+		return heads[a] < heads[b] || (heads[a] == heads[b] && a < b);
+	}
+
+	void Refill(size_t index)
+	{
+		Input &input = inputs[index];
+		input.position = 0;
+		input.fill = input.source->Pull(input.batch.data(), batchSize);
+		UpdateHead(index);
+	}
+
+	/**
+	 * @brief Cache the timestamp of the current packet of the input for the comparisons in the tree.
+	 *
+	 * @param index
+	 */
+	void UpdateHead(size_t index)
+	{
+		const Input &input = inputs[index];
+		exhausted[index] = input.position >= input.fill;
+		if (!exhausted[index])
+		{
+			heads[index] = input.batch[input.position].timestamp;
+		}
+	}
+
+	/**
+	 * @brief Play the initial tournament, every internal node stores the loser of its match.
+	 *
+	 */
+	void Build()
+	{
+		std::array<size_t, 2 * leafCount> winners;
+		for (size_t i = 0; i < leafCount; i++)
+		{
+			winners[leafCount + i] = i;
+		}
+		for (size_t node = leafCount - 1; node >= 1; node--)
+		{
+			size_t a = winners[2 * node];
+			size_t b = winners[2 * node + 1];
+			if (Before(b, a))
+			{
+				std::swap(a, b);
+			}
+			winners[node] = a;
+			tree[node] = b;
+		}
+		tree[0] = leafCount > 1 ? winners[1] : 0;
+	}
+
+	/**
+	 * @brief Consume the current packet of the input and replay its path to the root.
+	 *
+	 * @param index
+	 */
+	void Advance(size_t index)
+	{
+		Input &input = inputs[index];
+		input.position++;
+		if (input.position >= input.fill && input.fill > 0)
+		{
+			Refill(index);
+		}
+		else
+		{
+			UpdateHead(index);
+		}
+		size_t winner = index;
+		for (size_t node = (leafCount + index) / 2; node >= 1; node /= 2)
+		{
+			if (Before(tree[node], winner))
+			{
+				std::swap(tree[node], winner);
+			}
+		}
+		tree[0] = winner;
+	}
+
+	std::array<Input, maxInputs> inputs;
+	std::array<size_t, leafCount> tree = {};
+	std::array<uint64_t, leafCount> heads = {};
+	std::array<bool, leafCount> exhausted;
+	size_t inputCount = 0;
+	bool pending = false;
+};
+}
+#endif
@@ -0,0 +1,177 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <array>
+#include <charconv>
+#include <type_traits>
+
+#ifndef TEXTFORMAT_HPP__
+#define TEXTFORMAT_HPP__
+
+namespace translib
+{
+namespace utils
+{
+/**
+ * @brief has_field_names<Packet>::value is true if the packet type lists the names of its fields in a static member FieldNames.
+ *
+ * struct StatusPacket : public TagedComPacket<2, uint8_t, float>
+ * {
+ *     static constexpr std::array<const char *, 2> FieldNames = {{"mode", "temperature"}};
+ * };
+ *
+ * @tparam Packet
+ */
+template<class Packet, typename = void>
+struct has_field_names : std::false_type
+{
+};
+
+template<class Packet>
+struct has_field_names<Packet, std::void_t<decltype(Packet::FieldNames)>> : std::true_type
+{
+};
+
+/**
+ * @brief Get the FieldNames of a packet type, nullptr for all fields if the type has no names.
+ *
+ * @tparam Packet
+ * @tparam count - Number of fields of the packet.
+ * @return constexpr std::array<const char*, count>
+ */
+template<class Packet, const size_t count>
+constexpr std::array<const char*, count> fieldNames()
+{
+	if constexpr (has_field_names<Packet>::value)
+	{
+		static_assert(Packet::FieldNames.size() == count, "FieldNames must have one name per field");
+		return Packet::FieldNames;
+	}
+	else
+	{
+		return {};
+	}
+}
+
+/**
+ * @brief Writes text into a caller provided buffer, used by the text exporters.
+ *
+ * All writes check the space, once a write didn't fit the cursor is marked as full and ignores all further writes, so a row is written
+ * without checks in between and the result is checked once at the end.
+ *
+ */
+class TextCursor
+{
+public:
+	TextCursor(char *out, size_t space) : begin(out), position(out), end(out + space)
+	{
+	}
+
+	void Put(char character)
+	{
+		if (position < end)
+		{
+			*position++ = character;
+		}
+		else
+		{
+			Overflow();
+		}
+	}
+
+	void Put(const char *text, size_t length)
+	{
+		if (static_cast<size_t>(end - position) >= length)
+		{
+			memcpy(position, text, length);
+			position += length;
+		}
+		else
+		{
+			Overflow();
+		}
+	}
+
+	void Put(const char *text)
+	{
+		Put(text, strlen(text));
+	}
+
+	/**
+	 * @brief Write a number, floating point values are written with the shortest representation that reads back to the same value.
+	 *
+	 * @tparam T - Arithmetic type but bool.
+	 * @param value
+	 */
+	template<typename T>
+	void Number(T value)
+	{
+		static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "Only numbers could be formatted");
+#if !defined(__cpp_lib_to_chars) || __cpp_lib_to_chars < 201611L
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			// Library without floating point to_chars, 17 digits always read back to the same double
+			char text[32];
+			const int length = snprintf(text, sizeof(text), "%.*g", std::is_same<T, float>::value ? 9 : 17, static_cast<double>(value));
+			Put(text, static_cast<size_t>(length));
+			return;
+		}
+#endif
+		const std::to_chars_result result = std::to_chars(position, end, value);
+		if (result.ec == std::errc())
+		{
+			position = result.ptr;
+		}
+		else
+		{
+			Overflow();
+		}
+	}
+
+	/**
+	 * @brief Write a value as hexadecimal digits.
+	 *
+	 * @param data
+	 * @param length
+	 */
+	void Hex(const uint8_t *data, size_t length)
+	{
+		static const char digits[] = "0123456789abcdef";
+		if (static_cast<size_t>(end - position) < 2 * length)
+		{
+			Overflow();
+			return;
+		}
+		for (size_t i = 0; i < length; i++)
+		{
+			*position++ = digits[data[i] >> 4];
+			*position++ = digits[data[i] & 0x0F];
+		}
+	}
+
+	/**
+	 * @brief Get the number of written bytes.
+	 *
+	 * @return size_t 0 if a write didn't fit.
+	 */
+	size_t GetLength() const
+	{
+		return position - begin;
+	}
+
+private:
+	void Overflow()
+	{
+		// Every following check fails and GetLength returns 0
+		position = begin;
+		end = begin;
+	}
+
+	char *begin;
+	char *position;
+	char *end;
+};
+}
+}
+#endif
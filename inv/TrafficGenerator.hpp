@@ -0,0 +1,551 @@
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <cassert>
+#include <cmath>
+#include <array>
+#include <tuple>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include "ComPacket.hpp"
+#include "Capture.hpp"
+#include "RawFilter.hpp"
+#include "hash.hpp"
+
+#ifndef TRAFFICGENERATOR_HPP__
+#define TRAFFICGENERATOR_HPP__
+
+namespace translib
+{
+/**
+ * @brief How the generator fills the fields of a packet.
+ *
+ */
+enum class TrafficFill : uint8_t
+{
+	Random, // Random values, floating point values uniform between low and high
+	Pattern // Values derived from the sequence number of the packet, so a receiver could check them
+};
+
+/**
+ * @brief Settings of a TrafficGenerator.
+ *
+ */
+struct TrafficOptions
+{
+	TrafficFill fill = TrafficFill::Random;
+	double low = -1000.0;               // Range of random floating point values
+	double high = 1000.0;
+	size_t maxStringLength = 16;        // Maximum length of std::string fields, etl::string fields are limited by their capacity
+	double truncateProbability = 0.0;   // Probability that a packet is cut at a random length
+	double bitErrorRate = 0.0;          // Probability that a serialized bit is flipped
+};
+
+/**
+ * @brief Counters of a TrafficGenerator.
+ *
+ */
+struct TrafficCounters
+{
+	uint64_t packets = 0;
+	uint64_t bytes = 0;
+	uint64_t truncated = 0;   // Packets cut short
+	uint64_t corrupted = 0;   // Packets with at least one flipped bit
+	uint64_t flippedBits = 0;
+
+	void Merge(const TrafficCounters &other)
+	{
+		packets += other.packets;
+		bytes += other.bytes;
+		truncated += other.truncated;
+		corrupted += other.corrupted;
+		flippedBits += other.flippedBits;
+	}
+};
+
+/**
+ * @brief Description of a generated packet.
+ *
+ */
+struct GeneratedPacket
+{
+	size_t type;             // Index of the packet type
+	size_t length;           // Length of the written packet
+	size_t serializedLength; // Length before the truncation
+	size_t flippedBits;
+};
+
+namespace utils
+{
+/**
+ * @brief Small and fast pseudo random generator (SplitMix64) for test traffic, not suited for cryptography.
+ *
+ */
+class TrafficRandom
+{
+public:
+	explicit TrafficRandom(uint64_t seed) : state(seed)
+	{
+	}
+
+	uint64_t Next()
+	{
+		state += 0x9E3779B97F4A7C15ULL;
+		return hashMix(state);
+	}
+
+	/**
+	 * @brief Get a random value below bound.
+	 *
+	 * @param bound - Must be greater than 0.
+	 * @return uint64_t
+	 */
+	uint64_t Below(uint64_t bound)
+	{
+		return Next() % bound;
+	}
+
+	/**
+	 * @brief Get a random value in [0, 1).
+	 *
+	 * @return double
+	 */
+	double Uniform()
+	{
+		return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+private:
+	uint64_t state;
+};
+
+/**
+ * @brief string_capacity<T>::value is the maximum length of a string type, 0 if it is unlimited.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct string_capacity : std::integral_constant<size_t, 0>
+{
+};
+
+#ifdef USE_ETL
+template<const size_t MAX_SIZE_>
+struct string_capacity<etl::string<MAX_SIZE_>> : std::integral_constant<size_t, MAX_SIZE_>
+{
+};
+#endif
+}
+
+/**
+ * @brief Generates serialized packets of a list of packet types as synthetic traffic, for example for load tests of an ingest pipeline.
+ *
+ * The type of every packet is drawn according to the weights of the types, all fields are filled with random or pattern data and the
+ * packet is serialized into a caller provided buffer. Strings only contain printable characters and respect the capacity of etl::string
+ * fields, bitfields that list their sub-fields in a static Members array get a value within the width of every sub-field, other
+ * bitfields random bits within their bit length. Optionally packets are truncated and bits are flipped to simulate a noisy link.
+ *
+ * A generator isn't thread safe, GenerateParallel uses one generator per thread with a seed derived from the seed of this generator.
+ *
+ * @code
+ * TrafficGenerator<StatusPacket, EventPacket> generator;
+ * generator.SetWeight(1, 10); // Ten times more events than status packets
+ * size_t length = generator.GenerateCapture(buffer, sizeof(buffer), 100000, 0, 1000);
+ * @endcode
+ *
+ * @tparam Packets - ComPacket or TagedComPacket types with a default constructor that sets the id.
+ */
+template<typename ... Packets>
+class TrafficGenerator
+{
+	static_assert(sizeof...(Packets) > 0, "At least one packet type is needed");
+
+public:
+	/**
+	 * @brief Number of packet types.
+	 *
+	 */
+	static const size_t PacketCount = sizeof...(Packets);
+
+	explicit TrafficGenerator(const TrafficOptions &options = TrafficOptions(), uint64_t seed = 1) : options(options), seed(seed), random(seed)
+	{
+		weights.fill(1);
+		untilError = NextErrorDistance();
+	}
+
+	/**
+	 * @brief Set the relative frequency of a packet type, all types have the weight 1 by default.
+	 *
+	 * @param type - Index of the packet type in Packets.
+	 * @param weight - 0 to never generate the type.
+	 */
+	void SetWeight(size_t type, uint32_t weight)
+	{
+		assert(type < PacketCount);
+		weights[type] = weight;
+	}
+
+	/**
+	 * @brief Set the sequence number of the next packet, the pattern data is derived from it.
+	 *
+	 * @param next
+	 */
+	void SetSequence(uint64_t next)
+	{
+		sequence = next;
+	}
+
+	/**
+	 * @brief Generate a packet.
+	 *
+	 * @param out - Buffer for the serialized packet.
+	 * @param space - Length of the buffer.
+	 * @param info - Optional description of the generated packet.
+	 * @return size_t The length of the packet or 0 if it doesn't fit into the buffer or all weights are 0.
+	 */
+	size_t Generate(uint8_t *out, size_t space, GeneratedPacket *info = nullptr)
+	{
+		const size_t type = DrawType();
+		if (type >= PacketCount)
+		{
+			return 0;
+		}
+		size_t length = 0;
+		GenerateType(type, out, space, length, std::index_sequence_for<Packets...>());
+		sequence++;
+		if (length == 0)
+		{
+			return 0;
+		}
+		const size_t serializedLength = length;
+		if (options.truncateProbability > 0 && length > 1 && random.Uniform() < options.truncateProbability)
+		{
+			length = 1 + static_cast<size_t>(random.Below(length - 1));
+			counters.truncated++;
+		}
+		const size_t flipped = InjectBitErrors(out, length);
+		counters.packets++;
+		counters.bytes += length;
+		if (info != nullptr)
+		{
+			*info = GeneratedPacket { type, length, serializedLength, flipped };
+		}
+		return length;
+	}
+
+	/**
+	 * @brief Generate packets as records of a capture, see WriteCaptureRecord.
+	 *
+	 * @param out - Buffer for the capture.
+	 * @param space - Length of the buffer.
+	 * @param count - Number of packets.
+	 * @param timestamp - Timestamp of the first packet.
+	 * @param interval - Time between two packets.
+	 * @return size_t The length of the capture, less packets are written if the buffer is full.
+	 */
+	size_t GenerateCapture(uint8_t *out, size_t space, size_t count, uint64_t timestamp, uint64_t interval)
+	{
+		size_t used = 0;
+		for (size_t i = 0; i < count && space - used > CAPTURE_RECORD_HEADER_LENGTH; i++)
+		{
+			uint8_t *record = &out[used];
+			const size_t length = Generate(&record[CAPTURE_RECORD_HEADER_LENGTH], space - used - CAPTURE_RECORD_HEADER_LENGTH);
+			if (length == 0)
+			{
+				break;
+			}
+			const uint64_t time = timestamp + i * interval;
+			const uint32_t recordlength = static_cast<uint32_t>(length);
+			memcpy(record, &time, sizeof(time));
+			memcpy(&record[sizeof(time)], &recordlength, sizeof(recordlength));
+			used += CAPTURE_RECORD_HEADER_LENGTH + length;
+		}
+		return used;
+	}
+
+	/**
+	 * @brief Generate a capture on several threads, every thread writes into its own part of the buffer.
+	 *
+	 * Thread i generates the packets i * count / threads to (i + 1) * count / threads - 1 with their timestamps and sequence numbers into
+	 * the i-th part of bufferLength / threads bytes. The segments are in the order of the packets but not contiguous.
+	 *
+	 * @param buffer
+	 * @param bufferLength
+	 * @param count - Number of packets of all threads.
+	 * @param timestamp - Timestamp of the first packet.
+	 * @param interval - Time between two packets.
+	 * @param segments - Output for one segment per thread.
+	 * @param threads - Number of threads and segments.
+	 * @return size_t The number of generated packets.
+	 */
+	size_t GenerateParallel(uint8_t *buffer, size_t bufferLength, size_t count, uint64_t timestamp, uint64_t interval, CaptureSegment *segments,
+			size_t threads)
+	{
+		if (threads == 0)
+		{
+			return 0;
+		}
+		const TrafficCounters generated = GenerateRange(buffer, bufferLength / threads, count, timestamp, interval, segments, 0, threads, threads);
+		counters.Merge(generated);
+		sequence += count;
+		return generated.packets;
+	}
+
+	const TrafficCounters& GetCounters() const
+	{
+		return counters;
+	}
+
+	/**
+	 * @brief Get the instance of a packet type that holds the last generated values of the type.
+	 *
+	 * @tparam Packet
+	 * @return Packet&
+	 */
+	template<typename Packet>
+	Packet& Get()
+	{
+		return std::get<Packet>(packets);
+	}
+
+private:
+	size_t DrawType()
+	{
+		if constexpr (PacketCount == 1)
+		{
+			return weights[0] > 0 ? 0 : PacketCount;
+		}
+		else
+		{
+			uint64_t total = 0;
+			for (const uint32_t weight : weights)
+			{
+				total += weight;
+			}
+			if (total == 0)
+			{
+				return PacketCount;
+			}
+			uint64_t pick = random.Below(total);
+			size_t type = 0;
+			while (pick >= weights[type])
+			{
+				pick -= weights[type];
+				type++;
+			}
+			return type;
+		}
+	}
+
+	template<size_t ...I>
+	void GenerateType(size_t type, uint8_t *out, size_t space, size_t &length, std::index_sequence<I...>)
+	{
+		((type == I ? (length = GeneratePacket(std::get<I>(packets), out, space), true) : false) || ...);
+	}
+
+	template<typename Packet>
+	size_t GeneratePacket(Packet &packet, uint8_t *out, size_t space)
+	{
+		uint64_t element = 0;
+		packet.GetElements().Apply([this, &element](auto &...fields)
+		{	(FillValue(fields, element), ...);});
+		if constexpr (utils::id_length<Packet>::value > 0)
+		{
+			return packet.Serialize(out, space);
+		}
+		else
+		{
+			return packet.Serialize(out, space, std::array<uint8_t, 0>());
+		}
+	}
+
+	/**
+	 * @brief Get the raw value of the next element, the element counter numbers the values within a packet.
+	 *
+	 */
+	uint64_t NextBits(uint64_t &element)
+	{
+		return options.fill == TrafficFill::Random ? random.Next() : sequence + element++;
+	}
+
+	template<typename T>
+	void FillValue(T &value, uint64_t &element)
+	{
+		if constexpr (std::is_same<T, bool>::value)
+		{
+			value = (NextBits(element) & 1) != 0;
+		}
+		else if constexpr (std::is_floating_point<T>::value)
+		{
+			if (options.fill == TrafficFill::Random)
+			{
+				value = static_cast<T>(options.low + (options.high - options.low) * random.Uniform());
+			}
+			else
+			{
+				value = static_cast<T>(NextBits(element) % 1000000);
+			}
+		}
+		else if constexpr (std::is_arithmetic<T>::value)
+		{
+			value = static_cast<T>(NextBits(element));
+		}
+		else if constexpr (is_bitfield_v<T>)
+		{
+			FillBitfield(value, element);
+		}
+		else if constexpr (utils::is_std_array<T>::value)
+		{
+			for (auto &item : value)
+			{
+				FillValue(item, element);
+			}
+		}
+		else
+		{
+			FillString(value, utils::string_capacity<T>::value > 0 ? utils::string_capacity<T>::value : options.maxStringLength, element);
+		}
+	}
+
+	template<typename T>
+	void FillBitfield(T &value, uint64_t &element)
+	{
+		uint8_t bytes[T::BYTE_LENGTH] = {};
+		auto setBits = [&bytes](size_t offset, size_t length, uint64_t bits)
+		{
+			for (size_t i = 0; i < length; i++)
+			{
+				const size_t bit = offset + i;
+				bytes[bit / 8] |= static_cast<uint8_t>(((bits >> (i % 64)) & 1) << (bit % 8));
+			}
+		};
+		if constexpr (has_bitfield_members<T>::value)
+		{
+			for (const BitfieldMember &member : T::Members)
+			{
+				setBits(member.offset, member.length, NextBits(element));
+			}
+		}
+		else
+		{
+			for (size_t offset = 0; offset < T::BIT_LENGTH; offset += 64)
+			{
+				setBits(offset, std::min<size_t>(64, T::BIT_LENGTH - offset), NextBits(element));
+			}
+		}
+		bool valid = true;
+		value.ParseData(bytes, T::BYTE_LENGTH, valid);
+	}
+
+	template<typename T>
+	void FillString(T &value, size_t maxLength, uint64_t &element)
+	{
+		const uint64_t bits = NextBits(element);
+		const size_t length = options.fill == TrafficFill::Random ? static_cast<size_t>(random.Below(maxLength + 1)) : bits % (maxLength + 1);
+		value.resize(length);
+		uint64_t characters = 0;
+		for (size_t i = 0; i < length; i++)
+		{
+			if (options.fill == TrafficFill::Pattern)
+			{
+				value[i] = static_cast<char>('a' + (bits + i) % 26);
+				continue;
+			}
+			if (i % 8 == 0)
+			{
+				characters = random.Next();
+			}
+			// Printable characters only, a zero byte would end the serialized string
+			value[i] = static_cast<char>(' ' + (characters & 0xFF) % 95);
+			characters >>= 8;
+		}
+	}
+
+	/**
+	 * @brief Get the number of correct bits in front of the next bit error, geometric distributed.
+	 *
+	 */
+	uint64_t NextErrorDistance()
+	{
+		if (options.bitErrorRate <= 0)
+		{
+			return UINT64_MAX;
+		}
+		if (options.bitErrorRate >= 1)
+		{
+			return 0;
+		}
+		const double distance = std::floor(std::log(1.0 - random.Uniform()) / std::log1p(-options.bitErrorRate));
+		return distance < 1e18 ? static_cast<uint64_t>(distance) : UINT64_MAX;
+	}
+
+	/**
+	 * @brief Flip bits with the bit error rate, the distance to the next error spans packets, so the rate holds for the whole stream.
+	 *
+	 * @return size_t The number of flipped bits.
+	 */
+	size_t InjectBitErrors(uint8_t *data, size_t length)
+	{
+		if (options.bitErrorRate <= 0)
+		{
+			return 0;
+		}
+		const uint64_t bits = static_cast<uint64_t>(length) * 8;
+		size_t flipped = 0;
+		uint64_t bit = untilError;
+		while (bit < bits)
+		{
+			data[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+			flipped++;
+			bit += 1 + NextErrorDistance();
+		}
+		untilError = bit - bits;
+		if (flipped > 0)
+		{
+			counters.corrupted++;
+			counters.flippedBits += flipped;
+		}
+		return flipped;
+	}
+
+	/**
+	 * @brief Generate the packets of the threads first to first + count - 1, the first half on a new thread, recursively.
+	 *
+	 */
+	TrafficCounters GenerateRange(uint8_t *buffer, size_t partLength, size_t total, uint64_t timestamp, uint64_t interval, CaptureSegment *segments,
+			size_t first, size_t count, size_t threads) const
+	{
+		if (count == 1)
+		{
+			const size_t begin = first * total / threads;
+			const size_t end = (first + 1) * total / threads;
+			TrafficGenerator worker(options, utils::hashMix(seed + first + 1));
+			worker.weights = weights;
+			worker.sequence = sequence + begin;
+			uint8_t *part = &buffer[first * partLength];
+			segments[first] = CaptureSegment { part, worker.GenerateCapture(part, partLength, end - begin, timestamp + begin * interval, interval) };
+			return worker.counters;
+		}
+		const size_t half = count / 2;
+		TrafficCounters generated;
+		std::thread thread([&]()
+		{	generated = GenerateRange(buffer, partLength, total, timestamp, interval, segments, first, half, threads);});
+		const TrafficCounters other = GenerateRange(buffer, partLength, total, timestamp, interval, segments, first + half, count - half, threads);
+		thread.join();
+		generated.Merge(other);
+		return generated;
+	}
+
+	TrafficOptions options;
+	uint64_t seed;
+	utils::TrafficRandom random;
+	std::array<uint32_t, PacketCount> weights;
+	std::tuple<Packets...> packets;
+	uint64_t sequence = 0;
+	uint64_t untilError = 0;
+	TrafficCounters counters;
+};
+}
+#endif
@@ -39,6 +39,12 @@ namespace translib
         using backingtype = uint8_t;
 
     public:
+        /**
+         * @brief The length of the bitfield in bits
+         *
+         */
+        static const size_t BIT_LENGTH = bitlength;
+
         /**
          * @brief The length of the bitfield in bytes
          *
@@ -84,11 +90,11 @@ namespace translib
          * @return T
          */
         template <typename T>
-        T GetData(const size_t bitstart, const size_t datalength) const
+        constexpr T GetData(const size_t bitstart, const size_t datalength) const
         {
             static_assert(sizeof(T) <= sizeof(backingtype), "The type of the backing array must be greater or equal the return type size");
             backingtype rawdata = storage[GetStorageLocationForBit(bitstart)];
-            backingtype mask;
+            backingtype mask = 0;
             size_t shift = 0;
             mask = CalculateBitMask(bitstart, datalength, shift);
             if constexpr (std::is_same<T, bool>::value)
@@ -101,6 +107,25 @@ namespace translib
             }
         }
 
+        /**
+         * @brief Get up to 64 bits starting at any bit, unlike GetData the bits may span several bytes.
+         *
+         * @param bitstart - The offset of the starting bit.
+         * @param datalength - Bitlength, at most 64.
+         * @return constexpr uint64_t
+         */
+        constexpr uint64_t GetBits(const size_t bitstart, const size_t datalength) const
+        {
+            assert(datalength <= 64 && bitstart + datalength <= bitlength);
+            uint64_t value = 0;
+            for (size_t i = 0; i < datalength; i++)
+            {
+                const size_t bit = bitstart + i;
+                value |= static_cast<uint64_t>((storage[bit / 8] >> (bit % 8)) & 1) << i;
+            }
+            return value;
+        }
+
         /**
          * @brief Write data to the bitfield.
          *
@@ -110,13 +135,13 @@ namespace translib
          * @param data
          */
         template <typename T>
-        void WriteData(const size_t bitstart, const size_t datalength, const T data)
+        constexpr void WriteData(const size_t bitstart, const size_t datalength, const T data)
         {
             static_assert(sizeof(T) <= sizeof(backingtype), "The type of the backing array must be greater or equal the return type size");
-            backingtype mask;
+            backingtype mask = 0;
             size_t shift = 0;
             mask = CalculateBitMask(bitstart, datalength, shift);
-            T maskedData;
+            T maskedData = 0;
             if constexpr (std::is_same<T, bool>::value)
             {
                 maskedData = (data ? 1 : 0) & (mask >> shift);
@@ -129,6 +154,20 @@ namespace translib
             storage[GetStorageLocationForBit(bitstart)] |= maskedData << shift; // Set bits with new data
         }
 
+        /**
+         * @brief Get a byte of the serialized bitfield.
+         *
+         * This is the constexpr counterpart of BuildPacket and could be used in constant expressions.
+         *
+         * @param index - Byte index, must be less than BYTE_LENGTH.
+         * @return constexpr uint8_t
+         */
+        constexpr uint8_t GetSerializedByte(const size_t index) const
+        {
+            static_assert(sizeof(backingtype) == 1, "Only byte sized backing types are supported");
+            return storage[index];
+        }
+
         /**
          * @brief Serialize this packet to the supplied iterator
          *
@@ -201,5 +240,54 @@ namespace translib
         }
         backingtype storage[CalculateArrayLength(BYTE_LENGTH)] = {0};
     };
+
+    /**
+     * @brief Description of a sub-field of a bitfield for exporters and generators.
+     *
+     * A class derived from a Bitfield could list its sub-fields in a static member named Members:
+     * static constexpr std::array<BitfieldMember, 1> Members = {{{"TestBit", TestBit_Offset, TestBit_Length}}};
+     *
+     */
+    struct BitfieldMember
+    {
+        const char *name;
+        size_t offset;
+        size_t length;
+    };
+
+    namespace bitfield_helper
+    {
+        template <const size_t bitlength>
+        std::true_type is_bitfield_test(const Bitfield<bitlength> *);
+        std::false_type is_bitfield_test(...);
+    }
+
+    /**
+     * @brief is_bitfield<T>::value is true if T is a Bitfield or a class derived from a Bitfield.
+     *
+     * @tparam T
+     */
+    template <typename T>
+    struct is_bitfield : decltype(bitfield_helper::is_bitfield_test(static_cast<T *>(nullptr)))
+    {
+    };
+
+    template <typename T>
+    inline constexpr bool is_bitfield_v = is_bitfield<T>::value;
+
+    /**
+     * @brief has_bitfield_members<T>::value is true if T lists its sub-fields in a static member Members.
+     *
+     * @tparam T
+     */
+    template <typename T, typename = void>
+    struct has_bitfield_members : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct has_bitfield_members<T, std::void_t<decltype(T::Members)>> : std::true_type
+    {
+    };
 }
 #endif
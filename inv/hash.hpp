@@ -0,0 +1,60 @@
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#ifndef HASH_HPP__
+#define HASH_HPP__
+
+namespace translib
+{
+namespace utils
+{
+/**
+ * @brief Final mixing step of the 64 bit hash, spreads every input bit over the whole result.
+ *
+ * @param h
+ * @return constexpr uint64_t
+ */
+static inline constexpr uint64_t hashMix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/**
+ * @brief Fast non cryptographic 64 bit hash over a byte buffer.
+ *
+ * The buffer is consumed in 8 byte words, so the cost is roughly one multiplication per 8 bytes.
+ * The result only depends on the byte values, not on the alignment of the buffer.
+ *
+ * @param data
+ * @param length
+ * @param seed
+ * @return uint64_t
+ */
+static inline uint64_t hashBytes(const uint8_t *data, size_t length, uint64_t seed = 0)
+{
+	const uint64_t prime = 0x9e3779b97f4a7c15ULL;
+	uint64_t h = seed ^ (length * prime);
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, &data[i], sizeof(word));
+		h = (h ^ hashMix(word)) * prime;
+	}
+	uint64_t tail = 0;
+	for (size_t shift = 0; i < length; i++, shift += 8)
+	{
+		tail |= static_cast<uint64_t>(data[i]) << shift;
+	}
+	h = (h ^ hashMix(tail)) * prime;
+	return hashMix(h);
+}
+}
+}
+#endif
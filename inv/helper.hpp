@@ -1,5 +1,7 @@
 #include <cstdint>
+#include <cstddef>
 #include <tuple>
+#include <utility>
 #include <type_traits>
 #include "bitfield.hpp"
 
@@ -8,6 +10,12 @@
 
 namespace translib
 {
+    /**
+     * @brief Size of a cache line, used to keep data of different threads apart.
+     *
+     */
+    static const size_t CACHE_LINE_SIZE = 64;
+
     /*********************
      * To check if tuple contains a specific type.
      * From: https://stackoverflow.com/questions/25958259/how-do-i-find-out-if-a-tuple-contains-a-type
@@ -17,18 +25,9 @@ namespace translib
         template <typename T, typename Tuple>
         struct has_type;
 
-        template <typename T>
-        struct has_type<T, std::tuple<>> : std::false_type
-        {
-        };
-
-        template <typename T, typename U, typename... Ts>
-        struct has_type<T, std::tuple<U, Ts...>> : has_type<T, std::tuple<Ts...>>
-        {
-        };
-
+        // A fold instead of a recursion over the tuple, so the compile time grows linear with the number of types
         template <typename T, typename... Ts>
-        struct has_type<T, std::tuple<T, Ts...>> : std::true_type
+        struct has_type<T, std::tuple<Ts...>> : std::integral_constant<bool, (std::is_same<T, Ts>::value || ...)>
         {
         };
 
@@ -40,6 +39,125 @@ namespace translib
          */
         template <typename T, typename Tuple>
         using tuple_contains_type = typename has_type<T, Tuple>::type;
+
+        /**
+         * @brief Index of the first occurrence of T in Ts, or sizeof...(Ts) if Ts doesn't contain T.
+         *
+         * @tparam T
+         * @tparam Ts
+         * @return constexpr size_t
+         */
+        template <typename T, typename... Ts>
+        constexpr size_t type_index()
+        {
+            size_t index = 0;
+            bool found = false;
+            ((found = found || std::is_same<T, Ts>::value, index += found ? 0 : 1), ...);
+            return index;
+        }
+
+        /**
+         * @brief Storage of a single field in a FieldTuple.
+         *
+         * @tparam index - Index of the field, makes the base classes of a FieldTuple unique.
+         * @tparam T
+         */
+        template <size_t index, typename T>
+        struct FieldLeaf
+        {
+            T value{};
+        };
+
+        template <typename Indices, typename... T>
+        class FieldTupleImpl;
+
+        template <size_t... I, typename... T>
+        class FieldTupleImpl<std::index_sequence<I...>, T...> : public FieldLeaf<I, T>...
+        {
+        public:
+            constexpr FieldTupleImpl()
+            {
+            }
+
+            constexpr FieldTupleImpl(const T &...values) : FieldLeaf<I, T>{values}...
+            {
+            }
+
+            /**
+             * @brief Call function with references to all fields.
+             *
+             * @tparam Function
+             * @param function
+             * @return The result of the function.
+             */
+            template <typename Function>
+            constexpr decltype(auto) Apply(Function &&function)
+            {
+                return function(static_cast<FieldLeaf<I, T> &>(*this).value...);
+            }
+
+            template <typename Function>
+            constexpr decltype(auto) Apply(Function &&function) const
+            {
+                return function(static_cast<const FieldLeaf<I, T> &>(*this).value...);
+            }
+        };
+
+        template <size_t index, typename T>
+        T leaf_type(const FieldLeaf<index, T> &);
+    }
+
+    /**
+     * @brief Tuple of the fields of a packet.
+     *
+     * Unlike std::tuple, which is implemented as a recursion in the common standard libraries, every field is a direct base class and all fields
+     * are accessed with a single pack expansion. This keeps the compile time and the number of instantiated templates linear in the number
+     * of fields, also for packets with hundreds of fields. The fields are accessed with get<index>(tuple) or all at once with Apply.
+     *
+     * @tparam T
+     */
+    template <typename... T>
+    class FieldTuple : public tuple_helper::FieldTupleImpl<std::index_sequence_for<T...>, T...>
+    {
+        using Base = tuple_helper::FieldTupleImpl<std::index_sequence_for<T...>, T...>;
+
+    public:
+        using Base::Base;
+    };
+
+    /**
+     * @brief Get a field of a FieldTuple.
+     *
+     * @tparam index
+     * @tparam T - Deduced from the base class of the tuple.
+     * @param leaf
+     * @return T&
+     */
+    template <size_t index, typename T>
+    constexpr T &get(tuple_helper::FieldLeaf<index, T> &leaf) noexcept
+    {
+        return leaf.value;
+    }
+
+    template <size_t index, typename T>
+    constexpr const T &get(const tuple_helper::FieldLeaf<index, T> &leaf) noexcept
+    {
+        return leaf.value;
     }
 }
+
+// Tuple protocol, so FieldTuples could be used with structured bindings
+namespace std
+{
+    template <typename... T>
+    struct tuple_size<translib::FieldTuple<T...>> : std::integral_constant<size_t, sizeof...(T)>
+    {
+    };
+
+    template <size_t index, typename... T>
+    struct tuple_element<index, translib::FieldTuple<T...>>
+    {
+        using type = decltype(translib::tuple_helper::leaf_type<index>(std::declval<const translib::FieldTuple<T...> &>()));
+    };
+}
 #endif
\ No newline at end of file
@@ -0,0 +1,351 @@
+#include <cstddef>
+#include <cstdint>
+#if !defined(BASECOM_NO_SIMD)
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#endif
+
+#ifndef SIMD_HPP__
+#define SIMD_HPP__
+
+namespace translib
+{
+/**
+ * @brief Minimal wrappers of the vector instructions for doubles that are used by the monitoring and calibration classes.
+ *
+ * Every backend has the same static members, algorithms are written once as template over the backend. Native is the widest backend
+ * enabled by the compiler flags, Scalar is always available and used for the remainder of an array. Define BASECOM_NO_SIMD to use
+ * Scalar as Native.
+ *
+ * The comparisons are negated, so a NaN compares true and is never mistaken for a value within the limits.
+ */
+namespace simd
+{
+struct Scalar
+{
+	using Vector = double;
+	static constexpr size_t Width = 1;
+
+	static Vector Load(const double *values)
+	{
+		return *values;
+	}
+
+	static Vector Broadcast(double value)
+	{
+		return value;
+	}
+
+	static void Store(double *values, Vector vector)
+	{
+		*values = vector;
+	}
+
+	static Vector Add(Vector a, Vector b)
+	{
+		return a + b;
+	}
+
+	static Vector Subtract(Vector a, Vector b)
+	{
+		return a - b;
+	}
+
+	static Vector Multiply(Vector a, Vector b)
+	{
+		return a * b;
+	}
+
+	/**
+	 * @brief Minimum of every lane, b if one of them is NaN.
+	 *
+	 * @param a
+	 * @param b
+	 * @return Vector
+	 */
+	static Vector Min(Vector a, Vector b)
+	{
+		return a < b ? a : b;
+	}
+
+	/**
+	 * @brief Maximum of every lane, b if one of them is NaN.
+	 *
+	 * @param a
+	 * @param b
+	 * @return Vector
+	 */
+	static Vector Max(Vector a, Vector b)
+	{
+		return a > b ? a : b;
+	}
+
+	/**
+	 * @brief The lanes of result, or of input where input is NaN.
+	 *
+	 * @param result
+	 * @param input
+	 * @return Vector
+	 */
+	static Vector PropagateNaN(Vector result, Vector input)
+	{
+		return input != input ? input : result;
+	}
+
+	/**
+	 * @brief Bit mask of the lanes for which a >= b is false.
+	 *
+	 * @param a
+	 * @param b
+	 * @return unsigned
+	 */
+	static unsigned NotGreaterEqual(Vector a, Vector b)
+	{
+		return !(a >= b);
+	}
+
+	/**
+	 * @brief Bit mask of the lanes for which a <= b is false.
+	 *
+	 * @param a
+	 * @param b
+	 * @return unsigned
+	 */
+	static unsigned NotLessEqual(Vector a, Vector b)
+	{
+		return !(a <= b);
+	}
+};
+
+#if !defined(BASECOM_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64)
+struct Sse2
+{
+	using Vector = __m128d;
+	static constexpr size_t Width = 2;
+
+	static Vector Load(const double *values)
+	{
+		return _mm_loadu_pd(values);
+	}
+
+	static Vector Broadcast(double value)
+	{
+		return _mm_set1_pd(value);
+	}
+
+	static void Store(double *values, Vector vector)
+	{
+		_mm_storeu_pd(values, vector);
+	}
+
+	static Vector Add(Vector a, Vector b)
+	{
+		return _mm_add_pd(a, b);
+	}
+
+	static Vector Subtract(Vector a, Vector b)
+	{
+		return _mm_sub_pd(a, b);
+	}
+
+	static Vector Multiply(Vector a, Vector b)
+	{
+		return _mm_mul_pd(a, b);
+	}
+
+	static Vector Min(Vector a, Vector b)
+	{
+		return _mm_min_pd(a, b);
+	}
+
+	static Vector Max(Vector a, Vector b)
+	{
+		return _mm_max_pd(a, b);
+	}
+
+	static Vector PropagateNaN(Vector result, Vector input)
+	{
+		const Vector nan = _mm_cmpunord_pd(input, input);
+		return _mm_or_pd(_mm_and_pd(nan, input), _mm_andnot_pd(nan, result));
+	}
+
+	static unsigned NotGreaterEqual(Vector a, Vector b)
+	{
+		return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpnge_pd(a, b)));
+	}
+
+	static unsigned NotLessEqual(Vector a, Vector b)
+	{
+		return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpnle_pd(a, b)));
+	}
+};
+#endif
+
+#if defined(__AVX__)
+struct Avx
+{
+	using Vector = __m256d;
+	static constexpr size_t Width = 4;
+
+	static Vector Load(const double *values)
+	{
+		return _mm256_loadu_pd(values);
+	}
+
+	static Vector Broadcast(double value)
+	{
+		return _mm256_set1_pd(value);
+	}
+
+	static void Store(double *values, Vector vector)
+	{
+		_mm256_storeu_pd(values, vector);
+	}
+
+	static Vector Add(Vector a, Vector b)
+	{
+		return _mm256_add_pd(a, b);
+	}
+
+	static Vector Subtract(Vector a, Vector b)
+	{
+		return _mm256_sub_pd(a, b);
+	}
+
+	static Vector Multiply(Vector a, Vector b)
+	{
+		return _mm256_mul_pd(a, b);
+	}
+
+	static Vector Min(Vector a, Vector b)
+	{
+		return _mm256_min_pd(a, b);
+	}
+
+	static Vector Max(Vector a, Vector b)
+	{
+		return _mm256_max_pd(a, b);
+	}
+
+	static Vector PropagateNaN(Vector result, Vector input)
+	{
+		return _mm256_blendv_pd(result, input, _mm256_cmp_pd(input, input, _CMP_UNORD_Q));
+	}
+
+	static unsigned NotGreaterEqual(Vector a, Vector b)
+	{
+		return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_NGE_UQ)));
+	}
+
+	static unsigned NotLessEqual(Vector a, Vector b)
+	{
+		return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_NLE_UQ)));
+	}
+};
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+struct Neon
+{
+	using Vector = float64x2_t;
+	static constexpr size_t Width = 2;
+
+	static Vector Load(const double *values)
+	{
+		return vld1q_f64(values);
+	}
+
+	static Vector Broadcast(double value)
+	{
+		return vdupq_n_f64(value);
+	}
+
+	static void Store(double *values, Vector vector)
+	{
+		vst1q_f64(values, vector);
+	}
+
+	static Vector Add(Vector a, Vector b)
+	{
+		return vaddq_f64(a, b);
+	}
+
+	static Vector Subtract(Vector a, Vector b)
+	{
+		return vsubq_f64(a, b);
+	}
+
+	static Vector Multiply(Vector a, Vector b)
+	{
+		return vmulq_f64(a, b);
+	}
+
+	// vminq_f64 and vmaxq_f64 return NaN if one lane is NaN, the comparisons return b like the other backends
+	static Vector Min(Vector a, Vector b)
+	{
+		return vbslq_f64(vcltq_f64(a, b), a, b);
+	}
+
+	static Vector Max(Vector a, Vector b)
+	{
+		return vbslq_f64(vcgtq_f64(a, b), a, b);
+	}
+
+	static Vector PropagateNaN(Vector result, Vector input)
+	{
+		return vbslq_f64(vceqq_f64(input, input), result, input);
+	}
+
+	static unsigned NotGreaterEqual(Vector a, Vector b)
+	{
+		return Mask(vcgeq_f64(a, b));
+	}
+
+	static unsigned NotLessEqual(Vector a, Vector b)
+	{
+		return Mask(vcleq_f64(a, b));
+	}
+
+private:
+	static unsigned Mask(uint64x2_t compared)
+	{
+		return static_cast<unsigned>((~vgetq_lane_u64(compared, 0) & 1) | ((~vgetq_lane_u64(compared, 1) & 1) << 1));
+	}
+};
+#endif
+#endif
+
+#if defined(BASECOM_NO_SIMD)
+using Native = Scalar;
+#elif defined(__AVX__)
+using Native = Avx;
+#elif defined(__SSE2__) || defined(_M_X64)
+using Native = Sse2;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+using Native = Neon;
+#else
+using Native = Scalar;
+#endif
+
+/**
+ * @brief Spread the lowest 4 bits of a lane mask to the lowest bit of 4 bytes.
+ *
+ * @param mask
+ * @return uint32_t
+ */
+static inline uint32_t spreadMask(unsigned mask)
+{
+	static constexpr uint32_t table[16] = {
+		0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+		0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101 };
+	return table[mask & 0x0F];
+}
+}
+}
+#endif
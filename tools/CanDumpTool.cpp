@@ -0,0 +1,95 @@
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include "SocketCan.hpp"
+
+using namespace translib;
+
+/**
+ * Prints the packets received on a CAN interface, for example to watch a CanPacketTransport.
+ *
+ * basecom_candump [--fd] <interface>
+ *
+ * The frames are reassembled like in the CanPacketTransport, every completed packet is written to stdout as a line with the CAN
+ * identifier, the length and the data in hex. --fd receives CAN FD frames. The number of dropped frames is printed to stderr at the end.
+ */
+
+static volatile sig_atomic_t stopped = 0;
+
+static void HandleSignal(int)
+{
+    stopped = 1;
+}
+
+template<size_t frameLength>
+static int Dump(const char *interface, bool canfd)
+{
+    SocketCanBus<> bus;
+    if (!bus.Open(interface, canfd))
+    {
+        fprintf(stderr, "%s: %s\n", interface, strerror(errno));
+        return 1;
+    }
+    CanPacketTransport<SocketCanBus<>, 4095, 16, frameLength> transport(bus);
+    struct pollfd descriptor = {};
+    descriptor.fd = bus.GetFileDescriptor();
+    descriptor.events = POLLIN;
+    int ret = 0;
+    while (!stopped)
+    {
+        if (poll(&descriptor, 1, -1) < 0)
+        {
+            if (errno != EINTR)
+            {
+                fprintf(stderr, "poll: %s\n", strerror(errno));
+                ret = 1;
+                break;
+            }
+            continue;
+        }
+        transport.Poll([](uint32_t canid, const uint8_t *data, size_t length)
+        {
+            printf("%08x %4zu ", static_cast<unsigned int>(canid), length);
+            for (size_t i = 0; i < length; i++)
+            {
+                printf("%02x", data[i]);
+            }
+            printf("\n");
+        });
+        fflush(stdout);
+    }
+    fprintf(stderr, "{\"errors\":%llu}\n", static_cast<unsigned long long>(transport.GetErrorCount()));
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    bool canfd = false;
+    const char *interface = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--fd") == 0)
+        {
+            canfd = true;
+        }
+        else
+        {
+            interface = argv[i];
+        }
+    }
+    if (interface == nullptr)
+    {
+        fprintf(stderr, "usage: %s [--fd] <interface>\n", argv[0]);
+        return 2;
+    }
+
+    // Installed without SA_RESTART, so poll returns on a signal and the loop sees the stop
+    struct sigaction action = {};
+    action.sa_handler = HandleSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    return canfd ? Dump<64>(interface, true) : Dump<8>(interface, false);
+}
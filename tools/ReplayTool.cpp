@@ -0,0 +1,175 @@
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "CaptureReplay.hpp"
+
+using namespace translib;
+
+/**
+ * Replays a capture file into an ingest pipeline for load tests.
+ *
+ * basecom_replay [--speed=<factor>] [--loops=<n>] [--spin-us=<us>] [--udp=<ipv4>:<port> | --output=<path>] [--records] <capture>
+ *
+ * --speed=1 replays at the recorded pace (default), --speed=10 ten times faster and --speed=0 as fast as possible. The packets are
+ * written to stdout, a file or as one UDP datagram each. --records writes the capture record header in front of every packet.
+ * The achieved rate and the pacing error are printed as JSON object to stderr.
+ */
+
+static CaptureReplay *running = nullptr;
+
+static void HandleSignal(int)
+{
+    if (running != nullptr)
+    {
+        running->Stop();
+    }
+}
+
+static int OpenUdp(const char *destination)
+{
+    char address[64];
+    const char *colon = strrchr(destination, ':');
+    if (colon == nullptr || static_cast<size_t>(colon - destination) >= sizeof(address))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(address, destination, colon - destination);
+    address[colon - destination] = 0;
+    struct sockaddr_in target = {};
+    target.sin_family = AF_INET;
+    target.sin_port = htons(static_cast<uint16_t>(atoi(colon + 1)));
+    if (inet_pton(AF_INET, address, &target.sin_addr) != 1)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<struct sockaddr *>(&target), sizeof(target)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char **argv)
+{
+    double speed = 1.0;
+    size_t loops = 1;
+    uint64_t spin = 200;
+    const char *udp = nullptr;
+    const char *output = nullptr;
+    const char *path = nullptr;
+    bool records = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--speed=", 8) == 0)
+        {
+            speed = atof(argv[i] + 8);
+        }
+        else if (strncmp(argv[i], "--loops=", 8) == 0)
+        {
+            loops = strtoul(argv[i] + 8, nullptr, 10);
+        }
+        else if (strncmp(argv[i], "--spin-us=", 10) == 0)
+        {
+            spin = strtoull(argv[i] + 10, nullptr, 10);
+        }
+        else if (strncmp(argv[i], "--udp=", 6) == 0)
+        {
+            udp = argv[i] + 6;
+        }
+        else if (strncmp(argv[i], "--output=", 9) == 0)
+        {
+            output = argv[i] + 9;
+        }
+        else if (strcmp(argv[i], "--records") == 0)
+        {
+            records = true;
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+    if (path == nullptr || speed < 0)
+    {
+        fprintf(stderr, "usage: %s [--speed=<factor>] [--loops=<n>] [--spin-us=<us>] [--udp=<ipv4>:<port> | --output=<path>] [--records] <capture>\n",
+                argv[0]);
+        return 2;
+    }
+
+    MappedCapture capture;
+    if (!capture.Open(path))
+    {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    int fd = STDOUT_FILENO;
+    if (udp != nullptr)
+    {
+        fd = OpenUdp(udp);
+    }
+    else if (output != nullptr)
+    {
+        fd = open(output, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", udp != nullptr ? udp : output, strerror(errno));
+        return 1;
+    }
+
+    CaptureReplay replay(speed, spin * 1000);
+    running = &replay;
+    // Installed without SA_RESTART, so interrupted system calls return to the replay loop, which sees the stop
+    struct sigaction action = {};
+    action.sa_handler = HandleSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    // A closed pipe fails the write instead of terminating the process, so the report is still printed
+    signal(SIGPIPE, SIG_IGN);
+    FdSink sink(fd, records);
+    int error = 0;
+    const ReplayReport report = replay.Replay(capture.GetSegment(), [&](const PacketView &packet)
+    {
+        if (sink(packet))
+        {
+            return true;
+        }
+        // Nobody listens on the port yet, the datagram is lost like on the real link
+        if (udp != nullptr && errno == ECONNREFUSED)
+        {
+            return true;
+        }
+        error = errno;
+        return false;
+    }, loops);
+    running = nullptr;
+    if (error != 0)
+    {
+        fprintf(stderr, "write: %s\n", strerror(error));
+    }
+
+    fprintf(stderr,
+            "{\"packets\":%llu,\"bytes\":%llu,\"duration_s\":%.6f,\"packets_per_s\":%.6g,\"bytes_per_s\":%.6g,\"completed\":%s,"
+            "\"lateness_mean_ns\":%.0f,\"lateness_p50_ns\":%llu,\"lateness_p99_ns\":%llu,\"lateness_max_ns\":%llu}\n",
+            static_cast<unsigned long long>(report.packets), static_cast<unsigned long long>(report.bytes), report.duration / 1e9,
+            report.packetRate, report.byteRate, report.completed ? "true" : "false", report.lateness.Mean(),
+            static_cast<unsigned long long>(report.lateness.Percentile(50)), static_cast<unsigned long long>(report.lateness.Percentile(99)),
+            static_cast<unsigned long long>(report.lateness.Max()));
+    if (fd != STDOUT_FILENO)
+    {
+        close(fd);
+    }
+    return report.completed ? 0 : 1;
+}